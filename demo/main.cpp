@@ -14,10 +14,10 @@ int main()
         cosmodon::camera camera;
 
         // Prepare rendered objects.
-        cosmodon::model object, temp;
-        cosmodon::shape::pyramid(object, 0.1f, 0.3f);
-        //cosmodon::shape::rectangle(temp, 0.1f, 0.2f);
-        cosmodon::shape::triangle(temp, 0.2f);
+        cosmodon::model object, temp, outline;
+        cosmodon::generate::pyramid(object, 0.1f, 0.3f);
+        //cosmodon::generate::rectangle(temp, 0.1f, 0.2f);
+        cosmodon::generate::triangle(temp, 0.2f);
 
         temp.move(0, 0, -0.01f);
         object.add(temp);
@@ -33,6 +33,9 @@ int main()
             object[i] = test;
         }
 
+        // Outline rendered objects, drawing each edge once.
+        cosmodon::generate::wireframe(outline, object);
+
         // Camera view options.
         camera.set_position(0.0f, 0.0f, -0.1f);
         up = camera.get_position();
@@ -90,9 +93,7 @@ int main()
             window.clear(cosmodon::black);
 
             // Render shape outline.
-            //shape.set_scale(1);
-            object.set_fill(false);
-            window.draw(&object);
+            window.draw(&outline, object.get_matrix());
 
             // Render shape.
             //shape.set_scale(0.8);
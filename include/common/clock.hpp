@@ -37,7 +37,7 @@ namespace cosmodon
          *
          * If an invalid unit is given, returns 0.
          */
-        uint32_t elapsed(cosmodon::unit unit = cosmodon::unit::second, bool restart = false);
+        uint64_t elapsed(cosmodon::unit unit = cosmodon::unit::second, bool restart = false);
     };
 }
 
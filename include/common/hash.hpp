@@ -0,0 +1,35 @@
+#ifndef COSMODON_COMMON_HASH_HPP
+#define COSMODON_COMMON_HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace cosmodon
+{
+    namespace hash
+    {
+        // Initial value of an FNV-1a hash.
+        const uint64_t basis = 14695981039346656037ULL;
+
+        /**
+         * Hashes raw data with 64-bit FNV-1a.
+         *
+         * Pass a previous result as the basis to continue hashing across several pieces of data.
+         * Not suitable for security purposes.
+         */
+        uint64_t fnv(const void *data, size_t length, uint64_t value = basis);
+
+        /**
+         * Hashes a string with 64-bit FNV-1a.
+         */
+        uint64_t fnv(const std::string &data, uint64_t value = basis);
+
+        /**
+         * Formats a hash as 16 hexadecimal digits.
+         */
+        std::string hex(uint64_t value);
+    }
+}
+
+#endif
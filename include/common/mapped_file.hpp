@@ -0,0 +1,97 @@
+#ifndef COSMODON_COMMON_MAPPED_FILE_HPP
+#define COSMODON_COMMON_MAPPED_FILE_HPP
+
+#include <cstdint>
+#include <string>
+
+namespace cosmodon
+{
+    /**
+     * A read-only file, mapped into memory.
+     *
+     * Pages are read from disk on first access, and may be dropped again at any time, so files
+     * far larger than memory can be mapped whole. Hints let owners fetch pages ahead of use, and
+     * give them back once unused.
+     */
+    class mapped_file
+    {
+    public:
+        /**
+         * Hints about how a range of the file will be accessed.
+         */
+        enum class advice : uint8_t
+        {
+            normal,
+            sequential,
+            random,
+            need,
+            discard
+        };
+
+    protected:
+        // Mapped contents, or a null pointer when closed.
+        uint8_t *m_data;
+
+        // Length of the mapping, in bytes.
+        uint64_t m_size;
+
+        // File descriptor, or -1 when closed.
+        int m_descriptor;
+
+    public:
+        /**
+         * Constructor.
+         */
+        mapped_file();
+
+        /**
+         * Destructor.
+         *
+         * Unmaps the file, if open.
+         */
+        ~mapped_file();
+
+        mapped_file(const mapped_file &other) = delete;
+        mapped_file& operator=(const mapped_file &other) = delete;
+
+        /**
+         * Maps a file, closing any previously mapped file first.
+         *
+         * Throws an error if the file cannot be opened or mapped.
+         */
+        void open(const std::string &path);
+
+        /**
+         * Unmaps the file.
+         */
+        void close();
+
+        /**
+         * Checks if a file is mapped.
+         */
+        bool is_open() const;
+
+        /**
+         * Retrieves the mapped contents.
+         */
+        const uint8_t* data() const;
+
+        /**
+         * Retrieves the length of the file, in bytes.
+         */
+        uint64_t size() const;
+
+        /**
+         * Gives the kernel a hint about a range of the file. Ranges are widened to whole pages.
+         */
+        void advise(uint64_t offset, uint64_t length, advice hint) const;
+
+        /**
+         * Reads one byte of every page in a range, so that the range is resident when this
+         * returns.
+         */
+        void touch(uint64_t offset, uint64_t length) const;
+    };
+}
+
+#endif
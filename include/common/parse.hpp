@@ -0,0 +1,56 @@
+#ifndef COSMODON_COMMON_PARSE_HPP
+#define COSMODON_COMMON_PARSE_HPP
+
+#include <cstdint>
+#include "number.hpp"
+
+namespace cosmodon
+{
+    /**
+     * Fast parsing of text held in memory, such as mapped files.
+     *
+     * All functions work on a range from begin up to, not including, end, and never read past it.
+     * They do not depend on null termination or on the locale.
+     */
+    namespace parse
+    {
+        /**
+         * Parses a decimal real number, such as "-12.5e3", at the start of a range.
+         *
+         * Numbers with up to 19 significant digits and small exponents are converted exactly,
+         * eight digits at a time. Others keep their first 19 digits, scaled in long double.
+         *
+         * @return  Pointer past the number, or a null pointer if the range does not start with one.
+         */
+        const char* real(const char *begin, const char *end, number &value);
+
+        /**
+         * Parses a decimal integer, with an optional sign, at the start of a range.
+         *
+         * @return  Pointer past the integer, or a null pointer if the range does not start with one.
+         */
+        const char* integer(const char *begin, const char *end, int64_t &value);
+
+        /**
+         * Finds the first occurrence of a character, scanning sixteen bytes at a time where SSE2
+         * is available.
+         *
+         * @return  Pointer to the character, or end if not found.
+         */
+        const char* find(const char *begin, const char *end, char c);
+
+        /**
+         * Skips spaces and tabs.
+         */
+        const char* skip_space(const char *begin, const char *end);
+
+        /**
+         * Finds the start of the next line.
+         *
+         * @return  Pointer past the next newline, or end if there is none.
+         */
+        const char* next_line(const char *begin, const char *end);
+    }
+}
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef COSMODON_COMMON_POOL_HPP
+#define COSMODON_COMMON_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cosmodon
+{
+    /**
+     * A pool of worker threads, which run batches of independent jobs.
+     *
+     * Threads are started once and sleep between batches. The thread calling run() takes part
+     * in the batch as thread 0, so a pool of size one runs everything on the caller.
+     */
+    class pool
+    {
+    public:
+        /**
+         * A job, given its index within the batch and the index of the thread running it.
+         */
+        typedef std::function<void(uint32_t job, uint8_t thread)> task;
+
+    protected:
+        // Worker threads, not including the calling thread.
+        std::vector<std::thread> m_threads;
+
+        // Guards batch hand-off between the caller and workers.
+        std::mutex m_mutex;
+
+        // Signals workers that a batch has started, or that the pool is stopping.
+        std::condition_variable m_start;
+
+        // Signals the caller that all workers have finished a batch.
+        std::condition_variable m_finish;
+
+        // Current batch.
+        task m_task;
+        uint32_t m_jobs;
+
+        // Index of the next unclaimed job in the current batch.
+        std::atomic<uint32_t> m_next;
+
+        // Batch counter, used by workers to notice a new batch.
+        uint64_t m_batch;
+
+        // Workers still busy with the current batch.
+        uint8_t m_busy;
+
+        // Whether the pool is shutting down.
+        bool m_stop;
+
+        /**
+         * Claims and runs jobs until the current batch is exhausted.
+         */
+        void work(uint8_t thread);
+
+        /**
+         * Worker thread loop.
+         */
+        void loop(uint8_t thread);
+
+    public:
+        /**
+         * Constructor.
+         *
+         * A thread count of zero uses one thread per hardware thread.
+         */
+        pool(uint8_t threads = 0);
+
+        /**
+         * Destructor.
+         *
+         * Stops and joins all worker threads.
+         */
+        ~pool();
+
+        /**
+         * Retrieves the amount of threads running jobs, including the calling thread.
+         */
+        uint8_t size() const;
+
+        /**
+         * Runs a batch of jobs across all threads, and waits for them to finish.
+         *
+         * Jobs may run in any order, on any thread. Batches must not be started from inside a
+         * job.
+         */
+        void run(uint32_t jobs, const task &function);
+    };
+}
+
+#endif
@@ -1,8 +1,10 @@
 #ifndef COSMODON_COMMON_RANDOM
 #define COSMODON_COMMON_RANDOM
 
+#include <cstdint>
 #include <ctime>
 #include <random>
+#include "number.hpp"
 
 namespace cosmodon
 {
@@ -29,6 +31,56 @@ namespace cosmodon
          * @returns  Integer between minimum and maximum values, inclusive.
          */
         uint32_t integer(uint32_t min, uint32_t max);
+
+        /**
+         * An independent, deterministic stream of random numbers.
+         *
+         * Streams with the same seed and sequence always produce the same numbers, regardless of
+         * what other streams do, so each thread or work item can own one. Uses PCG32.
+         */
+        class stream
+        {
+        protected:
+            // Generator state.
+            uint64_t m_state;
+
+            // Odd increment, selecting the sequence.
+            uint64_t m_increment;
+
+        public:
+            /**
+             * Constructor.
+             *
+             * @param  seed      Starting point within the sequence.
+             * @param  sequence  Sequence to draw numbers from.
+             */
+            stream(uint64_t seed = 0, uint64_t sequence = 0);
+
+            /**
+             * Generates a random 32-bit integer.
+             */
+            uint32_t integer();
+
+            /**
+             * Generates a random integer between minimum and maximum values, inclusive.
+             */
+            uint32_t integer(uint32_t min, uint32_t max);
+
+            /**
+             * Generates a random number in [0, 1).
+             */
+            number real();
+
+            /**
+             * Generates a random number in [min, max).
+             */
+            number real(number min, number max);
+
+            /**
+             * Generates a normally distributed random number, with mean 0 and deviation 1.
+             */
+            number normal();
+        };
     }
 }
 
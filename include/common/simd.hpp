@@ -0,0 +1,344 @@
+#ifndef COSMODON_COMMON_SIMD_HPP
+#define COSMODON_COMMON_SIMD_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include "number.hpp"
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+namespace cosmodon
+{
+    namespace simd
+    {
+        /**
+         * Four reals, processed together.
+         *
+         * Maps onto an SSE register where available, and onto plain arrays elsewhere, so code
+         * written against it runs everywhere. Members are defined here, since calls into other
+         * translation units would cost more than the operations themselves.
+         */
+        class float4
+        {
+        protected:
+#ifdef __SSE__
+            __m128 m_value;
+#else
+            number m_value[4];
+#endif
+
+        public:
+            /**
+             * Constructor, setting all four values to zero.
+             */
+            float4()
+            {
+#ifdef __SSE__
+                m_value = _mm_setzero_ps();
+#else
+                m_value[0] = m_value[1] = m_value[2] = m_value[3] = 0;
+#endif
+            }
+
+            /**
+             * Constructor, setting all four values to one value.
+             */
+            float4(number value)
+            {
+#ifdef __SSE__
+                m_value = _mm_set1_ps(value);
+#else
+                m_value[0] = m_value[1] = m_value[2] = m_value[3] = value;
+#endif
+            }
+
+            /**
+             * Constructor, setting each value.
+             */
+            float4(number x, number y, number z, number w)
+            {
+#ifdef __SSE__
+                m_value = _mm_setr_ps(x, y, z, w);
+#else
+                m_value[0] = x;
+                m_value[1] = y;
+                m_value[2] = z;
+                m_value[3] = w;
+#endif
+            }
+
+            /**
+             * Loads four consecutive values, without alignment requirements.
+             */
+            static float4 load(const number *source)
+            {
+                float4 result;
+#ifdef __SSE__
+                result.m_value = _mm_loadu_ps(source);
+#else
+                for (uint8_t i = 0; i < 4; i++) {
+                    result.m_value[i] = source[i];
+                }
+#endif
+                return result;
+            }
+
+            /**
+             * Stores four consecutive values, without alignment requirements.
+             */
+            void store(number *target) const
+            {
+#ifdef __SSE__
+                _mm_storeu_ps(target, m_value);
+#else
+                for (uint8_t i = 0; i < 4; i++) {
+                    target[i] = m_value[i];
+                }
+#endif
+            }
+
+            /**
+             * Arithmetic operators, per value.
+             */
+            friend float4 operator+(const float4 &lhs, const float4 &rhs)
+            {
+                float4 result;
+#ifdef __SSE__
+                result.m_value = _mm_add_ps(lhs.m_value, rhs.m_value);
+#else
+                for (uint8_t i = 0; i < 4; i++) {
+                    result.m_value[i] = lhs.m_value[i] + rhs.m_value[i];
+                }
+#endif
+                return result;
+            }
+
+            friend float4 operator-(const float4 &lhs, const float4 &rhs)
+            {
+                float4 result;
+#ifdef __SSE__
+                result.m_value = _mm_sub_ps(lhs.m_value, rhs.m_value);
+#else
+                for (uint8_t i = 0; i < 4; i++) {
+                    result.m_value[i] = lhs.m_value[i] - rhs.m_value[i];
+                }
+#endif
+                return result;
+            }
+
+            friend float4 operator*(const float4 &lhs, const float4 &rhs)
+            {
+                float4 result;
+#ifdef __SSE__
+                result.m_value = _mm_mul_ps(lhs.m_value, rhs.m_value);
+#else
+                for (uint8_t i = 0; i < 4; i++) {
+                    result.m_value[i] = lhs.m_value[i] * rhs.m_value[i];
+                }
+#endif
+                return result;
+            }
+
+            friend float4 operator/(const float4 &lhs, const float4 &rhs)
+            {
+                float4 result;
+#ifdef __SSE__
+                result.m_value = _mm_div_ps(lhs.m_value, rhs.m_value);
+#else
+                for (uint8_t i = 0; i < 4; i++) {
+                    result.m_value[i] = lhs.m_value[i] / rhs.m_value[i];
+                }
+#endif
+                return result;
+            }
+
+            /**
+             * Per value minimum and maximum.
+             */
+            friend float4 min(const float4 &lhs, const float4 &rhs)
+            {
+                float4 result;
+#ifdef __SSE__
+                result.m_value = _mm_min_ps(lhs.m_value, rhs.m_value);
+#else
+                for (uint8_t i = 0; i < 4; i++) {
+                    result.m_value[i] = (lhs.m_value[i] < rhs.m_value[i]) ? lhs.m_value[i] : rhs.m_value[i];
+                }
+#endif
+                return result;
+            }
+
+            friend float4 max(const float4 &lhs, const float4 &rhs)
+            {
+                float4 result;
+#ifdef __SSE__
+                result.m_value = _mm_max_ps(lhs.m_value, rhs.m_value);
+#else
+                for (uint8_t i = 0; i < 4; i++) {
+                    result.m_value[i] = (lhs.m_value[i] > rhs.m_value[i]) ? lhs.m_value[i] : rhs.m_value[i];
+                }
+#endif
+                return result;
+            }
+
+            /**
+             * Per value square root.
+             */
+            friend float4 sqrt(const float4 &value)
+            {
+                float4 result;
+#ifdef __SSE__
+                result.m_value = _mm_sqrt_ps(value.m_value);
+#else
+                for (uint8_t i = 0; i < 4; i++) {
+                    result.m_value[i] = std::sqrt(value.m_value[i]);
+                }
+#endif
+                return result;
+            }
+
+            /**
+             * Comparison operators, per value.
+             *
+             * Results are masks, with all bits of a value set where the comparison holds, for use
+             * with bitwise operators, select() and bits().
+             */
+            friend float4 operator<(const float4 &lhs, const float4 &rhs)
+            {
+                float4 result;
+#ifdef __SSE__
+                result.m_value = _mm_cmplt_ps(lhs.m_value, rhs.m_value);
+#else
+                for (uint8_t i = 0; i < 4; i++) {
+                    result.m_value[i] = mask(lhs.m_value[i] < rhs.m_value[i]);
+                }
+#endif
+                return result;
+            }
+
+            friend float4 operator<=(const float4 &lhs, const float4 &rhs)
+            {
+                float4 result;
+#ifdef __SSE__
+                result.m_value = _mm_cmple_ps(lhs.m_value, rhs.m_value);
+#else
+                for (uint8_t i = 0; i < 4; i++) {
+                    result.m_value[i] = mask(lhs.m_value[i] <= rhs.m_value[i]);
+                }
+#endif
+                return result;
+            }
+
+            friend float4 operator>(const float4 &lhs, const float4 &rhs)
+            {
+                return rhs < lhs;
+            }
+
+            friend float4 operator>=(const float4 &lhs, const float4 &rhs)
+            {
+                return rhs <= lhs;
+            }
+
+            /**
+             * Bitwise operators, per value.
+             */
+            friend float4 operator&(const float4 &lhs, const float4 &rhs)
+            {
+                float4 result;
+#ifdef __SSE__
+                result.m_value = _mm_and_ps(lhs.m_value, rhs.m_value);
+#else
+                for (uint8_t i = 0; i < 4; i++) {
+                    result.m_value[i] = combine(lhs.m_value[i], rhs.m_value[i], true);
+                }
+#endif
+                return result;
+            }
+
+            friend float4 operator|(const float4 &lhs, const float4 &rhs)
+            {
+                float4 result;
+#ifdef __SSE__
+                result.m_value = _mm_or_ps(lhs.m_value, rhs.m_value);
+#else
+                for (uint8_t i = 0; i < 4; i++) {
+                    result.m_value[i] = combine(lhs.m_value[i], rhs.m_value[i], false);
+                }
+#endif
+                return result;
+            }
+
+            /**
+             * Picks values from one of two sources, by mask.
+             *
+             * @param  mask   Comparison result, selecting values from the first source where set.
+             * @param  yes    Source of values where the mask is set.
+             * @param  no     Source of values where the mask is clear.
+             */
+            friend float4 select(const float4 &mask, const float4 &yes, const float4 &no)
+            {
+                float4 result;
+#ifdef __SSE__
+                result.m_value = _mm_or_ps(_mm_and_ps(mask.m_value, yes.m_value), _mm_andnot_ps(mask.m_value, no.m_value));
+#else
+                for (uint8_t i = 0; i < 4; i++) {
+                    result.m_value[i] = is_set(mask.m_value[i]) ? yes.m_value[i] : no.m_value[i];
+                }
+#endif
+                return result;
+            }
+
+            /**
+             * Collects the top bit of each value of a mask, the first value in the lowest bit.
+             */
+            uint8_t bits() const
+            {
+#ifdef __SSE__
+                return static_cast<uint8_t>(_mm_movemask_ps(m_value));
+#else
+                uint8_t result = 0;
+                for (uint8_t i = 0; i < 4; i++) {
+                    result |= is_set(m_value[i]) << i;
+                }
+                return result;
+#endif
+            }
+
+#ifndef __SSE__
+        protected:
+            /**
+             * Helpers emulating mask values without SSE.
+             */
+            static number mask(bool set)
+            {
+                uint32_t bits = set ? 0xffffffff : 0;
+                number result;
+                std::memcpy(&result, &bits, sizeof(result));
+                return result;
+            }
+
+            static bool is_set(number value)
+            {
+                uint32_t bits;
+                std::memcpy(&bits, &value, sizeof(bits));
+                return (bits >> 31) != 0;
+            }
+
+            static number combine(number lhs, number rhs, bool both)
+            {
+                uint32_t a, b;
+                std::memcpy(&a, &lhs, sizeof(a));
+                std::memcpy(&b, &rhs, sizeof(b));
+                a = both ? (a & b) : (a | b);
+                std::memcpy(&lhs, &a, sizeof(lhs));
+                return lhs;
+            }
+#endif
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,215 @@
+#ifndef COSMODON_COMMON_SLOT_MAP_HPP
+#define COSMODON_COMMON_SLOT_MAP_HPP
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "exception.hpp"
+
+namespace cosmodon
+{
+    /**
+     * A collection addressed by stable handles, stored densely.
+     *
+     * Handles combine a slot index with a generation, which changes whenever the slot is
+     * reused, so handles of removed values are recognized as stale instead of reaching a newer
+     * value. Slots reaching their last generation are retired for good instead of wrapping, so
+     * no handle is ever given out twice. This allows about four million values at once, and
+     * about four billion inserts over the lifetime of a map.
+     *
+     * Values are kept contiguous by moving the last value into the place of a removed one, so
+     * iteration touches no gaps, and positions of values change on removal.
+     *
+     * Inserting, removing and looking up are constant time. Members are defined here, as
+     * templates are instantiated by users.
+     */
+    template <typename type>
+    class slot_map
+    {
+    public:
+        /**
+         * A stable reference to a value.
+         */
+        typedef uint32_t handle;
+
+        /**
+         * Handle meaning no value.
+         */
+        static const handle none = 0xffffffff;
+
+    protected:
+        // Bits of a handle holding the slot index. The remaining bits hold the generation.
+        static const uint8_t index_bits = 22;
+        static const uint32_t index_mask = (1u << index_bits) - 1;
+
+        // Last generation of a slot before it retires.
+        static const uint32_t last_generation = 0xffffffff >> index_bits;
+
+        // End of the free slot list. Slots stop short of it, so no handle equals none either.
+        static const uint32_t end = index_mask;
+
+        // Values, and the handle of each, by position.
+        std::vector<type> m_values;
+        std::vector<handle> m_handles;
+
+        // Position of the value in each slot, or the next free slot.
+        std::vector<uint32_t> m_slots;
+
+        // Current generation of each slot.
+        std::vector<uint32_t> m_generations;
+
+        // Free slots, oldest first, so slots rest as long as possible before reuse.
+        uint32_t m_free_first;
+        uint32_t m_free_last;
+
+    public:
+        /**
+         * Constructor.
+         */
+        slot_map()
+          : m_free_first(end), m_free_last(end)
+        {
+
+        }
+
+        /**
+         * Removes all values, and invalidates all handles.
+         */
+        void clear()
+        {
+            while (!m_handles.empty()) {
+                erase(m_handles.back());
+            }
+        }
+
+        /**
+         * Retrieves the amount of values.
+         */
+        uint32_t size() const
+        {
+            return m_values.size();
+        }
+
+        /**
+         * Adds a value. Throws an error once every slot is in use or retired.
+         *
+         * @return  Handle of the value.
+         */
+        handle insert(type value)
+        {
+            uint32_t slot = m_free_first;
+            if (slot != end) {
+                m_free_first = m_slots[slot];
+                if (m_free_first == end) {
+                    m_free_last = end;
+                }
+            } else {
+                if (m_slots.size() >= end) {
+                    throw exception::error("Slot map is out of slots");
+                }
+                slot = m_slots.size();
+                m_slots.push_back(0);
+                m_generations.push_back(0);
+            }
+
+            handle result = (m_generations[slot] << index_bits) | slot;
+            m_slots[slot] = m_values.size();
+            m_values.push_back(std::move(value));
+            m_handles.push_back(result);
+            return result;
+        }
+
+        /**
+         * Checks if a handle refers to a value.
+         */
+        bool contains(handle h) const
+        {
+            uint32_t slot = h & index_mask;
+            return h != none && slot < m_slots.size() && m_generations[slot] == (h >> index_bits) &&
+              m_slots[slot] < m_values.size() && m_handles[m_slots[slot]] == h;
+        }
+
+        /**
+         * Removes a value, moving the last value into its position.
+         *
+         * Stale handles are ignored.
+         */
+        void erase(handle h)
+        {
+            if (!contains(h)) {
+                return;
+            }
+            uint32_t slot = h & index_mask;
+            uint32_t position = m_slots[slot];
+
+            // Fill the gap with the last value.
+            if (position != m_values.size() - 1) {
+                m_values[position] = std::move(m_values.back());
+                m_handles[position] = m_handles.back();
+                m_slots[m_handles[position] & index_mask] = position;
+            }
+            m_values.pop_back();
+            m_handles.pop_back();
+
+            // Free the slot at the end of the free list, unless another generation would wrap.
+            m_slots[slot] = end;
+            if (m_generations[slot] == last_generation) {
+                return;
+            }
+            m_generations[slot]++;
+            if (m_free_last == end) {
+                m_free_first = slot;
+            } else {
+                m_slots[m_free_last] = slot;
+            }
+            m_free_last = slot;
+        }
+
+        /**
+         * Retrieves the position of a value, or none for stale handles.
+         */
+        uint32_t get_position(handle h) const
+        {
+            return contains(h) ? m_slots[h & index_mask] : none;
+        }
+
+        /**
+         * Retrieves the handle of the value at a position.
+         */
+        handle get_handle(uint32_t position) const
+        {
+            return m_handles[position];
+        }
+
+        /**
+         * Retrieves a value by handle, or null for stale handles.
+         */
+        type* get(handle h)
+        {
+            return contains(h) ? &m_values[m_slots[h & index_mask]] : nullptr;
+        }
+
+        const type* get(handle h) const
+        {
+            return contains(h) ? &m_values[m_slots[h & index_mask]] : nullptr;
+        }
+
+        /**
+         * Retrieves a value by position.
+         */
+        type& operator[](uint32_t position)
+        {
+            return m_values[position];
+        }
+
+        const type& operator[](uint32_t position) const
+        {
+            return m_values[position];
+        }
+    };
+
+    template <typename type>
+    const typename slot_map<type>::handle slot_map<type>::none;
+}
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef COSMODON_COMMON_SORT_HPP
+#define COSMODON_COMMON_SORT_HPP
+
+#include <cstdint>
+#include "number.hpp"
+
+namespace cosmodon
+{
+    /**
+     * Sorting of large arrays by integer keys.
+     */
+    namespace sort
+    {
+        /**
+         * Converts a real number to an unsigned key which orders the same way, so reals can be
+         * radix sorted.
+         */
+        uint32_t key(number value);
+
+        /**
+         * Packs a key and an item, such as an index, into a single sortable value.
+         */
+        uint64_t pack(uint32_t key, uint32_t item);
+
+        /**
+         * Retrieves the item of a packed value.
+         */
+        uint32_t item(uint64_t packed);
+
+        /**
+         * Sorts packed values by key, in ascending order.
+         *
+         * Least significant digit radix sort, in three passes of 11 bits, all counted in a
+         * single read. Passes in which every key shares its digit are skipped. The sort is
+         * stable, so equal keys keep their order.
+         *
+         * @param  values   Values to sort.
+         * @param  count    Amount of values.
+         * @param  scratch  Storage for as many values, overwritten.
+         */
+        void radix(uint64_t *values, uint32_t count, uint64_t *scratch);
+    }
+}
+
+#endif
@@ -14,11 +14,15 @@
 #include "common/debug.hpp"
 #include "common/exception.hpp"
 #include "render/model.hpp"
+#include "render/animation.hpp"
+#include "render/catalog.hpp"
+#include "render/import.hpp"
 #include "physics/distance.hpp"
 #include "physics/physical.hpp"
 #include "render/primitive.hpp"
+#include "render/scene.hpp"
 #include "common/rate.hpp"
-#include "render/shape.hpp"
+#include "render/generate.hpp"
 #include "network/socket.hpp"
 #include "common/string.hpp"
 #include "render/vector.hpp"
@@ -2,6 +2,8 @@
 #define COSMODON_CAMERA_HPP
 
 #include "../component/position.hpp"
+#include "../render/frustum.hpp"
+#include "../render/ray.hpp"
 #include "../render/transformation.hpp"
 
 namespace cosmodon
@@ -33,6 +35,19 @@ namespace cosmodon
         // Current projection matrix.
         matrix m_projection;
 
+        // Matrices and planes derived from the view and projection, rebuilt on first use after
+        // either changes.
+        mutable bool m_dirty;
+        mutable matrix m_view_projection;
+        mutable matrix m_inverse_view;
+        mutable matrix m_inverse_view_projection;
+        mutable cosmodon::frustum m_frustum;
+
+        /**
+         * Rebuilds derived matrices and planes, if outdated.
+         */
+        void refresh() const;
+
     public:
         /**
          * Constructor.
@@ -56,6 +71,11 @@ namespace cosmodon
          */
         void set_fov(number fov);
 
+        /**
+         * Retrieves the vertical field of view, in degrees.
+         */
+        number get_fov() const;
+
         /**
          * Sets aspect ratio.
          *
@@ -118,6 +138,62 @@ namespace cosmodon
          * Retrieves the perspective matrix.
          */
         const matrix& get_projection() const;
+
+        /**
+         * Retrieves the projection matrix multiplied by the view matrix.
+         *
+         * This and the other derived retrievals are computed once per camera change. They
+         * update the camera on first use, so retrieve one before sharing a changed camera
+         * between threads.
+         */
+        const matrix& get_view_projection() const;
+
+        /**
+         * Retrieves the inverse of the view matrix, transforming from camera to world space.
+         */
+        const matrix& get_inverse_view() const;
+
+        /**
+         * Retrieves the inverse of the view-projection matrix, transforming from clip to world
+         * space.
+         */
+        const matrix& get_inverse_view_projection() const;
+
+        /**
+         * Retrieves the planes bounding what this camera sees.
+         */
+        const cosmodon::frustum& get_frustum() const;
+
+        /**
+         * Projects world points onto a screen.
+         *
+         * Results hold pixel coordinates from the top left corner in x and y, and depth from 0
+         * at the near plane to 1 at the far plane in z. Points behind the camera have a depth
+         * of -1. Four points are transformed at once, each axis of the four in its own lanes.
+         *
+         * @param  world   Points to project.
+         * @param  screen  Projected points, one per world point.
+         * @param  count   Amount of points.
+         * @param  width   Screen width, in pixels.
+         * @param  height  Screen height, in pixels.
+         */
+        void project(const vector *world, vector *screen, uint32_t count, number width, number height) const;
+
+        /**
+         * Unprojects screen points into world rays, starting on the near plane.
+         *
+         * @param  screen  Pixel coordinates from the top left corner. Depth is ignored.
+         * @param  rays    Resulting rays, one per screen point.
+         * @param  count   Amount of points.
+         * @param  width   Screen width, in pixels.
+         * @param  height  Screen height, in pixels.
+         */
+        void unproject(const vector *screen, ray *rays, uint32_t count, number width, number height) const;
+
+        /**
+         * Retrieves the world ray through one pixel.
+         */
+        ray get_ray(number x, number y, number width, number height) const;
     };
 }
 
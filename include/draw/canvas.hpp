@@ -38,6 +38,19 @@ namespace cosmodon
          */
         virtual void draw(const vertices *vertices, const transformation &transform);
 
+        /**
+         * Draw many copies of one collection of vertices.
+         *
+         * Each instance is drawn with its own transformation matrix, and optionally tinted by its
+         * own color, which is multiplied with the vertex colors. Pass a null pointer to leave
+         * instances untinted.
+         *
+         * By default, this draws each instance in turn through the primary method. Canvases able
+         * to draw instances in a single call should override it.
+         */
+        virtual void draw_instanced(const vertices *vertices, const matrix *transforms,
+          const color *colors, uint32_t count, bool fill = true);
+
         /**
          * Draw a graphic.
          *
@@ -45,6 +58,15 @@ namespace cosmodon
          */
         virtual void draw(const cosmodon::graphic *object);
 
+        /**
+         * Sets whether following draws are alpha blended.
+         *
+         * Blended draws test against the depth buffer, but do not write to it, so transparent
+         * geometry drawn back to front does not hide what lies behind it. Canvases which cannot
+         * blend ignore this.
+         */
+        virtual void set_blend(bool blend);
+
         /**
          * Clear the rendering area, using a color.
          *
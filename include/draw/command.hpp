@@ -0,0 +1,138 @@
+#ifndef COSMODON_DRAW_COMMAND_HPP
+#define COSMODON_DRAW_COMMAND_HPP
+
+#include <vector>
+#include "camera.hpp"
+#include "canvas.hpp"
+
+namespace cosmodon
+{
+    namespace draw
+    {
+        /**
+         * A recorded canvas operation.
+         */
+        struct command
+        {
+            // Possible operations.
+            enum class type : uint8_t
+            {
+                draw,
+                clear,
+            };
+
+            // Operation to perform.
+            type operation;
+
+            // Vertices to draw. Must outlive the command.
+            const vertices *source;
+
+            // Row-major transformation matrix values.
+            number transform[16];
+
+            // Fill mode.
+            bool fill;
+
+            // Whether the vertices are blended.
+            bool transparent;
+
+            // Clearing color.
+            color background;
+        };
+
+        /**
+         * A canvas which records draws instead of performing them.
+         *
+         * Graphics draw into a command list exactly as they draw into any other canvas, so lists
+         * can be filled away from the thread owning the real canvas, then executed on it later.
+         * Storage is kept between frames, so a reset list records without reallocating.
+         */
+        class command_list : public canvas
+        {
+        protected:
+            // Recorded commands.
+            std::vector<command> m_commands;
+
+            // Depth sorted order of commands, or empty for recorded order.
+            std::vector<uint64_t> m_order;
+
+            // Scratch storage for sorting, kept between frames.
+            std::vector<uint64_t> m_scratch;
+
+        public:
+            /**
+             * Forgets all recorded commands, keeping their storage for reuse.
+             */
+            void reset();
+
+            /**
+             * Retrieves the amount of recorded commands.
+             */
+            uint32_t size() const;
+
+            /**
+             * Inherit all drawing methods.
+             */
+            using canvas::draw;
+
+            /**
+             * Record a draw of a collection of vertices.
+             */
+            virtual void draw(const vertices *v, const matrix &transform, bool fill = true) override;
+
+            /**
+             * Record a clear of the drawing area.
+             */
+            virtual void clear(const color c = cosmodon::black) override;
+
+            /**
+             * Orders draws by depth from a camera, measured at the origin of each draw's
+             * transformation, until more commands are recorded. Draws never move across clears.
+             *
+             * Opaque draws come first, nearest first, so hidden fragments fail the depth test
+             * early. Transparent draws follow, farthest first, so they blend correctly. Only keys
+             * are moved, and they are radix sorted, so sorting takes linear time. Throws an error
+             * if more than 16,777,216 commands are recorded.
+             */
+            void sort(const camera &view);
+
+            /**
+             * Performs all recorded commands on a canvas, in depth order if sorted, or in
+             * recorded order otherwise.
+             *
+             * Blending is enabled for transparent draws only.
+             */
+            void execute(canvas *target) const;
+
+            /**
+             * Orders the commands of several lists as one, as sort() does for a single list.
+             *
+             * Lists follow each other in the given order. Each entry of the result packs a list
+             * index in its top 8 bits and a command index in its lower 24 bits, as the item of a
+             * sort key. Throws an error if there are more than 256 lists, or a list holds more
+             * than 16,777,216 commands.
+             *
+             * @param  lists    Lists to order.
+             * @param  count    Amount of lists, at most 256.
+             * @param  view     Camera to measure depth from.
+             * @param  order    Resulting order.
+             * @param  scratch  Scratch storage for sorting.
+             */
+            static void sort(const command_list *lists, uint32_t count, const camera &view,
+              std::vector<uint64_t> &order, std::vector<uint64_t> &scratch);
+
+            /**
+             * Performs the commands of several lists in an order made by sort().
+             */
+            static void execute(const command_list *lists, const std::vector<uint64_t> &order, canvas *target);
+
+            /**
+             * Data access operators.
+             */
+            command& operator [](const uint32_t index);
+            const command& operator [](const uint32_t index) const;
+        };
+    }
+}
+
+#endif
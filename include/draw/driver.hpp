@@ -1,9 +1,11 @@
 #ifndef COSMODON_RENDER_DRIVER_HPP
 #define COSMODON_RENDER_DRIVER_HPP
 
+#include <string>
 #include "../common/rate.hpp"
 #include "shader.hpp"
 #include "canvas.hpp"
+#include "frame.hpp"
 
 namespace cosmodon
 {
@@ -19,7 +21,37 @@ namespace cosmodon
         protected:
             mutable rate m_fps;
 
+            // Frame being drawn, frame awaiting GPU timings, and latest complete frame.
+            frame_record m_current;
+            frame_record m_pending;
+            frame_record m_complete;
+
+            // Clocks measuring the current frame and pass.
+            clock m_frame_clock;
+            clock m_pass_clock;
+
+            // Whether a pass is open.
+            bool m_in_pass;
+
+            /**
+             * Counts a draw call towards the current frame and pass.
+             */
+            void count_draw(uint64_t vertices, uint64_t bytes);
+
+            /**
+             * Completes the current frame. Drivers call this when displaying.
+             *
+             * The previously pending frame becomes the complete frame, and the current frame
+             * waits for its GPU timings in turn.
+             */
+            virtual void finish_frame();
+
         public:
+            /**
+             * Constructor.
+             */
+            driver();
+
             /**
              * Set shaders to be used when rendering.
              *
@@ -38,6 +70,26 @@ namespace cosmodon
              * Retrieve frames per second.
              */
             virtual uint32_t get_fps() const;
+
+            /**
+             * Begins a named pass, timing everything drawn until the pass ends.
+             *
+             * Passes cannot nest. Beginning a pass ends any open pass.
+             */
+            virtual void begin_pass(const std::string &name);
+
+            /**
+             * Ends the open pass.
+             */
+            virtual void end_pass();
+
+            /**
+             * Retrieves statistics of the latest complete frame.
+             *
+             * Statistics lag one frame behind display, so GPU timings can be collected without
+             * waiting for the GPU.
+             */
+            const frame_record& get_frame() const;
         };
     }
 }
@@ -0,0 +1,77 @@
+#ifndef COSMODON_DRAW_ENCODER_HPP
+#define COSMODON_DRAW_ENCODER_HPP
+
+#include <functional>
+#include "../common/pool.hpp"
+#include "command.hpp"
+
+namespace cosmodon
+{
+    namespace draw
+    {
+        /**
+         * Encodes the draws of many graphics in parallel.
+         *
+         * The scene is split into contiguous, disjoint ranges, one per pool thread. Each thread
+         * culls and records its range into its own command list, so no locking is needed.
+         * Executing the encoder replays the lists in range order, which matches the order the
+         * graphics were given in.
+         */
+        class encoder
+        {
+        public:
+            /**
+             * Decides whether a graphic should be drawn. Called from worker threads.
+             */
+            typedef std::function<bool(const graphic *object)> filter;
+
+        protected:
+            // Threads encoding the scene.
+            pool &m_pool;
+
+            // One command list per range.
+            std::vector<command_list> m_lists;
+
+            // Depth order across all lists, or empty for scene order.
+            std::vector<uint64_t> m_order;
+
+            // Scratch storage for sorting.
+            std::vector<uint64_t> m_scratch;
+
+        public:
+            /**
+             * Constructor.
+             */
+            encoder(pool &workers);
+
+            /**
+             * Encodes a scene of graphics, replacing any previously encoded scene.
+             *
+             * Graphics rejected by the visibility filter are skipped. A null filter draws
+             * everything. Graphics must not be modified while they are being encoded.
+             */
+            void encode(const graphic *const *objects, uint32_t count, const filter &visible = nullptr);
+
+            /**
+             * Orders all encoded commands by depth from a camera, as one list.
+             *
+             * See command_list::sort(). Execution then follows depth order, until the next encode.
+             */
+            void sort(const camera &view);
+
+            /**
+             * Retrieves the amount of encoded commands.
+             */
+            uint32_t size() const;
+
+            /**
+             * Performs all encoded commands on a canvas, in scene order, or depth order if sorted.
+             *
+             * Must be called from the thread owning the canvas.
+             */
+            void execute(canvas *target) const;
+        };
+    }
+}
+
+#endif
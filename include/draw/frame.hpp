@@ -0,0 +1,68 @@
+#ifndef COSMODON_DRAW_FRAME_HPP
+#define COSMODON_DRAW_FRAME_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace cosmodon
+{
+    namespace draw
+    {
+        /**
+         * Drawing statistics of one named pass within a frame.
+         *
+         * Times are in nanoseconds.
+         */
+        struct pass_record
+        {
+            // Name given when the pass began.
+            std::string name;
+
+            // Time spent submitting the pass on the CPU.
+            uint64_t cpu_time;
+
+            // Time spent executing the pass on the GPU, or zero if it is unknown.
+            uint64_t gpu_time;
+
+            // Draw calls, vertices uploaded, and bytes uploaded during the pass.
+            uint32_t draws;
+            uint64_t vertices;
+            uint64_t bytes;
+        };
+
+        /**
+         * Drawing statistics of one frame.
+         *
+         * Times are in nanoseconds.
+         */
+        struct frame_record
+        {
+            // Frame number, counting displayed frames.
+            uint64_t frame;
+
+            // Time between the start of the frame and its display, on the CPU.
+            uint64_t cpu_time;
+
+            // Draw calls, vertices uploaded, and bytes uploaded during the whole frame.
+            uint32_t draws;
+            uint64_t vertices;
+            uint64_t bytes;
+
+            // Passes, in the order they began.
+            std::vector<pass_record> passes;
+
+            /**
+             * Constructor.
+             */
+            frame_record();
+
+            /**
+             * Resets statistics, keeping pass storage.
+             */
+            void reset(uint64_t number);
+        };
+    }
+}
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef COSMODON_RENDER_OPENGL_HPP
 #define COSMODON_RENDER_OPENGL_HPP
 
+#include <vector>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
@@ -14,7 +15,46 @@ namespace cosmodon
      */
     class opengl : public draw::driver
     {
+    public:
+        /**
+         * Build status of a queued shader program.
+         */
+        enum class program_status : uint8_t
+        {
+            pending,
+            ready,
+            failed,
+        };
+
     protected:
+        /**
+         * A shader program being built, or built, by the driver.
+         */
+        struct program
+        {
+            // OpenGL program object.
+            GLuint object;
+
+            // Shader sources, and their OpenGL objects while they are being compiled.
+            std::vector<cosmodon::shader> sources;
+            std::vector<GLuint> shaders;
+
+            // Binary cache key, or zero when not cached.
+            uint64_t key;
+
+            // Whether the program was loaded from a cached binary.
+            bool cached;
+
+            // Build status.
+            program_status status;
+
+            // Compiler and linker output of a failed build.
+            std::string log;
+
+            // Whether the program was destroyed, and its handle is free for reuse.
+            bool deleted;
+        };
+
         // Total running OpenGL instances.
         static uint8_t m_instances;
 
@@ -27,12 +67,62 @@ namespace cosmodon
         // Buffer for vertex colors.
         GLuint m_colors;
 
+        // Buffer for vertex indices.
+        GLuint m_elements;
+
+        // Buffer for per-instance transformation matrices.
+        GLuint m_instance_transforms;
+
+        // Buffer for per-instance colors.
+        GLuint m_instance_colors;
+
+        // Scratch storage reused between draws, to avoid reallocating per draw.
+        std::vector<GLfloat> m_scratch;
+        std::vector<GLubyte> m_scratch_colors;
+
+        /**
+         * Vertices of many draws, merged into one draw.
+         */
+        struct batch
+        {
+            // Vertex positions, in world coordinates.
+            std::vector<GLfloat> positions;
+
+            // Vertex colors.
+            std::vector<GLubyte> colors;
+        };
+
+        // Batches of points and lines, indexed by primitive.
+        batch m_batches[2];
+
+        // Whether points and lines are batched.
+        bool m_batching;
+
+        // Size of drawn points, in pixels.
+        number m_point_size;
+
+        // Whether draws are alpha blended.
+        bool m_blend;
+
         // Vertex array objects.
         GLuint m_array;
 
-        // Shader program.
+        // Shader program currently in use.
         GLuint m_shader_program;
 
+        // Queued shader programs, indexed by handle, and handles of destroyed programs.
+        std::vector<program> m_programs;
+        std::vector<uint32_t> m_free_programs;
+
+        // Handle of the program set by set_shaders(), used while other programs are not ready.
+        uint32_t m_default_program;
+
+        // Whether the driver builds shader programs on its own threads.
+        bool m_parallel_compile;
+
+        // Directory of cached program binaries. Empty when caching is disabled.
+        std::string m_cache_directory;
+
         // Width and height of the rendering viewport.
         uint16_t m_width;
         uint16_t m_height;
@@ -40,12 +130,88 @@ namespace cosmodon
         // Current rendering camera.
         const camera *m_camera;
 
+        // Timer queries of passes, for even and odd frames.
+        std::vector<GLuint> m_queries[2];
+
         /**
-         * Compiles a shader.
+         * Creates a shader, and starts compiling it without waiting for the result.
          *
          * Returns an OpenGL shader object, which should be destroyed when no longer needed.
          */
-        GLuint compile_shader(cosmodon::shader *shader);
+        GLuint create_shader(const cosmodon::shader &source);
+
+        /**
+         * Starts building a shader program from source, without waiting for the result.
+         */
+        void start_program(program &record);
+
+        /**
+         * Checks whether a pending shader program has finished building.
+         *
+         * If wait is false and the driver compiles in parallel, a program still being built is
+         * left pending instead of blocking. Rejected cached binaries are rebuilt from source.
+         */
+        void resolve_program(program &record, bool wait);
+
+        /**
+         * Computes the cache key of a shader program.
+         *
+         * The key covers shader sources and the driver vendor, renderer, and version, so
+         * binaries are never offered to a different driver.
+         */
+        uint64_t program_key(shader *vertex, shader *fragment) const;
+
+        /**
+         * Starts loading a shader program from the binary cache.
+         *
+         * Returns zero if the program is not cached. The driver may still reject the binary,
+         * which shows as a link failure.
+         */
+        GLuint load_program(uint64_t key);
+
+        /**
+         * Stores a linked shader program in the binary cache.
+         *
+         * Failures are ignored, since the program will simply be compiled next time.
+         */
+        void store_program(uint64_t key, GLuint program);
+
+        /**
+         * Uploads vertex positions and colors, and points the vertex array at them.
+         *
+         * Positions are three floats per vertex, and colors are four bytes per vertex.
+         */
+        void upload(const GLfloat *positions, const GLubyte *colors, uint32_t count);
+
+        /**
+         * Uploads a collection of vertices, and points the vertex array at them.
+         */
+        void upload(const vertices *v);
+
+        /**
+         * Sets identity instance matrices and no tint, for draws without instance arrays.
+         */
+        void set_instance_defaults();
+
+        /**
+         * Appends points or lines to their batch, transformed into world coordinates.
+         *
+         * Transformations are assumed to be affine.
+         */
+        void append(const vertices *v, const matrix &transform);
+
+        /**
+         * Uploads the model, view, and projection matrices to the shader program.
+         */
+        void set_uniforms(const matrix &transform);
+
+        /**
+         * Completes the current frame, collecting GPU timings of the pending frame.
+         *
+         * Timings are only collected if the GPU has already produced them, so this never stalls.
+         * Passes whose timings are not ready in time report a GPU time of zero.
+         */
+        virtual void finish_frame() override;
 
     public:
         /**
@@ -78,6 +244,42 @@ namespace cosmodon
          */
         virtual void draw(const vertices *v, const matrix &transform, bool fill = true) override;
 
+        /**
+         * Sets whether points and lines are batched.
+         *
+         * Batched points and lines are merged with all other points or lines drawn until the
+         * next flush, and drawn in a single call per primitive. Enabled by default.
+         */
+        void set_batching(bool batching);
+
+        /**
+         * Sets whether following draws are alpha blended, flushing batches first.
+         */
+        virtual void set_blend(bool blend) override;
+
+        /**
+         * Sets the size of drawn points, in pixels.
+         */
+        void set_point_size(number size);
+
+        /**
+         * Draws all batched points and lines.
+         *
+         * Batches are flushed automatically before displaying, clearing, beginning or ending a
+         * pass, and changing the camera, shader program, or point size.
+         */
+        void flush();
+
+        /**
+         * Render many copies of a collection of vertices in a single draw call.
+         *
+         * Vertices are uploaded once, and instance transformations and colors are streamed as
+         * instanced vertex attributes. Shaders must declare the "instance_model" matrix at
+         * location 2 and the "instance_color" vector at location 6, like the default shader.
+         */
+        virtual void draw_instanced(const vertices *v, const matrix *transforms, const color *colors,
+          uint32_t count, bool fill = true) override;
+
         /**
          * Sets view transformation.
          */
@@ -89,10 +291,67 @@ namespace cosmodon
         virtual void display() override;
 
         /**
-         * Sets shaders.
+         * Begins a named pass, timed on the GPU with a GL_TIME_ELAPSED query.
+         */
+        virtual void begin_pass(const std::string &name) override;
+
+        /**
+         * Ends the open pass.
+         */
+        virtual void end_pass() override;
+
+        /**
+         * Sets shaders, building them before returning.
+         *
+         * The resulting program becomes the fallback for queued programs which are not ready.
          */
         virtual bool set_shaders(shader *vertex = nullptr, shader *fragment = nullptr, shader *geometry = nullptr) override;
 
+        /**
+         * Queues a shader program to be built without blocking.
+         *
+         * Compiling and linking are only started, and finish in the background when the driver
+         * supports parallel shader compilation. Returns a handle to the program.
+         */
+        uint32_t queue_program(shader *vertex, shader *fragment);
+
+        /**
+         * Retrieves the build status of a queued shader program, without blocking when the
+         * driver compiles in parallel.
+         */
+        program_status get_program_status(uint32_t handle);
+
+        /**
+         * Retrieves the compiler and linker output of a failed shader program.
+         */
+        std::string get_program_log(uint32_t handle) const;
+
+        /**
+         * Uses a queued shader program for following draws.
+         *
+         * If the program is not ready yet, or failed to build, the program set by set_shaders()
+         * is used instead and false is returned.
+         */
+        bool use_program(uint32_t handle);
+
+        /**
+         * Destroys a queued shader program. Its handle is reused by later programs.
+         *
+         * Destroying the program set by set_shaders() leaves no fallback until shaders are set
+         * again.
+         */
+        void delete_program(uint32_t handle);
+
+        /**
+         * Sets the directory used to cache linked shader program binaries.
+         *
+         * The directory must already exist. Cached programs skip compiling and linking on later
+         * launches, and are rebuilt when the driver rejects them. Pass an empty string to
+         * disable caching, which is the default. Ignored if the driver cannot retrieve program
+         * binaries.
+         */
+        void set_program_cache(const std::string directory);
+
         /**
          * Set window title.
          */
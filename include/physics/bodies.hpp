@@ -0,0 +1,133 @@
+#ifndef COSMODON_PHYSICS_BODIES_HPP
+#define COSMODON_PHYSICS_BODIES_HPP
+
+#include <cstdint>
+#include <vector>
+#include "../render/vector.hpp"
+
+namespace cosmodon
+{
+    namespace physics
+    {
+        /**
+         * Methods of advancing bodies through time.
+         */
+        enum class integrator : uint8_t
+        {
+            // Semi-implicit Euler: velocity first, then position with the new velocity.
+            euler,
+
+            // Velocity Verlet: position from the current velocity and acceleration, then velocity
+            // from the average of the current acceleration and the next, once corrected.
+            verlet
+        };
+
+        /**
+         * Motion state of many bodies, stored as one array per component.
+         *
+         * Arrays are padded to a multiple of four, so integration handles four bodies at once
+         * without a remainder.
+         */
+        class bodies
+        {
+        protected:
+            // Amount of bodies.
+            uint32_t m_count;
+
+            // Components by axis.
+            std::vector<float> m_position[3];
+            std::vector<float> m_velocity[3];
+            std::vector<float> m_acceleration[3];
+
+            // Acceleration velocities were last advanced with, and the half step still owed,
+            // for Verlet integration.
+            std::vector<float> m_previous[3];
+            std::vector<float> m_half;
+
+            // One for bodies able to move, zero for static bodies.
+            std::vector<float> m_mobile;
+
+        public:
+            /**
+             * Constructor.
+             */
+            bodies();
+
+            /**
+             * Changes the amount of bodies. New bodies are static, at rest at the origin.
+             */
+            void resize(uint32_t count);
+
+            /**
+             * Retrieves the amount of bodies.
+             */
+            uint32_t size() const;
+
+            /**
+             * Sets the state of a body.
+             *
+             * @param  body          Body index.
+             * @param  position      Position.
+             * @param  velocity      Velocity.
+             * @param  acceleration  Acceleration.
+             * @param  is_static     Whether the body is unable to move.
+             * @param  restart       Whether to forget the step owed a correction, as for new
+             *                       bodies and bodies put to sleep.
+             */
+            void set(uint32_t body, const vector &position, const vector &velocity, const vector &acceleration,
+              bool is_static, bool restart = false);
+
+            /**
+             * Copies the state of one body over another, as when reordering bodies.
+             */
+            void move(uint32_t from, uint32_t to);
+
+            /**
+             * Retrieves the position of a body.
+             */
+            vector get_position(uint32_t body) const;
+
+            /**
+             * Retrieves the velocity of a body.
+             */
+            vector get_velocity(uint32_t body) const;
+
+            /**
+             * Checks if a body is static.
+             */
+            bool is_static(uint32_t body) const;
+
+            /**
+             * Retrieves component arrays by axis, for batch access.
+             */
+            float* get_positions(uint8_t axis);
+            float* get_velocities(uint8_t axis);
+            float* get_accelerations(uint8_t axis);
+
+            /**
+             * Advances a range of bodies through time, four at a time.
+             *
+             * @param  seconds  Time to pass.
+             * @param  method   Integration method.
+             * @param  first    First body, a multiple of four.
+             * @param  count    Amount of bodies.
+             */
+            void integrate(number seconds, integrator method, uint32_t first, uint32_t count);
+
+            /**
+             * Finishes the velocities of the last Verlet step from the current accelerations.
+             *
+             * Verlet integration advances velocities by the acceleration of the whole step, as
+             * if it stayed constant. Once accelerations are evaluated at the new positions, this
+             * swaps the second half of that for the new acceleration. Call it before reading
+             * velocities for the next step. Does nothing after Euler steps.
+             *
+             * @param  first  First body, a multiple of four.
+             * @param  count  Amount of bodies.
+             */
+            void correct(uint32_t first, uint32_t count);
+        };
+    }
+}
+
+#endif
@@ -1,14 +1,70 @@
 #ifndef COSMODON_PHYSICS_BOUNDARIES_BOX_HPP
 #define COSMODON_PHYSICS_BOUNDARIES_BOX_HPP
 
+#include "../boundary.hpp"
+#include "../hull.hpp"
+#include "../narrowphase.hpp"
+
 namespace cosmodon
 {
     namespace boundaries
     {
-        class box : public model
+        /**
+         * A box boundary, centered on its position.
+         *
+         * Boxes are compared by separating axes, and other models by the convex hulls of their
+         * vertices.
+         */
+        class box : public boundary
         {
+        protected:
+            // Corners, as a hull.
+            physics::hull m_hull;
+
+            // Size along each axis.
+            number m_width;
+            number m_height;
+            number m_depth;
+
         public:
-            void resize(number width, number height);
+            /**
+             * Constructor, for a box of no size.
+             */
+            box();
+
+            /**
+             * Changes the size of the box, and rebuilds its vertices.
+             *
+             * A depth of zero gives a flat rectangle.
+             */
+            void resize(number width, number height, number depth = 0);
+
+            /**
+             * Retrieves the box placed in the world.
+             */
+            physics::cuboid get_cuboid() const;
+
+            /**
+             * Retrieves the box placed in the world by the object it bounds.
+             *
+             * @param  placement  Transformation of the object, applied after the box's own.
+             */
+            physics::cuboid get_cuboid(const matrix &placement) const;
+
+            /**
+             * Retrieves the corners as a hull, in local space.
+             */
+            const physics::hull& get_hull() const;
+
+            /**
+             * Determines if this boundary intersects with a model.
+             */
+            virtual bool intersects(const model &other) const;
+
+            /**
+             * Determines if this boundary intersects with another boundary.
+             */
+            virtual bool intersects(const boundary &other) const;
         };
     }
 }
@@ -1,6 +1,8 @@
 #ifndef COSMODON_PHYSICS_BOUNDARY
 #define COSMODON_PHYSICS_BOUNDARY
 
+#include "../render/model.hpp"
+
 namespace cosmodon
 {
     /**
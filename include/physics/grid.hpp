@@ -0,0 +1,108 @@
+#ifndef COSMODON_PHYSICS_GRID_HPP
+#define COSMODON_PHYSICS_GRID_HPP
+
+#include <cstdint>
+#include <vector>
+#include "../common/pool.hpp"
+#include "../render/bounds.hpp"
+#include "sweep.hpp"
+
+namespace cosmodon
+{
+    namespace physics
+    {
+        /**
+         * A uniform grid broadphase, rebuilt from scratch on every update.
+         *
+         * Boxes are placed in the cell holding their center, and cells are hashed into a table
+         * sorted by counting, first into runs of buckets and then within each run, so the grid
+         * covers unbounded space with memory in proportion to the boxes, whatever the threads. Cells are at least as large as the largest box, so overlapping boxes always
+         * sit in the same or neighbouring cells. Each pair of cells is searched from one side
+         * only, so pairs are found once.
+         *
+         * Suits many similar, fast moving boxes, where rebuilding costs less than keeping a
+         * sorted structure up to date, and splits across threads without sharing.
+         */
+        class grid
+        {
+        public:
+            /**
+             * Two overlapping boxes, by index, the lower first.
+             */
+            typedef sweep::pair pair;
+
+        protected:
+            // Requested cell size, or zero to fit the largest box.
+            number m_requested;
+
+            // Cell size of the last build.
+            number m_cell_size;
+
+            // Cell coordinates of each box.
+            std::vector<int32_t> m_cells;
+
+            // Bucket count less one, masking hashes.
+            uint32_t m_mask;
+
+            // Bucket of each box.
+            std::vector<uint32_t> m_buckets;
+
+            // Boxes sorted by bucket, and where each bucket starts, with the end last.
+            std::vector<uint32_t> m_sorted;
+            std::vector<uint32_t> m_starts;
+
+            // Segment counts of each job, turned into write offsets, and where each segment
+            // starts, with the end last. Segments are runs of buckets sorted independently.
+            std::vector<uint32_t> m_counts;
+            std::vector<uint32_t> m_segments;
+
+            // Boxes grouped by segment, and write offsets of each bucket.
+            std::vector<uint32_t> m_grouped;
+            std::vector<uint32_t> m_next;
+
+            // Pairs found by each job, then all pairs.
+            std::vector<std::vector<pair>> m_found;
+            std::vector<pair> m_pairs;
+
+            /**
+             * Finds the bucket of a cell.
+             */
+            uint32_t get_bucket(int32_t x, int32_t y, int32_t z) const;
+
+        public:
+            /**
+             * Constructor.
+             */
+            grid();
+
+            /**
+             * Sets the cell size, or zero to fit cells to the largest box on each build.
+             *
+             * Cells never shrink below the largest box. Cells near twice the typical box size
+             * keep few boxes per cell while searching few cells.
+             */
+            void set_cell_size(number size);
+
+            /**
+             * Retrieves the cell size used by the last build.
+             */
+            number get_cell_size() const;
+
+            /**
+             * Sorts boxes into cells and finds all overlapping pairs.
+             *
+             * @param  boxes    Boxes, none of them empty.
+             * @param  count    Amount of boxes.
+             * @param  threads  Pool to split work across, or null.
+             */
+            void build(const bounds *boxes, uint32_t count, pool *threads = nullptr);
+
+            /**
+             * Retrieves overlapping pairs of the last build, in no particular order.
+             */
+            const std::vector<pair>& get_pairs() const;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef COSMODON_PHYSICS_HULL_HPP
+#define COSMODON_PHYSICS_HULL_HPP
+
+#include <cstdint>
+#include <vector>
+#include "../render/vector.hpp"
+#include "../render/vertices.hpp"
+
+namespace cosmodon
+{
+    namespace physics
+    {
+        /**
+         * The convex hull of a set of points, reduced to its corners.
+         *
+         * Collision tests only need the point furthest along a direction, which always lies on
+         * a corner of the hull, so keeping corners alone makes each lookup touch far fewer
+         * points than the full mesh. Built once per mesh and kept while the mesh is unchanged.
+         */
+        class hull
+        {
+        protected:
+            // Corners, as one array per axis.
+            std::vector<float> m_points[3];
+
+        public:
+            /**
+             * Builds the hull of local vertex positions, ignoring transformation.
+             *
+             * Flat or degenerate sets keep all distinct points, which still give correct lookups.
+             */
+            void build(const vertices &source);
+
+            /**
+             * Builds the hull of points.
+             */
+            void build(const vector *points, uint32_t count);
+
+            /**
+             * Removes all points.
+             */
+            void clear();
+
+            /**
+             * Checks if the hull has no points.
+             */
+            bool is_empty() const;
+
+            /**
+             * Retrieves the amount of corners.
+             */
+            uint32_t size() const;
+
+            /**
+             * Retrieves a corner.
+             */
+            vector get_point(uint32_t index) const;
+
+            /**
+             * Retrieves the corner furthest along a direction.
+             */
+            vector support(const vector &direction) const;
+        };
+    }
+}
+
+#endif
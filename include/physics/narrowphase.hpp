@@ -0,0 +1,148 @@
+#ifndef COSMODON_PHYSICS_NARROWPHASE_HPP
+#define COSMODON_PHYSICS_NARROWPHASE_HPP
+
+#include "../render/bounds.hpp"
+#include "../render/matrix.hpp"
+#include "../render/vector.hpp"
+#include "hull.hpp"
+
+namespace cosmodon
+{
+    namespace physics
+    {
+        /**
+         * How two overlapping shapes touch.
+         */
+        struct contact
+        {
+            // Direction from the first shape towards the second, of unit length. Moving the
+            // second shape along it by the depth separates them.
+            vector normal;
+
+            // Overlap along the normal.
+            number depth;
+
+            // Deepest point of each shape inside the other.
+            vector on_first;
+            vector on_second;
+
+            // Point midway between the deepest points.
+            vector point;
+        };
+
+        /**
+         * A hull placed in the world by a transformation.
+         *
+         * Keeps a reference to the hull, which must outlive it.
+         */
+        class convex
+        {
+        protected:
+            // Hull in local space.
+            const hull *m_hull;
+
+            // Linear part of the transformation, by row, and its translation.
+            float m_linear[9];
+            float m_offset[3];
+
+        public:
+            /**
+             * Constructor.
+             *
+             * @param  shape      Hull in local space, which must not be empty.
+             * @param  transform  Transformation from local to world space.
+             */
+            convex(const hull &shape, const matrix &transform);
+
+            /**
+             * Retrieves the world point of the shape furthest along a direction.
+             */
+            vector support(const vector &direction) const;
+
+            /**
+             * Retrieves the world position of the local origin, a point near the shape.
+             */
+            vector get_origin() const;
+
+            /**
+             * Moves the shape in world space.
+             */
+            void translate(const vector &offset);
+        };
+
+        /**
+         * A box placed in the world, as a center, unit axes and half sizes along them.
+         */
+        struct cuboid
+        {
+            vector center;
+            vector axes[3];
+            number half[3];
+
+            /**
+             * Constructor, for an empty box at the origin.
+             */
+            cuboid();
+
+            /**
+             * Constructor, from a local box and its transformation.
+             *
+             * Exact for rotations with uniform scale. Scaling a rotated box unevenly shears it,
+             * which is approximated by the box along the transformed local axes.
+             */
+            cuboid(const bounds &local, const matrix &transform);
+        };
+
+        /**
+         * Finds the distance between two shapes, by GJK.
+         *
+         * @param  on_first   Closest point on the first shape.
+         * @param  on_second  Closest point on the second shape.
+         *
+         * @return  Distance between the shapes, or zero if they overlap.
+         */
+        number get_distance(const convex &first, const convex &second, vector &on_first, vector &on_second);
+
+        /**
+         * Checks if two shapes overlap, touching included, by GJK.
+         */
+        bool intersects(const convex &first, const convex &second);
+
+        /**
+         * Finds how two shapes overlap, by GJK, then EPA for the penetration.
+         *
+         * @return  Whether the shapes overlap. The contact is only filled when they do.
+         */
+        bool collide(const convex &first, const convex &second, contact &result);
+
+        /**
+         * Finds how two boxes overlap, by separating axes.
+         *
+         * Tests the three face directions of each box and the nine crossings of their edges,
+         * keeping the direction of least overlap. Faster and steadier than GJK for boxes.
+         *
+         * @return  Whether the boxes overlap. The contact is only filled when they do.
+         */
+        bool collide(const cuboid &first, const cuboid &second, contact &result);
+
+        /**
+         * Finds when a moving shape first touches a still shape, by conservative advancement.
+         *
+         * The first shape moves in a straight line, so for two moving shapes pass the motion of
+         * the first relative to the second. Each round advances by the distance between the
+         * shapes over the speed closing it, which never passes the time of impact.
+         *
+         * @param  motion     Motion of the first shape over the whole step.
+         * @param  time       Fraction of the step when the shapes come within the tolerance.
+         * @param  result     Contact at that time, with no depth.
+         * @param  tolerance  Gap at which the shapes count as touching.
+         *
+         * @return  Whether the shapes meet during the step. Shapes overlapping from the start
+         *          are left to collide(), and report no impact.
+         */
+        bool get_impact(const convex &first, const vector &motion, const convex &second, number &time, contact &result,
+          number tolerance = 1e-3f);
+    }
+}
+
+#endif
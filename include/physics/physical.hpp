@@ -3,6 +3,8 @@
 
 #include "../render/model.hpp"
 #include "boundary.hpp"
+#include "hull.hpp"
+#include "narrowphase.hpp"
 
 namespace cosmodon
 {
@@ -24,12 +26,26 @@ namespace cosmodon
         // Current acceleration in m/s*s.
         vector m_acceleration;
 
+        // Mass in kg.
+        number m_mass;
+
         // Whether the object is static and unable to move.
         bool m_static;
 
+        // Whether the object moves fast enough to need continuous collision detection.
+        bool m_fast;
+
+        // Whether the object is asleep, and the speed below which it may fall asleep.
+        bool m_sleeping;
+        number m_sleep_speed;
+
         // Boundary model, which summarizes the physical shape.
         boundary *m_boundary;
 
+        // Convex hull of the vertices, built when first needed.
+        mutable physics::hull m_hull;
+        mutable bool m_hull_ready;
+
     public:
         /**
          * Constructor.
@@ -58,6 +74,16 @@ namespace cosmodon
          */
         vector get_acceleration() const;
 
+        /**
+         * Sets mass, which must be positive. Defaults to one.
+         */
+        void set_mass(number mass);
+
+        /**
+         * Retrieves mass.
+         */
+        number get_mass() const;
+
         /**
          * Determines if an intersection exists between this object and another object, using boundaries if available.
          *
@@ -67,6 +93,50 @@ namespace cosmodon
          */
         virtual bool intersects(const physical &other) const;
 
+        /**
+         * Sets the boundary, or null for none. The boundary is not owned, and is placed relative
+         * to this object.
+         *
+         * Box boundaries stand in for the vertices when finding contacts, though the system
+         * still finds pairs to test from the bounds of the vertices.
+         */
+        void set_boundary(boundary *b);
+
+        /**
+         * Retrieves the boundary, or null for none.
+         */
+        boundary* get_boundary() const;
+
+        /**
+         * Checks if the object has a shape to find contacts with: a box boundary or vertices.
+         */
+        bool has_shape() const;
+
+        /**
+         * Finds how this object overlaps another.
+         *
+         * Two objects with box boundaries compare by separating axes. Otherwise the convex hulls
+         * of their vertices compare by GJK and EPA, a box boundary standing in by its corners.
+         *
+         * @param  other   Object to compare against.
+         * @param  result  Contact, with the normal pointing from this object to the other.
+         *
+         * @returns  True if the objects overlap, or false otherwise.
+         */
+        virtual bool collide(const physical &other, physics::contact &result) const;
+
+        /**
+         * Retrieves the convex hull of the vertices, in local space.
+         *
+         * Built on first use and kept, so call refresh_hull() after changing vertices.
+         */
+        const physics::hull& get_hull() const;
+
+        /**
+         * Rebuilds the convex hull after vertices changed.
+         */
+        void refresh_hull();
+
         /**
          * Sets the static status.
          *
@@ -80,6 +150,50 @@ namespace cosmodon
          * A static object has no acceleration and no velocity, but influences other objects.
          */
         bool is_static() const;
+
+        /**
+         * Sets the fast status.
+         *
+         * Systems sweep fast objects along their motion each step, so they stop at the first
+         * object in their path instead of passing through thin objects between steps. Costs more
+         * than discrete detection, so keep it for projectiles and the like.
+         */
+        void set_fast(bool f);
+
+        /**
+         * Retrieves the fast status.
+         */
+        bool is_fast() const;
+
+        /**
+         * Sets the speed below which the object may fall asleep, in m/s. Defaults to 0.05.
+         *
+         * Systems put objects to sleep once they and every object touching them through moving
+         * objects have stayed below their speeds for a while. Zero keeps the object awake.
+         */
+        void set_sleep_speed(number speed);
+
+        /**
+         * Retrieves the speed below which the object may fall asleep.
+         */
+        number get_sleep_speed() const;
+
+        /**
+         * Puts the object to sleep, stopping it. Systems skip sleeping objects until woken.
+         */
+        void sleep();
+
+        /**
+         * Wakes the object. Systems wake the objects which fell asleep along with it.
+         *
+         * Setting a velocity or acceleration wakes the object too, but moving it by hand does not.
+         */
+        void wake();
+
+        /**
+         * Checks if the object is asleep.
+         */
+        bool is_sleeping() const;
     };
 }
 
@@ -0,0 +1,188 @@
+#ifndef COSMODON_PHYSICS_SOLVER_HPP
+#define COSMODON_PHYSICS_SOLVER_HPP
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "../common/pool.hpp"
+#include "bodies.hpp"
+#include "narrowphase.hpp"
+
+namespace cosmodon
+{
+    namespace physics
+    {
+        /**
+         * A sequential impulse solver, pushing touching bodies apart through their velocities.
+         *
+         * Each contact gives three rows: one along its normal, which only pushes, and two along
+         * its surface, which resist sliding up to the friction limit. Impulses of the previous
+         * step start each pair off, so stacks settle in few iterations.
+         *
+         * Overlaps are removed by separate pushes, solved after the velocities and applied to
+         * positions alone, so correcting them never leaves bodies moving.
+         *
+         * Contacts are split into islands of bodies touching through moving bodies. Islands are
+         * independent, and solved as jobs across the pool, largest first. Islands too large for
+         * one job, such as a tall stack, are colored so no two rows of a color share a moving
+         * body, and each color is solved in parallel, four rows at a time.
+         */
+        class solver
+        {
+        protected:
+            // A contact waiting for the next solve.
+            struct entry
+            {
+                uint32_t first;
+                uint32_t second;
+                contact touch;
+                uint64_t key;
+            };
+
+            // Impulses of a pair, by row.
+            struct impulse
+            {
+                float row[3];
+            };
+
+            // Iterations per solve.
+            uint8_t m_iterations;
+
+            // Ratio of the largest sliding impulse to the pushing impulse.
+            number m_friction;
+
+            // Contacts added since the last solve.
+            std::vector<entry> m_contacts;
+
+            // Velocities, pushing velocities and inverse masses of bodies, by body.
+            std::vector<float> m_velocity[3];
+            std::vector<float> m_push[3];
+            std::vector<float> m_inverse;
+
+            // Bodies with contacts, their island parents, islands, and colors in use.
+            std::vector<uint32_t> m_touched;
+            std::vector<uint32_t> m_parent;
+            std::vector<uint32_t> m_island;
+            std::vector<uint64_t> m_used;
+
+            // Amount of islands of the last solve.
+            uint32_t m_island_count;
+
+            // Rows, ordered by island, then by color.
+            std::vector<uint32_t> m_first;
+            std::vector<uint32_t> m_second;
+            std::vector<float> m_normal[3];
+            std::vector<float> m_tangent[2][3];
+            std::vector<float> m_mass;
+            std::vector<float> m_bias;
+            std::vector<float> m_impulse[3];
+            std::vector<float> m_pushed;
+            std::vector<uint64_t> m_keys;
+
+            // Row ranges of islands solved as one job, of colors of large islands, and of rows
+            // of large islands left without a color, solved in order.
+            std::vector<std::pair<uint32_t, uint32_t>> m_islands;
+            std::vector<std::pair<uint32_t, uint32_t>> m_colors;
+            std::pair<uint32_t, uint32_t> m_leftover;
+
+            // Impulses of the last solve, by pair key.
+            std::unordered_map<uint64_t, impulse> m_cache;
+
+            /**
+             * Finds the root of the island holding a body.
+             */
+            uint32_t find(uint32_t body);
+
+            /**
+             * Applies the impulses of the previous step to a range of rows.
+             */
+            void warm_start(uint32_t first, uint32_t last);
+
+            /**
+             * Solves a range of rows one at a time.
+             */
+            void solve_rows(uint32_t first, uint32_t last);
+
+            /**
+             * Solves four rows at once, which must share no moving body.
+             */
+            void solve_rows4(uint32_t first);
+
+            /**
+             * Solves the pushes of a range of rows one at a time.
+             */
+            void push_rows(uint32_t first, uint32_t last);
+
+        public:
+            /**
+             * Constructor.
+             */
+            solver();
+
+            /**
+             * Sets the iterations per solve. Zero disables solving. Defaults to eight.
+             */
+            void set_iterations(uint8_t iterations);
+
+            /**
+             * Retrieves the iterations per solve.
+             */
+            uint8_t get_iterations() const;
+
+            /**
+             * Sets the ratio of the largest sliding impulse to the pushing impulse. Defaults to
+             * one half.
+             */
+            void set_friction(number friction);
+
+            /**
+             * Removes contacts waiting for the next solve.
+             */
+            void clear();
+
+            /**
+             * Adds a contact for the next solve.
+             *
+             * @param  first   Body of the first shape.
+             * @param  second  Body of the second shape.
+             * @param  touch   Contact, with the normal pointing from the first to the second.
+             * @param  key     Identifies the pair across steps, to start from its last impulses.
+             */
+            void add(uint32_t first, uint32_t second, const contact &touch, uint64_t key);
+
+            /**
+             * Changes velocities of bodies so contacts stop closing over the next step, and moves
+             * bodies so overlaps open.
+             *
+             * Works on the velocities bodies will have after accelerating through the step, and
+             * adds the change to their current velocities, so integration afterwards lands on
+             * the solved velocities. Removes all contacts afterwards.
+             *
+             * @param  motion        Bodies, indexed by contacts.
+             * @param  inverse_mass  Inverse mass of each body, zero for static bodies.
+             * @param  seconds       Length of the step.
+             * @param  threads       Pool to split islands across, or null.
+             */
+            void solve(bodies &motion, const float *inverse_mass, number seconds, pool *threads = nullptr);
+
+            /**
+             * Retrieves the amount of islands of the last solve.
+             */
+            uint32_t get_island_count() const;
+
+            /**
+             * Retrieves the island of a moving body in the last solve, or 0xffffffff for bodies
+             * without contacts and static bodies.
+             */
+            uint32_t get_island(uint32_t body) const;
+
+            /**
+             * Retrieves the amount of colors of large islands of the last solve.
+             */
+            uint32_t get_color_count() const;
+        };
+    }
+}
+
+#endif
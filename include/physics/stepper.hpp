@@ -0,0 +1,104 @@
+#ifndef COSMODON_PHYSICS_STEPPER_HPP
+#define COSMODON_PHYSICS_STEPPER_HPP
+
+#include <cstdint>
+#include "../common/clock.hpp"
+#include "../render/matrix.hpp"
+#include "system.hpp"
+
+namespace cosmodon
+{
+    namespace physics
+    {
+        /**
+         * Drives a physics system in steps of fixed length, however long frames take.
+         *
+         * Frame time is gathered, and whole steps are taken from it, so each step costs the same
+         * and behaves the same at any frame rate. Time left over is less than a step, and gives
+         * how far drawing should blend from the previous step towards the current one.
+         *
+         * When steps fall behind, as when a frame stalls or steps cost more than they simulate,
+         * at most a limited amount run per frame and the rest of the time is dropped. The
+         * simulation slows down instead of taking ever longer frames to catch up.
+         */
+        class stepper
+        {
+        protected:
+            // System driven.
+            system *m_system;
+
+            // Length of a step in seconds, and the most steps per frame.
+            number m_step;
+            uint8_t m_limit;
+
+            // Time gathered and not yet simulated.
+            number m_accumulator;
+
+            // Steps dropped since constructed.
+            uint64_t m_dropped;
+
+            // Measures frame time for advance() without arguments.
+            clock m_clock;
+
+        public:
+            /**
+             * Constructor.
+             *
+             * @param  target  System to drive, which must outlive the stepper.
+             * @param  step    Length of a step in seconds.
+             * @param  limit   Most steps per frame, at least one.
+             */
+            stepper(system &target, number step = 1.0f / 60, uint8_t limit = 4);
+
+            /**
+             * Sets the length of a step in seconds.
+             */
+            void set_step(number seconds);
+
+            /**
+             * Retrieves the length of a step in seconds.
+             */
+            number get_step() const;
+
+            /**
+             * Sets the most steps per frame, at least one.
+             */
+            void set_limit(uint8_t steps);
+
+            /**
+             * Adds frame time, and runs the whole steps it completes.
+             *
+             * Each step updates the system index, then passes one step of time.
+             *
+             * @return  Amount of steps run.
+             */
+            uint8_t advance(number seconds);
+
+            /**
+             * Adds the time since the previous call, or since constructed, and runs the whole
+             * steps it completes.
+             *
+             * @return  Amount of steps run.
+             */
+            uint8_t advance();
+
+            /**
+             * Retrieves how far time has gone past the last step, from zero to one step.
+             */
+            number get_alpha() const;
+
+            /**
+             * Retrieves the amount of steps dropped to keep up.
+             */
+            uint64_t get_dropped() const;
+
+            /**
+             * Retrieves the matrix to draw an object with, blended between its last two steps by
+             * the time past the last step.
+             */
+            matrix get_matrix(system::handle body) const;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,170 @@
+#ifndef COSMODON_PHYSICS_SWEEP_HPP
+#define COSMODON_PHYSICS_SWEEP_HPP
+
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "../render/bounds.hpp"
+
+namespace cosmodon
+{
+    namespace physics
+    {
+        /**
+         * A sweep and prune broadphase, finding pairs of overlapping boxes.
+         *
+         * Keeps the ends of every box sorted along each axis. Moving a box re-sorts its ends by
+         * insertion, swapping them past neighbours one at a time, and each swap of a start past
+         * an end marks a pair starting or stopping to overlap. Boxes moving a little between
+         * updates cost few swaps, so updates run close to linear time.
+         */
+        class sweep
+        {
+        public:
+            /**
+             * Identifies a box.
+             */
+            typedef uint32_t proxy;
+
+            /**
+             * Proxy meaning no box.
+             */
+            static const proxy none = 0xffffffff;
+
+            /**
+             * Two overlapping boxes, by the values given when inserted.
+             */
+            struct pair
+            {
+                uint32_t first;
+                uint32_t second;
+            };
+
+        protected:
+            // An end of a box along an axis.
+            struct endpoint
+            {
+                // Coordinate.
+                float value;
+
+                // Proxy shifted left once, with the lowest bit set for ends and clear for starts.
+                uint32_t data;
+            };
+
+            // A box.
+            struct box
+            {
+                // Corners.
+                float low[3];
+                float high[3];
+
+                // Positions of the start and end in each axis.
+                uint32_t ends[3][2];
+
+                // Value reported in pairs.
+                uint32_t value;
+            };
+
+            // Sorted ends, by axis.
+            std::vector<endpoint> m_endpoints[3];
+
+            // Boxes, by proxy.
+            std::vector<box> m_boxes;
+
+            // Proxies free for reuse, and proxies removed since the last flush.
+            std::vector<proxy> m_free;
+            std::vector<proxy> m_released;
+
+            // Overlapping pairs, by pair key.
+            std::unordered_set<uint64_t> m_pairs;
+
+            // Pairs changed since the last flush, and whether each overlapped before.
+            std::unordered_map<uint64_t, bool> m_touched;
+
+            // Pair events of the last flush.
+            std::vector<pair> m_added;
+            std::vector<pair> m_removed;
+
+            /**
+             * Marks a pair as overlapping, or not.
+             */
+            void set_pair(proxy a, proxy b, bool overlapping);
+
+            /**
+             * Checks if two boxes overlap along all axes.
+             */
+            bool overlaps(proxy a, proxy b) const;
+
+            /**
+             * Swaps an end towards lower positions until sorted.
+             */
+            void sort_down(uint8_t axis, uint32_t position);
+
+            /**
+             * Swaps an end towards higher positions until sorted.
+             */
+            void sort_up(uint8_t axis, uint32_t position);
+
+            /**
+             * Builds a pair from a key.
+             */
+            pair get_pair(uint64_t key) const;
+
+        public:
+            /**
+             * Adds a box.
+             *
+             * @param  area   Box, which must not be empty.
+             * @param  value  Value reported in pairs of this box.
+             *
+             * @return  Proxy of the box.
+             */
+            proxy insert(const bounds &area, uint32_t value);
+
+            /**
+             * Changes the corners of a box.
+             */
+            void move(proxy p, const bounds &area);
+
+            /**
+             * Removes a box, ending its pairs.
+             */
+            void remove(proxy p);
+
+            /**
+             * Removes all boxes, without events.
+             */
+            void clear();
+
+            /**
+             * Collects pair changes since the last flush into events.
+             *
+             * Pairs starting and stopping to overlap between flushes give no event.
+             */
+            void flush();
+
+            /**
+             * Retrieves pairs which started to overlap, as of the last flush.
+             */
+            const std::vector<pair>& get_added() const;
+
+            /**
+             * Retrieves pairs which stopped overlapping, as of the last flush.
+             */
+            const std::vector<pair>& get_removed() const;
+
+            /**
+             * Retrieves all overlapping pairs.
+             */
+            void get_pairs(std::vector<pair> &results) const;
+
+            /**
+             * Retrieves the amount of overlapping pairs.
+             */
+            uint32_t get_pair_count() const;
+        };
+    }
+}
+
+#endif
@@ -1,44 +1,389 @@
 #ifndef COSMODON_PHYSICS_SYSTEM_HPP
 #define COSMODON_PHYSICS_SYSTEM_HPP
 
+#include <memory>
+#include <unordered_map>
 #include <vector>
+#include "../common/pool.hpp"
+#include "../common/slot_map.hpp"
+#include "../render/octree.hpp"
+#include "bodies.hpp"
+#include "grid.hpp"
 #include "physical.hpp"
+#include "solver.hpp"
+#include "sweep.hpp"
+#include "tree.hpp"
 
 namespace cosmodon
 {
     namespace physics
     {
+        /**
+         * Methods of finding pairs of objects with overlapping bounds.
+         */
+        enum class broadphase : uint8_t
+        {
+            // Sweep and prune, updated incrementally. Suits slow moving objects of any size.
+            sweep,
+
+            // Uniform hash grid, rebuilt every update across the pool. Suits many fast moving
+            // objects of similar size.
+            grid,
+
+            // Dynamic bounding volume hierarchy over grown boxes. Suits objects of very
+            // different sizes, and answers queries.
+            tree
+        };
+
         /**
          * A standard physics system, where physical objects interact under the passage of time.
          *
-         * @@@ Replace with custom set.
+         * Objects are identified by handles, which stay valid until the object is removed and
+         * are recognized as stale afterwards. Adding, removing and looking up objects take
+         * constant time.
          */
         class system : public physical
         {
+        public:
+            /**
+             * Identifies an object in the system.
+             */
+            typedef uint32_t handle;
+
+            /**
+             * Handle meaning no object.
+             */
+            static const handle none = 0xffffffff;
+
+            /**
+             * A fast object meeting another object during a step.
+             */
+            struct impact
+            {
+                // Fast object, and the object in its path.
+                handle first;
+                handle second;
+
+                // Seconds into the step.
+                number time;
+
+                // Contact, with the normal pointing from the fast object to the other.
+                contact touch;
+            };
+
         protected:
-            // Collection of normal objects.
-            std::vector<physical*> m_objects;
+            // An object in the system.
+            struct member
+            {
+                // The object.
+                physical *object;
+
+                // The object, when created and owned by the system.
+                std::unique_ptr<physical> owned;
+
+                // Handle of the object in the spatial index.
+                octree::handle cell;
+
+                // Proxy of the object in the broadphase.
+                sweep::proxy proxy;
+
+                // Seconds spent below its sleep speed, and its sleeping group, or none if awake.
+                number rest;
+                uint32_t group;
+            };
+
+            // Objects, stored densely. Positions match bodies.
+            slot_map<member> m_members;
+
+            // Handle of each object.
+            std::unordered_map<const physical*, handle> m_handles;
+
+            // Spatial index over object bounds, and object handles by index handle.
+            octree m_index;
+            std::vector<handle> m_indexed;
+
+            // Bounds of objects, by position.
+            std::vector<bounds> m_boxes;
+
+            // Translation of each object's matrix before the last step, by position and axis.
+            std::vector<float> m_previous[3];
+
+            // Broadphase method, and the broadphase of each method, reporting pairs by handle.
+            broadphase m_broadphase;
+            sweep m_sweep;
+            grid m_grid;
+            tree m_tree;
+
+            // Pairs of the last grid update, ordered, and pair events of the last grid update.
+            std::vector<sweep::pair> m_pairs;
+            std::vector<sweep::pair> m_added;
+            std::vector<sweep::pair> m_removed;
+
+            // Motion state of objects, and their inverse masses.
+            bodies m_bodies;
+            std::vector<float> m_inverse;
+
+            // Contact solver.
+            solver m_solver;
+
+            // Bodies whose previous acceleration is known, from the first.
+            uint32_t m_known;
+
+            // Integration method.
+            integrator m_method;
+
+            // Pool to integrate on, or null.
+            pool *m_pool;
+
+            // Impacts of fast objects during the last step.
+            std::vector<impact> m_impacts;
+
+            // Hull standing in for fast objects without vertices.
+            hull m_point;
+
+            // Seconds objects stay slow before falling asleep.
+            number m_sleep_time;
+
+            // Objects which fell asleep together, by group, and the next group.
+            std::unordered_map<uint32_t, std::vector<handle>> m_groups;
+            uint32_t m_next_group;
+
+            /**
+             * Adds an object, owned by the caller or by the system.
+             */
+            handle add(physical *object, std::unique_ptr<physical> owned);
+
+            /**
+             * Adds an object to the spatial index.
+             */
+            octree::handle index(physical &object, handle body);
+
+            /**
+             * Adds the object at a position to the incremental broadphase in use, if any.
+             *
+             * @return  Proxy of the object, or none.
+             */
+            sweep::proxy insert_proxy(uint32_t position);
+
+            /**
+             * Rebuilds the grid, and finds pair events against the previous grid.
+             */
+            void update_grid();
+
+            /**
+             * Finds contacts between objects of overlapping pairs, and hands them to the solver.
+             */
+            void find_contacts();
+
+            /**
+             * Puts objects to sleep as one group, woken together.
+             *
+             * @param  positions  Positions of the objects.
+             */
+            void fall_asleep(const std::vector<uint32_t> &positions);
+
+            /**
+             * Wakes all objects of a sleeping group.
+             */
+            void wake_group(uint32_t group);
+
+            /**
+             * Tracks how long objects stay slow, and puts islands to sleep once all their
+             * objects have stayed slow long enough.
+             */
+            void update_sleep(number seconds);
+
+            /**
+             * Sweeps fast objects from their positions before the step to their integrated
+             * positions, stopping each at the first object in its path.
+             *
+             * @param  fast     Positions of fast objects.
+             * @param  seconds  Length of the step.
+             */
+            void advance_fast(const std::vector<uint32_t> &fast, number seconds);
 
         public:
+            /**
+             * Constructor.
+             */
+            system();
+
             /**
              * Adds an object to this system.
+             *
+             * The object remains owned by the caller, and must outlive its membership. Handles
+             * are never reused, so a system takes about four million objects at once, and about
+             * four billion additions over its lifetime, before throwing an error.
+             *
+             * @return  Handle of the object, or its existing handle if already inside.
              */
-            void add(physical &object);
+            handle add(physical &object);
+
+            /**
+             * Creates an object owned by this system, destroyed when removed. Throws an error
+             * when out of handles, as add() does.
+             *
+             * @return  Handle of the object.
+             */
+            handle spawn();
 
             /**
              * Checks if an object is in the system.
              */
             bool is_inside(physical &object) const;
 
+            /**
+             * Checks if a handle refers to an object in the system.
+             */
+            bool is_inside(handle body) const;
+
             /**
              * Removes an object from this system.
              */
             void remove(physical &object);
 
+            /**
+             * Removes an object from this system by handle. Stale handles are ignored.
+             */
+            void remove(handle body);
+
+            /**
+             * Retrieves an object by handle, or null for stale handles.
+             */
+            physical* get(handle body) const;
+
+            /**
+             * Retrieves the handle of an object, or none if not inside.
+             */
+            handle get_handle(const physical &object) const;
+
+            /**
+             * Retrieves the amount of objects.
+             */
+            uint32_t size() const;
+
+            /**
+             * Updates the spatial index and broadphase with objects whose transformation changed.
+             *
+             * Marks updated objects clean, and collects pairs which started or stopped
+             * overlapping since the last update, including pairs of added and removed objects.
+             */
+            void update_index();
+
+            /**
+             * Retrieves pairs of objects whose bounds started to overlap, as of the last update.
+             */
+            const std::vector<sweep::pair>& get_added_pairs() const;
+
+            /**
+             * Retrieves pairs of objects whose bounds stopped overlapping, as of the last update.
+             *
+             * Handles in these pairs may refer to objects removed since.
+             */
+            const std::vector<sweep::pair>& get_removed_pairs() const;
+
+            /**
+             * Retrieves all pairs of objects whose bounds overlap.
+             */
+            void get_pairs(std::vector<sweep::pair> &results) const;
+
+            /**
+             * Sets the broadphase method. Defaults to sweep and prune.
+             *
+             * Pairs are tracked anew, so the next update reports all overlapping pairs as added.
+             */
+            void set_broadphase(broadphase method);
+
+            /**
+             * Sets the grid cell size, or zero to fit cells to the largest object.
+             */
+            void set_cell_size(number size);
+
+            /**
+             * Retrieves the dynamic tree over object bounds, with object handles as values.
+             *
+             * Holds objects only while the tree broadphase is in use.
+             */
+            const tree& get_tree() const;
+
+            /**
+             * Retrieves the spatial index over object bounds.
+             *
+             * Index handles map to objects through get_object(). Renderers and other readers may
+             * query it between index updates.
+             */
+            const octree& get_index() const;
+
+            /**
+             * Changes the region divided by the spatial index, reinserting all objects.
+             */
+            void set_region(const bounds &region, uint8_t depth = 8);
+
+            /**
+             * Retrieves the object of a spatial index handle.
+             */
+            physical* get_object(octree::handle object) const;
+
+            /**
+             * Sets the integration method. Defaults to semi-implicit Euler.
+             *
+             * Under Verlet, velocities read between steps assume accelerations stay constant,
+             * and are finished from the accelerations objects hold at the start of the next.
+             */
+            void set_integrator(integrator method);
+
+            /**
+             * Sets a pool to split work across, or null to work on the calling thread.
+             */
+            void set_pool(pool *threads);
+
             /**
              * Perform physics.
+             *
+             * Gathers the motion of all objects into contiguous arrays, integrates them four at
+             * a time, then writes positions and velocities back to the objects in one pass.
+             *
+             * Objects whose bounds overlap as of the last index update and whose hulls touch are
+             * pushed apart by the solver first, through their velocities.
+             *
+             * Sleeping objects hold still, and are skipped by integration, contact tests between
+             * themselves and the solver, and leave the broadphase untouched. Moving objects
+             * touching them, or setting their velocity, wake them with the rest of their group.
+             *
+             * Fast objects are swept along their motion against the spatial index, so keep it
+             * current with update_index() between steps. One hitting another object stops there,
+             * loses its velocity into the other, and slides on for the rest of the step, up to a
+             * few impacts per step. Other objects move freely.
              */
             virtual void pass_time(number seconds);
+
+            /**
+             * Retrieves impacts of fast objects during the last step, in order of objects.
+             */
+            const std::vector<impact>& get_impacts() const;
+
+            /**
+             * Retrieves the matrix of an object between its last two steps, for drawing between
+             * fixed steps.
+             *
+             * Steps only move objects, so the translation is blended while the rest of the
+             * matrix stays current.
+             *
+             * @param  body   Object handle, which must not be stale.
+             * @param  alpha  Zero for the matrix before the last step, one for the current.
+             */
+            matrix get_interpolated(handle body, number alpha) const;
+
+            /**
+             * Retrieves the contact solver, for its settings.
+             */
+            solver& get_solver();
+
+            /**
+             * Sets how long objects stay below their sleep speed before falling asleep, or zero
+             * to keep all objects awake. Defaults to half a second.
+             */
+            void set_sleep_time(number seconds);
         };
     }
 }
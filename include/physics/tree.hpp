@@ -0,0 +1,257 @@
+#ifndef COSMODON_PHYSICS_TREE_HPP
+#define COSMODON_PHYSICS_TREE_HPP
+
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "../common/pool.hpp"
+#include "../render/bounds.hpp"
+#include "../render/ray.hpp"
+#include "sweep.hpp"
+
+namespace cosmodon
+{
+    namespace physics
+    {
+        /**
+         * A dynamic bounding volume hierarchy broadphase, updated as boxes move.
+         *
+         * Leaves hold boxes grown by a margin, and further in the direction of motion, so small
+         * motions stay inside and leave the tree untouched. Leaves are inserted where they add
+         * the least surface area, and rotations keep the tree balanced. Nodes live in one array,
+         * with removed nodes chained for reuse.
+         *
+         * Suits boxes of very different sizes, such as large static structures among small
+         * moving objects, which defeat uniform grids.
+         */
+        class tree
+        {
+        public:
+            /**
+             * Identifies a box.
+             */
+            typedef uint32_t proxy;
+
+            /**
+             * Proxy meaning no box.
+             */
+            static const proxy none = 0xffffffff;
+
+            /**
+             * Two overlapping boxes, by the values given when inserted.
+             */
+            typedef sweep::pair pair;
+
+            /**
+             * Corners of a box, kept as plain arrays for fast tests.
+             */
+            struct extent
+            {
+                float low[3];
+                float high[3];
+            };
+
+        protected:
+            // A node, either a leaf holding a box, or a branch with two children.
+            struct node
+            {
+                // Box enclosing the children, or the grown box of a leaf.
+                extent box;
+
+                // Exact box of a leaf.
+                extent tight;
+
+                // Parent, or the next free node.
+                uint32_t parent;
+
+                // Children of a branch, none for leaves.
+                uint32_t children[2];
+
+                // Height above the lowest leaf, zero for leaves, negative when free.
+                int32_t height;
+
+                // Value reported in pairs.
+                uint32_t value;
+
+                // Whether the leaf moved or was removed since the last flush.
+                bool moved;
+                bool removed;
+            };
+
+            // Nodes, and the first free node.
+            std::vector<node> m_nodes;
+            uint32_t m_free;
+
+            // Root node.
+            uint32_t m_root;
+
+            // Amount of boxes.
+            uint32_t m_count;
+
+            // Growth of boxes on all sides.
+            number m_margin;
+
+            // Leaves moved or removed since the last flush.
+            std::vector<proxy> m_moved;
+
+            // Overlapping pairs, by pair key.
+            std::unordered_set<uint64_t> m_pairs;
+
+            // Pairs changed since the last flush, and whether each overlapped before.
+            std::unordered_map<uint64_t, bool> m_touched;
+
+            // Pair keys found by each job of a flush.
+            std::vector<std::vector<uint64_t>> m_found;
+
+            // Pair events of the last flush.
+            std::vector<pair> m_added;
+            std::vector<pair> m_removed;
+
+            /**
+             * Takes a node from the free list, or a new one.
+             */
+            uint32_t allocate();
+
+            /**
+             * Returns a node to the free list.
+             */
+            void release(uint32_t index);
+
+            /**
+             * Links a leaf into the tree, beside the sibling adding the least area.
+             */
+            void insert_leaf(uint32_t leaf);
+
+            /**
+             * Unlinks a leaf from the tree, freeing its parent.
+             */
+            void remove_leaf(uint32_t leaf);
+
+            /**
+             * Rotates a node towards balance, returning the node now in its place.
+             */
+            uint32_t balance(uint32_t index);
+
+            /**
+             * Recomputes boxes and heights from a node up to the root, balancing on the way.
+             */
+            void refit(uint32_t index);
+
+            /**
+             * Marks a pair as overlapping, or not.
+             */
+            void set_pair(proxy a, proxy b, bool overlapping);
+
+            /**
+             * Collects leaves whose exact boxes are accepted by a test, descending into nodes
+             * accepted by the same test.
+             */
+            template <typename test>
+            void collect(test accept, std::vector<proxy> &results) const;
+
+        public:
+            /**
+             * Constructor.
+             *
+             * @param  margin  Growth of boxes on all sides.
+             */
+            tree(number margin = 0.1f);
+
+            /**
+             * Sets the growth of boxes on all sides, for boxes inserted or moved afterwards.
+             */
+            void set_margin(number margin);
+
+            /**
+             * Adds a box.
+             *
+             * @param  area   Box, which must not be empty.
+             * @param  value  Value reported in pairs and queries of this box.
+             *
+             * @return  Proxy of the box.
+             */
+            proxy insert(const bounds &area, uint32_t value);
+
+            /**
+             * Changes the box of a proxy.
+             *
+             * @param  displacement  Recent motion, stretching the grown box ahead of the object.
+             *
+             * @return  Whether the box left its grown box, and was reinserted.
+             */
+            bool move(proxy p, const bounds &area, const vector &displacement = vector(0, 0, 0));
+
+            /**
+             * Removes a box, ending its pairs.
+             */
+            void remove(proxy p);
+
+            /**
+             * Removes all boxes, without events.
+             */
+            void clear();
+
+            /**
+             * Retrieves the amount of boxes.
+             */
+            uint32_t size() const;
+
+            /**
+             * Retrieves the height of the tree, zero when holding up to one box.
+             */
+            uint32_t get_height() const;
+
+            /**
+             * Retrieves the value of a proxy.
+             */
+            uint32_t get_value(proxy p) const;
+
+            /**
+             * Retrieves the exact box of a proxy.
+             */
+            bounds get_bounds(proxy p) const;
+
+            /**
+             * Finds pairs of moved boxes, and collects pair changes since the last flush into
+             * events.
+             *
+             * Boxes moved since the last flush query the tree independently, split across the
+             * pool when given.
+             */
+            void flush(pool *threads = nullptr);
+
+            /**
+             * Retrieves pairs which started to overlap, as of the last flush.
+             */
+            const std::vector<pair>& get_added() const;
+
+            /**
+             * Retrieves pairs which stopped overlapping, as of the last flush.
+             */
+            const std::vector<pair>& get_removed() const;
+
+            /**
+             * Retrieves all overlapping pairs, as of the last flush.
+             */
+            void get_pairs(std::vector<pair> &results) const;
+
+            /**
+             * Finds boxes overlapping a box, appending their proxies to results.
+             */
+            void query(const bounds &area, std::vector<proxy> &results) const;
+
+            /**
+             * Finds boxes overlapping a sphere, appending their proxies to results.
+             */
+            void query(const vector &center, number radius, std::vector<proxy> &results) const;
+
+            /**
+             * Finds boxes crossed by a ray within a distance, appending their proxies to results.
+             */
+            void query(const ray &r, number distance, std::vector<proxy> &results) const;
+        };
+    }
+}
+
+#endif
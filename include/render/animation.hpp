@@ -0,0 +1,297 @@
+#ifndef COSMODON_RENDER_ANIMATION_HPP
+#define COSMODON_RENDER_ANIMATION_HPP
+
+#include <cstdint>
+#include <vector>
+#include "../common/pool.hpp"
+#include "matrix.hpp"
+#include "vertices.hpp"
+
+namespace cosmodon
+{
+    /**
+     * Skeletal animation: joint hierarchies posed by keyframed clips, deforming vertices.
+     */
+    namespace animation
+    {
+        /**
+         * Joint index meaning no joint.
+         */
+        const uint16_t none = 0xffff;
+
+        /**
+         * Local transformations of every joint of a skeleton.
+         *
+         * Stored as separate arrays per component, translation x, y, z, rotation quaternion x,
+         * y, z, w, then scale x, y, z, so operations run over four joints at once.
+         */
+        class pose
+        {
+        protected:
+            // Amount of joints.
+            uint16_t m_joints;
+
+            // Length of each component array, rounded up to a multiple of four.
+            uint16_t m_stride;
+
+            // Component arrays.
+            std::vector<float> m_values;
+
+        public:
+            /**
+             * Amount of component arrays.
+             */
+            static const uint8_t components = 10;
+
+            /**
+             * Constructor, setting every joint to the identity transformation.
+             */
+            pose(uint16_t joints = 0);
+
+            /**
+             * Changes the joint count, setting every joint to the identity transformation.
+             */
+            void resize(uint16_t joints);
+
+            /**
+             * Retrieves the joint count.
+             */
+            uint16_t size() const;
+
+            /**
+             * Retrieves the length of each component array.
+             */
+            uint16_t get_stride() const;
+
+            /**
+             * Sets the translation of a joint.
+             */
+            void set_translation(uint16_t joint, const vector &translation);
+
+            /**
+             * Sets the rotation of a joint, as a unit quaternion.
+             */
+            void set_rotation(uint16_t joint, number x, number y, number z, number w);
+
+            /**
+             * Sets the rotation of a joint, about an axis.
+             */
+            void set_rotation(uint16_t joint, const vector &axis, number radians);
+
+            /**
+             * Sets the scale of a joint.
+             */
+            void set_scale(uint16_t joint, const vector &scale);
+
+            /**
+             * Retrieves the translation of a joint.
+             */
+            vector get_translation(uint16_t joint) const;
+
+            /**
+             * Retrieves the scale of a joint.
+             */
+            vector get_scale(uint16_t joint) const;
+
+            /**
+             * Retrieves raw component arrays.
+             */
+            const float* get_values() const;
+
+            /**
+             * Sets every component from raw arrays of a pose with the same joint count.
+             */
+            void set_values(const float *values);
+
+            /**
+             * Blends two poses with the same joint count.
+             *
+             * Translations and scales are interpolated linearly, and rotations along the shorter
+             * arc, normalized.
+             *
+             * @param  from    Pose at a weight of zero.
+             * @param  to      Pose at a weight of one.
+             * @param  weight  Blend weight.
+             * @param  result  Resulting pose, which may be one of the inputs.
+             */
+            static void blend(const pose &from, const pose &to, number weight, pose &result);
+        };
+
+        /**
+         * A keyframed animation of a skeleton.
+         *
+         * Keys hold every joint, in the component layout of poses, so sampling reads two
+         * contiguous blocks of memory.
+         */
+        class clip
+        {
+        protected:
+            // Amount of joints.
+            uint16_t m_joints;
+
+            // Floats per key.
+            uint32_t m_size;
+
+            // Key times, in seconds, increasing.
+            std::vector<number> m_times;
+
+            // Key poses.
+            std::vector<float> m_values;
+
+        public:
+            /**
+             * Constructor.
+             */
+            clip(uint16_t joints = 0);
+
+            /**
+             * Adds a key, later than all earlier keys. Throws an error on mismatched poses.
+             */
+            void add_key(number time, const pose &key);
+
+            /**
+             * Retrieves the time of the last key.
+             */
+            number get_duration() const;
+
+            /**
+             * Retrieves the amount of keys.
+             */
+            uint32_t get_key_count() const;
+
+            /**
+             * Samples the clip at a time, blending the two nearest keys.
+             *
+             * @param  time    Time, in seconds.
+             * @param  result  Resulting pose, resized to the joint count of the clip.
+             * @param  loop    Whether time wraps around the duration, or clamps to it.
+             */
+            void sample(number time, pose &result, bool loop = true) const;
+        };
+
+        /**
+         * A hierarchy of joints.
+         */
+        class skeleton
+        {
+        protected:
+            // Parent of each joint, or none. Parents precede their children.
+            std::vector<uint16_t> m_parents;
+
+            // Transformation from model space to the space of each joint at rest, twelve values
+            // per joint, as three rows of four.
+            std::vector<float> m_inverse_binds;
+
+        public:
+            /**
+             * Adds a joint.
+             *
+             * @param  parent        Parent joint, added earlier, or none.
+             * @param  inverse_bind  Inverse of the joint's model space transformation at rest.
+             *
+             * @return  Index of the joint.
+             */
+            uint16_t add(uint16_t parent, const matrix &inverse_bind);
+
+            /**
+             * Retrieves the joint count.
+             */
+            uint16_t size() const;
+
+            /**
+             * Retrieves the parent of a joint.
+             */
+            uint16_t get_parent(uint16_t joint) const;
+
+            /**
+             * Computes skinning matrices from a pose.
+             *
+             * Each matrix transforms from model space at rest to model space in the pose, stored
+             * as four columns of four values, the last value of each unused.
+             *
+             * @param  current  Pose of every joint, relative to its parent.
+             * @param  palette  Resulting matrices, sixteen values per joint.
+             */
+            void compute(const pose &current, std::vector<float> &palette) const;
+        };
+
+        /**
+         * Joint influences on the vertices of a mesh.
+         */
+        class skin
+        {
+        protected:
+            // Four joints per vertex.
+            std::vector<uint16_t> m_joints;
+
+            // Four weights per vertex, in decreasing order, summing to one.
+            std::vector<float> m_weights;
+
+        public:
+            /**
+             * Changes the vertex count. New vertices have no influences.
+             */
+            void resize(uint32_t vertices);
+
+            /**
+             * Retrieves the vertex count.
+             */
+            uint32_t size() const;
+
+            /**
+             * Sets the influences of a vertex.
+             *
+             * Weights are sorted and normalized. Unused influences have a weight of zero.
+             */
+            void set(uint32_t vertex, const uint16_t *joints, const number *weights);
+
+            /**
+             * Deforms vertices by skinning matrices, blending up to four per vertex.
+             *
+             * Positions are written to the target, which is resized and given the colors and
+             * indices of the source when its size differs.
+             *
+             * @param  source   Vertices at rest.
+             * @param  palette  Skinning matrices, from skeleton::compute().
+             * @param  target   Deformed vertices.
+             */
+            void apply(const vertices &source, const std::vector<float> &palette, vertices &target) const;
+        };
+
+        /**
+         * An animated mesh, posed and skinned by update().
+         */
+        struct character
+        {
+            // Joint hierarchy.
+            const skeleton *rig;
+
+            // Joint influences on the mesh.
+            const skin *weights;
+
+            // Mesh at rest.
+            const vertices *source;
+
+            // Deformed mesh.
+            vertices *target;
+
+            // Current pose, set by the caller.
+            pose current;
+
+            // Skinning matrices of the current pose.
+            std::vector<float> palette;
+        };
+
+        /**
+         * Skins many characters to their current poses.
+         *
+         * @param  characters  Characters to skin.
+         * @param  count       Amount of characters.
+         * @param  threads     Pool to split characters across, or null to skin on the calling
+         *                     thread.
+         */
+        void update(character *characters, uint32_t count, pool *threads = nullptr);
+    }
+}
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef COSMODON_RENDER_BOUNDS_HPP
+#define COSMODON_RENDER_BOUNDS_HPP
+
+#include "vector.hpp"
+
+namespace cosmodon
+{
+    /**
+     * An axis-aligned bounding box.
+     *
+     * A default box is empty: it contains nothing, and takes the shape of whatever is first
+     * added to it.
+     */
+    class bounds
+    {
+    protected:
+        // Corners with the lowest and highest coordinates.
+        vector m_low;
+        vector m_high;
+
+    public:
+        /**
+         * Constructor, creating an empty box.
+         */
+        bounds();
+
+        /**
+         * Constructor.
+         */
+        bounds(const vector &low, const vector &high);
+
+        /**
+         * Checks if this box is empty.
+         */
+        bool is_empty() const;
+
+        /**
+         * Retrieves the corner with the lowest coordinates.
+         */
+        const vector& get_low() const;
+
+        /**
+         * Retrieves the corner with the highest coordinates.
+         */
+        const vector& get_high() const;
+
+        /**
+         * Retrieves the center of this box.
+         */
+        vector get_center() const;
+
+        /**
+         * Retrieves the size of this box along each axis.
+         */
+        vector get_size() const;
+
+        /**
+         * Retrieves the surface area of this box, or zero if empty.
+         */
+        number get_area() const;
+
+        /**
+         * Grows this box to contain a point.
+         */
+        void expand(const vector &point);
+
+        /**
+         * Grows this box to contain another box.
+         */
+        void expand(const bounds &other);
+
+        /**
+         * Checks if this box contains a point.
+         */
+        bool contains(const vector &point) const;
+
+        /**
+         * Checks if this box overlaps another box, touching included.
+         */
+        bool overlaps(const bounds &other) const;
+    };
+}
+
+#endif
@@ -0,0 +1,235 @@
+#ifndef COSMODON_RENDER_BVH_HPP
+#define COSMODON_RENDER_BVH_HPP
+
+#include <cstdint>
+#include <vector>
+#include "../common/simd.hpp"
+#include "bounds.hpp"
+#include "ray.hpp"
+#include "vertices.hpp"
+
+namespace cosmodon
+{
+    /**
+     * A bounding volume hierarchy, for fast ray queries.
+     *
+     * Built over the triangles of a vertex collection, or over plain boxes. Splits are chosen by
+     * the surface area heuristic, binning box centers along each axis. Rays are traced four at
+     * a time, testing all four against each box and triangle together.
+     */
+    class bvh
+    {
+    public:
+        /**
+         * Index meaning no triangle or object.
+         */
+        static const uint32_t none = 0xffffffff;
+
+        /**
+         * A tree node.
+         *
+         * Children of a branch are stored next to each other, the first at index first. Leaves
+         * refer to count items, from position first in item order.
+         */
+        struct node
+        {
+            float low[3];
+            uint32_t first;
+            float high[3];
+            uint16_t count;
+            uint8_t axis;
+            uint8_t padding;
+        };
+
+        /**
+         * The nearest intersection along a ray.
+         */
+        struct hit
+        {
+            // Distance along the ray.
+            number distance;
+
+            // Index of the triangle hit, in drawing order, or none.
+            uint32_t triangle;
+
+            // Index of the object hit within a scene, or none for direct queries.
+            uint32_t object;
+
+            // Barycentric coordinates within the triangle, weighting its second and third vertex.
+            number u;
+            number v;
+
+            /**
+             * Constructor, creating a miss.
+             */
+            hit();
+
+            /**
+             * Checks if anything was hit.
+             */
+            bool is_hit() const;
+        };
+
+        /**
+         * Four rays, traced together.
+         *
+         * Directions need not be of unit length. Distances are measured in multiples of the
+         * direction, so rays transformed into another space keep their distances.
+         */
+        struct packet
+        {
+            simd::float4 origin[3];
+            simd::float4 direction[3];
+            simd::float4 inverse[3];
+
+            // Distance to the nearest hit so far.
+            simd::float4 distance;
+
+            // Mask of rays in use.
+            simd::float4 active;
+
+            /**
+             * Loads up to four rays, starting at distances of earlier hits.
+             */
+            void load(const ray *rays, uint8_t count, const hit *hits);
+
+            /**
+             * Computes inverse directions, after directions change.
+             */
+            void prepare();
+
+            /**
+             * Tests rays against a node's box, returning the mask of rays which enter it before
+             * their nearest hit.
+             */
+            simd::float4 intersects(const node &box) const;
+        };
+
+    protected:
+        // Tree nodes, root first.
+        std::vector<node> m_nodes;
+
+        // Item indices, in leaf order.
+        std::vector<uint32_t> m_items;
+
+        // Triangles in leaf order, as a first vertex and two edges, nine values per triangle.
+        std::vector<float> m_triangles;
+
+        /**
+         * Builds the tree over item boxes.
+         */
+        void build(const std::vector<bounds> &boxes, uint8_t leaf);
+
+        /**
+         * Tests rays against triangles of a leaf, updating nearest hits.
+         */
+        void intersect(packet &rays, const node &leaf, hit *hits, uint32_t object) const;
+
+    public:
+        /**
+         * Builds the tree over the triangles of a vertex collection.
+         *
+         * Vertices are taken as they are stored, without their transformation. Throws an error
+         * if the collection is not a triangle list.
+         *
+         * @param  mesh  Triangles to build over.
+         * @param  leaf  Largest triangle count to store in a leaf without considering a split.
+         */
+        void build(const vertices &mesh, uint8_t leaf = 4);
+
+        /**
+         * Builds the tree over boxes, for queries handled by the caller through traverse().
+         */
+        void build(const std::vector<bounds> &boxes);
+
+        /**
+         * Removes all nodes.
+         */
+        void clear();
+
+        /**
+         * Retrieves the box around everything in the tree.
+         */
+        bounds get_bounds() const;
+
+        /**
+         * Retrieves the amount of tree nodes.
+         */
+        uint32_t get_node_count() const;
+
+        /**
+         * Retrieves a tree node.
+         */
+        const node& get_node(uint32_t index) const;
+
+        /**
+         * Retrieves an item index, by position in leaf order.
+         */
+        uint32_t get_item(uint32_t position) const;
+
+        /**
+         * Finds the nearest triangle hit by a ray.
+         *
+         * @return  Whether a triangle nearer than the hit's current distance was found.
+         */
+        bool intersect(const ray &r, hit &result) const;
+
+        /**
+         * Finds the nearest triangles hit by many rays.
+         *
+         * Results are only replaced by hits nearer than their current distance.
+         */
+        void intersect(const ray *rays, hit *results, uint32_t count) const;
+
+        /**
+         * Finds the nearest triangles hit by a packet of four rays.
+         *
+         * @param  rays     Packet, whose distances shrink to the nearest hits.
+         * @param  hits     Four results, updated where a nearer hit is found.
+         * @param  object   Object index stored in updated results.
+         */
+        void intersect(packet &rays, hit *hits, uint32_t object = none) const;
+
+        /**
+         * Visits leaves whose boxes are entered by a packet of rays.
+         *
+         * Nearer children are visited first, as judged along the direction of the packet. The
+         * visitor receives a leaf node, and may shrink packet distances to skip farther nodes.
+         */
+        template <typename visitor>
+        void traverse(packet &rays, visitor visit) const
+        {
+            // Depth of trees is bounded when building, so a fixed stack suffices.
+            uint32_t stack[128];
+            uint32_t top = 0;
+            float direction[3][4];
+
+            if (m_nodes.empty()) {
+                return;
+            }
+            for (uint8_t i = 0; i < 3; i++) {
+                rays.direction[i].store(direction[i]);
+            }
+
+            stack[top++] = 0;
+            while (top > 0) {
+                const node &n = m_nodes[stack[--top]];
+                if (rays.intersects(n).bits() == 0) {
+                    continue;
+                }
+                if (n.count > 0) {
+                    visit(n);
+                    continue;
+                }
+
+                // Push the farther child first, so the nearer one is visited first.
+                const float *d = direction[n.axis];
+                bool forward = (d[0] + d[1] + d[2] + d[3]) >= 0;
+                stack[top++] = forward ? n.first + 1 : n.first;
+                stack[top++] = forward ? n.first : n.first + 1;
+            }
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,280 @@
+#ifndef COSMODON_RENDER_CATALOG_HPP
+#define COSMODON_RENDER_CATALOG_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "../common/mapped_file.hpp"
+#include "../draw/camera.hpp"
+#include "../draw/graphic.hpp"
+#include "points.hpp"
+#include "vertices.hpp"
+
+namespace cosmodon
+{
+    /**
+     * A point catalog too large for memory, stored on disk as an octree.
+     *
+     * Each node keeps a random subsample of the points within its cell, and passes the rest on
+     * to its children, so drawing any subtree from the root down gives an even, progressively
+     * finer view. The file is mapped rather than read. Each update selects the nodes whose
+     * detail is visible from a camera, fetches missing ones on a background thread, and gives
+     * unused ones back to the kernel, keeping mapped nodes within a memory budget. Nodes still
+     * being fetched are skipped, so their coarser parents stand in for them.
+     */
+    class catalog : public graphic
+    {
+    public:
+        /**
+         * A node, as stored in the node table of a catalog file.
+         */
+        struct node
+        {
+            // Cell covered by this node.
+            float origin[3];
+            float extent;
+
+            // Location of this node's quantized points within the file.
+            uint64_t offset;
+            uint32_t count;
+
+            // Child node indices per octant, or zero for none. Octant bits are x = 4, y = 2, z = 1.
+            uint32_t children[8];
+        };
+
+        /**
+         * Collects points piece by piece, and writes them out as a catalog file.
+         *
+         * Nodes sample from all points below them, so every point is held until writing, once.
+         * Sources can be released as soon as they are added.
+         */
+        class builder
+        {
+        public:
+            /**
+             * A point waiting to be written.
+             */
+            struct entry
+            {
+                number x;
+                number y;
+                number z;
+                color c;
+            };
+
+        protected:
+            // Points added so far, and the box around them.
+            std::vector<entry> m_entries;
+            vector m_low;
+            vector m_high;
+
+            // Points sampled into each node, and the maximum depth of the tree.
+            uint32_t m_capacity;
+            uint8_t m_depth;
+
+        public:
+            /**
+             * Constructor.
+             *
+             * @param  capacity  Points sampled into each node.
+             * @param  depth     Maximum depth of the tree. Nodes at this depth keep all of their
+             *                   points.
+             */
+            builder(uint32_t capacity = 16384, uint8_t depth = 16);
+
+            /**
+             * Makes room for an amount of points in total.
+             */
+            void reserve(uint64_t count);
+
+            /**
+             * Adds a point.
+             */
+            void add(const vector &position, const color &c);
+
+            /**
+             * Adds all points of a chunk.
+             */
+            void add(const points &source);
+
+            /**
+             * Retrieves the amount of points added.
+             */
+            uint64_t size() const;
+
+            /**
+             * Writes the catalog file, and removes all points.
+             *
+             * Throws an error if the file cannot be written.
+             */
+            void write(const std::string &path);
+        };
+
+        /**
+         * Builds a catalog file from chunks of points.
+         *
+         * Building holds a copy of all source points in memory, while drawing the result does
+         * not. Use a builder to add points without holding them twice.
+         *
+         * @param  path      Path of the catalog file to write.
+         * @param  source    Points to store.
+         * @param  capacity  Points sampled into each node.
+         * @param  depth     Maximum depth of the tree. Nodes at this depth keep all of their points.
+         */
+        static void build(const std::string &path, const std::vector<points> &source,
+          uint32_t capacity = 16384, uint8_t depth = 16);
+
+    protected:
+        /**
+         * Residency states of a node.
+         */
+        enum class state : uint8_t
+        {
+            absent,
+            queued,
+            loading,
+            resident
+        };
+
+        // Mapped catalog file.
+        mapped_file m_file;
+
+        // Node table, copied from the file.
+        std::vector<node> m_nodes;
+
+        // Residency of each node, shared with the loader thread.
+        std::unique_ptr<std::atomic<uint8_t>[]> m_states;
+
+        // Update in which each node was last selected.
+        std::vector<uint64_t> m_used;
+
+        // Update counter.
+        uint64_t m_update;
+
+        // Bytes of node data currently fetched, and of vertices expanded from it for drawing.
+        std::atomic<uint64_t> m_resident;
+        uint64_t m_expanded;
+
+        // Limits on mapped node data, and on points drawn per frame.
+        uint64_t m_memory_budget;
+        uint32_t m_point_budget;
+
+        // Largest tolerated projected point spacing, in pixels.
+        number m_error;
+
+        // Selected nodes which are resident, most visible first.
+        std::vector<uint32_t> m_selected;
+
+        // Vertices of selected, resident nodes.
+        std::unordered_map<uint32_t, vertices> m_vertices;
+
+        // Loader thread, and its queue of nodes to fetch, most important first.
+        std::thread m_loader;
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::deque<uint32_t> m_queue;
+        bool m_stop;
+
+        /**
+         * Retrieves the amount of bytes of a node's point data.
+         */
+        uint64_t get_bytes(uint32_t index) const;
+
+        /**
+         * Retrieves the amount of bytes of vertices a node's points expand into for drawing.
+         */
+        uint64_t get_expanded_bytes(uint32_t index) const;
+
+        /**
+         * Loader thread loop.
+         */
+        void load();
+
+        /**
+         * Gives back nodes not selected in the current update, least recently used first, until
+         * resident data and expanded vertices fit the memory budget together.
+         */
+        void evict();
+
+    public:
+        /**
+         * Constructor.
+         */
+        catalog();
+
+        /**
+         * Destructor.
+         */
+        virtual ~catalog();
+
+        /**
+         * Opens a catalog file, closing any previously open catalog.
+         *
+         * Throws an error if the file cannot be mapped, or is not a valid catalog.
+         */
+        void open(const std::string &path);
+
+        /**
+         * Closes the catalog, stopping the loader.
+         */
+        void close();
+
+        /**
+         * Sets the limit on fetched node data and the vertices expanded from it, in bytes.
+         */
+        void set_memory_budget(uint64_t bytes);
+
+        /**
+         * Sets the limit on points selected for drawing.
+         */
+        void set_point_budget(uint32_t count);
+
+        /**
+         * Sets the largest projected spacing between points, in pixels, before finer nodes are
+         * selected.
+         */
+        void set_error(number pixels);
+
+        /**
+         * Selects nodes to draw from a camera, requests missing nodes, and releases unused ones.
+         *
+         * @param  view    Camera to draw from.
+         * @param  height  Height of the viewport, in pixels.
+         */
+        void update(const camera &view, number height);
+
+        /**
+         * Retrieves the amount of nodes in the catalog.
+         */
+        uint32_t get_node_count() const;
+
+        /**
+         * Retrieves a node.
+         */
+        const node& get_node(uint32_t index) const;
+
+        /**
+         * Retrieves the nodes selected by the last update which are resident, most visible first.
+         */
+        const std::vector<uint32_t>& get_selected() const;
+
+        /**
+         * Retrieves the amount of bytes of node data currently fetched, and of vertices expanded
+         * from it for drawing.
+         */
+        uint64_t get_resident() const;
+
+        /**
+         * Draws selected nodes.
+         */
+        virtual void draw(canvas *target) const override;
+    };
+}
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef COSMODON_RENDER_FRUSTUM_HPP
+#define COSMODON_RENDER_FRUSTUM_HPP
+
+#include "bounds.hpp"
+#include "matrix.hpp"
+#include "vector.hpp"
+
+namespace cosmodon
+{
+    /**
+     * The volume seen through a camera, bounded by six planes.
+     */
+    class frustum
+    {
+    public:
+        /**
+         * Planes of a frustum.
+         */
+        enum class side : uint8_t
+        {
+            left,
+            right,
+            bottom,
+            top,
+            near,
+            far
+        };
+
+    protected:
+        // Plane equations a, b, c, d, with a unit normal facing inwards, so that points inside
+        // satisfy a*x + b*y + c*z + d >= 0.
+        number m_planes[6][4];
+
+    public:
+        /**
+         * Constructor, creating a frustum which contains everything.
+         */
+        frustum();
+
+        /**
+         * Constructor, extracting planes from a view-projection matrix.
+         */
+        frustum(const matrix &view_projection);
+
+        /**
+         * Extracts planes from a view-projection matrix.
+         */
+        void set(const matrix &view_projection);
+
+        /**
+         * Retrieves the equation a, b, c, d of a plane.
+         */
+        const number* get_plane(side plane) const;
+
+        /**
+         * Retrieves the signed distance of a point to a plane, positive on the inside.
+         */
+        number get_distance(side plane, const vector &point) const;
+
+        /**
+         * Checks if a point is inside.
+         */
+        bool contains(const vector &point) const;
+
+        /**
+         * Checks if a sphere is at least partly inside.
+         */
+        bool intersects(const vector &center, number radius) const;
+
+        /**
+         * Checks if a box is at least partly inside.
+         *
+         * Conservative: boxes near frustum corners may pass without being visible.
+         */
+        bool intersects(const bounds &box) const;
+    };
+}
+
+#endif
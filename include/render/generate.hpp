@@ -1,6 +1,9 @@
 #ifndef COSMODON_RENDER_GENERATE_HPP
 #define COSMODON_RENDER_GENERATE_HPP
 
+#include <vector>
+#include "../common/pool.hpp"
+#include "points.hpp"
 #include "vertex.hpp"
 
 namespace cosmodon
@@ -39,6 +42,55 @@ namespace cosmodon
          * Generates a pyramid.
          */
         void pyramid(vertices &v, number width, number height);
+
+        /**
+         * Generates a line list of the edges of a triangle list.
+         *
+         * Edges shared between triangles are only generated once, so outlines drawn from the
+         * result touch every edge a single time. Sets the primitive of the appended vertices to
+         * lines.
+         *
+         * @param  v          Vertices collection to append.
+         * @param  triangles  Triangle list to outline.
+         */
+        void wireframe(vertices &v, const vertices &triangles);
+
+        /**
+         * Generates a spherical field of stars.
+         *
+         * Point generators fill a grid of cells by cells by cells chunks, covering the cube around
+         * a sphere of the given radius. Chunk (x, y, z) is at index (z * cells + y) * cells + x,
+         * and previous chunk contents are replaced. Points are generated in fixed blocks, each
+         * with its own random stream, so equal seeds give equal chunks regardless of how many
+         * threads generate them.
+         *
+         * @param  chunks   Chunks to fill.
+         * @param  count    Amount of stars.
+         * @param  radius   Radius of the field.
+         * @param  cells    Chunks along each axis.
+         * @param  seed     Seed of all random streams.
+         * @param  workers  Threads to generate with, or a null pointer for the calling thread.
+         */
+        void starfield(std::vector<points> &chunks, uint64_t count, number radius, uint8_t cells,
+          uint32_t seed, pool *workers = nullptr);
+
+        /**
+         * Generates a spiral galaxy in the xy-plane, with a central bulge and logarithmic arms.
+         *
+         * See starfield() for how points are chunked.
+         *
+         * @param  arms  Amount of spiral arms.
+         */
+        void galaxy(std::vector<points> &chunks, uint64_t count, number radius, uint8_t arms,
+          uint8_t cells, uint32_t seed, pool *workers = nullptr);
+
+        /**
+         * Generates a nebula of faint gas particles, clumped into overlapping clouds.
+         *
+         * See starfield() for how points are chunked.
+         */
+        void nebula(std::vector<points> &chunks, uint64_t count, number radius, uint8_t cells,
+          uint32_t seed, pool *workers = nullptr);
     }
 }
 
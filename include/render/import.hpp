@@ -0,0 +1,139 @@
+#ifndef COSMODON_RENDER_IMPORT_HPP
+#define COSMODON_RENDER_IMPORT_HPP
+
+#include <string>
+#include <vector>
+#include "../common/pool.hpp"
+#include "points.hpp"
+#include "vertices.hpp"
+
+namespace cosmodon
+{
+    namespace import
+    {
+        /**
+         * Statistics of an import.
+         */
+        struct report
+        {
+            // Bytes of input read.
+            uint64_t bytes;
+
+            // Data lines read, not counting blank lines, comments, and skipped headers.
+            uint64_t lines;
+
+            // Records imported.
+            uint64_t records;
+
+            // Data lines which could not be parsed.
+            uint64_t rejected;
+
+            // Time spent, in seconds.
+            number seconds;
+
+            /**
+             * Constructor.
+             */
+            report();
+
+            /**
+             * Retrieves the input read per second, in megabytes.
+             */
+            number get_bandwidth() const;
+        };
+
+        /**
+         * Layout of a text table of stars.
+         */
+        struct table
+        {
+            // Marks an absent column.
+            static const uint8_t none = 255;
+
+            // Column indices of each field, counting from zero.
+            uint8_t x;
+            uint8_t y;
+            uint8_t z;
+            uint8_t magnitude;
+            uint8_t color_index;
+
+            // Field separator, or zero for runs of spaces and tabs.
+            char separator;
+
+            // Lines to skip at the start, such as column names.
+            uint32_t header;
+
+            // Apparent magnitudes drawn fully opaque, and faintest.
+            number bright;
+            number faint;
+
+            /**
+             * Constructor.
+             *
+             * Defaults to comma-separated x, y, z, magnitude, and B-V color index, without header.
+             */
+            table();
+        };
+
+        /**
+         * Imports a text table of stars, in comma-separated or whitespace-separated form.
+         *
+         * The file is mapped and split into blocks at line boundaries, which are parsed in
+         * parallel. Blank lines and lines starting with '#' are ignored. Magnitudes set point
+         * brightness, and B-V color indices set point colors. Points are chunked as by
+         * generate::starfield(), over the cube around all imported stars.
+         *
+         * @param  chunks   Chunks to fill, replacing their contents.
+         * @param  path     Path of the table.
+         * @param  columns  Layout of the table.
+         * @param  cells    Chunks along each axis.
+         * @param  workers  Threads to parse with, or a null pointer for the calling thread.
+         */
+        report stars(std::vector<points> &chunks, const std::string &path, const table &columns = table(),
+          uint8_t cells = 8, pool *workers = nullptr);
+
+        /**
+         * Imports a text table of stars, and writes it out as a catalog file to draw from.
+         *
+         * Stars go into the catalog as their blocks are parsed, so each is held in memory once,
+         * at full precision. The report includes time spent building the catalog.
+         *
+         * @param  source       Path of the table.
+         * @param  destination  Path of the catalog file.
+         */
+        report stars(const std::string &source, const std::string &destination,
+          const table &columns = table(), pool *workers = nullptr);
+
+        /**
+         * Imports a Wavefront OBJ mesh as indexed triangles.
+         *
+         * The file is mapped, counted, and parsed in blocks in parallel, straight into storage
+         * sized up front. Faces are split into triangle fans, and texture coordinates, normals,
+         * and materials are ignored. Vertex colors following positions are kept, and vertices
+         * are white otherwise. The report counts triangles as records.
+         *
+         * @param  v        Vertices to replace with the mesh.
+         * @param  path     Path of the mesh.
+         * @param  workers  Threads to parse with, or a null pointer for the calling thread.
+         */
+        report obj(vertices &v, const std::string &path, pool *workers = nullptr);
+
+        /**
+         * Imports all triangle meshes of a binary glTF file (.glb) as indexed triangles.
+         *
+         * Positions, first vertex colors, and indices are converted in parallel, straight into
+         * storage sized up front. Data must be in the file's binary chunk. Node transformations
+         * are not applied, and primitives other than triangle lists are skipped and counted as
+         * rejected. The report counts triangles as records.
+         *
+         * Throws an error if the file is not valid binary glTF.
+         *
+         * @param  v        Vertices to replace with the meshes.
+         * @param  path     Path of the file.
+         * @param  workers  Threads to convert with, or a null pointer for the calling thread.
+         */
+        report gltf(vertices &v, const std::string &path, pool *workers = nullptr);
+    }
+}
+
+#endif
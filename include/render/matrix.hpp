@@ -57,6 +57,11 @@ namespace cosmodon
             number w0, number w1, number w2, number w3
         );
 
+        /**
+         * Sets matrix values from a row-major array of 16 values.
+         */
+        void set(const number *values);
+
         /**
          * Retrieve raw matrix values as an array.
          */
@@ -97,6 +102,13 @@ namespace cosmodon
          */
         void set_rotation_z(number radians);
 
+        /**
+         * Computes the inverse of this matrix.
+         *
+         * Returns a matrix of zeroes when this matrix has no inverse.
+         */
+        matrix inverse() const;
+
         /**
          * Swaps this matrix with a different matrix.
          */
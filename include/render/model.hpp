@@ -27,6 +27,11 @@ namespace cosmodon
          */
         virtual vector get_center() const override;
 
+        /**
+         * Gets the box around the model in absolute coordinates.
+         */
+        bounds get_world_bounds() const;
+
         /**
          * Sets fill mode.
          */
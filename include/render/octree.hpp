@@ -0,0 +1,190 @@
+#ifndef COSMODON_RENDER_OCTREE_HPP
+#define COSMODON_RENDER_OCTREE_HPP
+
+#include <cstdint>
+#include <vector>
+#include "bounds.hpp"
+#include "frustum.hpp"
+#include "ray.hpp"
+
+namespace cosmodon
+{
+    /**
+     * A loose octree over object bounds.
+     *
+     * Every cell reaches half its size past its edges, so an object fits the deepest cell whose
+     * size is at least its own, chosen by the object's center alone. Placing an object is a
+     * direct calculation instead of a search, and objects moving within their cell are updated
+     * without touching the tree.
+     *
+     * Queries only read the tree, and may run on many threads at once, as long as no object is
+     * inserted, moved or removed meanwhile.
+     */
+    class octree
+    {
+    public:
+        /**
+         * Identifies an object in the tree.
+         */
+        typedef uint32_t handle;
+
+        /**
+         * Handle meaning no object.
+         */
+        static const handle none = 0xffffffff;
+
+    protected:
+        // A cell.
+        struct node
+        {
+            // Loose bounds.
+            bounds box;
+
+            // Child cells by octant, or none.
+            uint32_t children[8];
+
+            // Parent cell, or none for the root.
+            uint32_t parent;
+
+            // First object stored in this cell, or none.
+            handle first;
+
+            // Objects stored in this cell and all cells below.
+            uint32_t count;
+        };
+
+        // An object.
+        struct entry
+        {
+            // Object bounds.
+            bounds box;
+
+            // Cell storing this object, or none if this entry is free.
+            uint32_t cell;
+
+            // Neighbours in the object list of the cell, or the next free entry.
+            handle previous;
+            handle next;
+        };
+
+        // Region covered by cells, as a cube.
+        vector m_low;
+        number m_size;
+
+        // Deepest level of cells.
+        uint8_t m_depth;
+
+        // Cells, root first.
+        std::vector<node> m_nodes;
+
+        // Objects, by handle.
+        std::vector<entry> m_entries;
+
+        // First free entry, or none.
+        handle m_free;
+
+        // Amount of objects.
+        uint32_t m_count;
+
+        /**
+         * Finds the cell an object belongs in, creating it and its parents if needed.
+         */
+        uint32_t place(const bounds &box);
+
+        /**
+         * Links an object into a cell.
+         */
+        void link(handle object, uint32_t cell);
+
+        /**
+         * Unlinks an object from its cell.
+         */
+        void unlink(handle object);
+
+        /**
+         * Collects objects from cells and objects accepted by a test.
+         */
+        template <typename test>
+        void collect(test accept, std::vector<handle> &results) const;
+
+    public:
+        /**
+         * Constructor.
+         *
+         * Objects outside the region are still stored, but are tested by every query.
+         *
+         * @param  region  Region to divide into cells, extended to a cube.
+         * @param  depth   Deepest level of cells, below the root.
+         */
+        octree(const bounds &region = bounds(vector(-1024, -1024, -1024), vector(1024, 1024, 1024)), uint8_t depth = 8);
+
+        /**
+         * Removes all objects, and changes the region divided into cells.
+         */
+        void reset(const bounds &region, uint8_t depth = 8);
+
+        /**
+         * Removes all objects.
+         */
+        void clear();
+
+        /**
+         * Retrieves the amount of objects.
+         */
+        uint32_t size() const;
+
+        /**
+         * Adds an object.
+         *
+         * @return  Handle of the object.
+         */
+        handle insert(const bounds &box);
+
+        /**
+         * Changes the bounds of an object.
+         *
+         * Objects staying in their cell are only updated in place. Others are moved in constant
+         * time, bounded by tree depth.
+         */
+        void move(handle object, const bounds &box);
+
+        /**
+         * Changes the bounds of many objects.
+         */
+        void move(const handle *objects, const bounds *boxes, uint32_t count);
+
+        /**
+         * Removes an object. Its handle may be reused by later insertions.
+         */
+        void remove(handle object);
+
+        /**
+         * Retrieves the bounds of an object.
+         */
+        const bounds& get_bounds(handle object) const;
+
+        /**
+         * Finds objects at least partly inside a frustum.
+         *
+         * This and other queries append handles to results, in no particular order.
+         */
+        void query(const frustum &volume, std::vector<handle> &results) const;
+
+        /**
+         * Finds objects overlapping a box.
+         */
+        void query(const bounds &box, std::vector<handle> &results) const;
+
+        /**
+         * Finds objects overlapping a sphere.
+         */
+        void query(const vector &center, number radius, std::vector<handle> &results) const;
+
+        /**
+         * Finds objects whose bounds are crossed by a ray within a distance.
+         */
+        void query(const ray &r, number distance, std::vector<handle> &results) const;
+    };
+}
+
+#endif
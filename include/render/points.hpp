@@ -0,0 +1,135 @@
+#ifndef COSMODON_RENDER_POINTS_HPP
+#define COSMODON_RENDER_POINTS_HPP
+
+#include <vector>
+#include "color.hpp"
+#include "vector.hpp"
+
+namespace cosmodon
+{
+    class vertices;
+
+    /**
+     * A compact chunk of colored points, confined to a cubic cell of space.
+     *
+     * Positions are quantized to 16 bits per axis within the cell, and colors to 8 bits per
+     * channel, so each point takes 10 bytes instead of a full vertex. Chunks can be stored,
+     * streamed, and culled independently, then expanded into vertices for drawing.
+     */
+    class points
+    {
+    public:
+        /**
+         * A quantized point.
+         */
+        struct point
+        {
+            // Position within the cell, from 0 at the cell origin to 65535 at its far corner.
+            uint16_t x;
+            uint16_t y;
+            uint16_t z;
+
+            // Color.
+            uint8_t r;
+            uint8_t g;
+            uint8_t b;
+            uint8_t a;
+        };
+
+    protected:
+        // Corner of the cell with the lowest coordinates.
+        vector m_origin;
+
+        // Length of each side of the cell.
+        number m_extent;
+
+        // Quantized points.
+        std::vector<point> m_points;
+
+    public:
+        /**
+         * Constructor.
+         */
+        points(vector origin = vector(), number extent = 1);
+
+        /**
+         * Sets the cell, without moving the stored quantized points.
+         */
+        void set_cell(vector origin, number extent);
+
+        /**
+         * Retrieves the corner of the cell with the lowest coordinates.
+         */
+        vector get_origin() const;
+
+        /**
+         * Retrieves the length of each side of the cell.
+         */
+        number get_extent() const;
+
+        /**
+         * Retrieves the point count of this chunk.
+         */
+        uint32_t size() const;
+
+        /**
+         * Changes the point count of this chunk.
+         */
+        void resize(uint32_t amount);
+
+        /**
+         * Reserves storage for a point count.
+         */
+        void reserve(uint32_t amount);
+
+        /**
+         * Removes all points.
+         */
+        void clear();
+
+        /**
+         * Quantizes a point. Positions outside the cell are clamped to it.
+         */
+        point quantize(const vector &position, const color &c) const;
+
+        /**
+         * Adds a point to the chunk.
+         */
+        void add(const vector &position, const color &c);
+
+        /**
+         * Retrieves the position of a point.
+         */
+        vector get_position(uint32_t index) const;
+
+        /**
+         * Retrieves the color of a point.
+         */
+        color get_color(uint32_t index) const;
+
+        /**
+         * Appends all points to a collection of vertices, as point primitives.
+         */
+        void expand(vertices &v) const;
+
+        /**
+         * Appends quantized points stored elsewhere, such as in a mapped file, to a collection
+         * of vertices, as point primitives.
+         */
+        static void expand(vertices &v, const point *source, uint32_t count, vector origin, number extent);
+
+        /**
+         * Retrieves raw point storage.
+         */
+        point* data();
+        const point* data() const;
+
+        /**
+         * Data access operators.
+         */
+        point& operator [](const uint32_t index);
+        const point& operator [](const uint32_t index) const;
+    };
+}
+
+#endif
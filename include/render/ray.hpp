@@ -0,0 +1,34 @@
+#ifndef COSMODON_RENDER_RAY_HPP
+#define COSMODON_RENDER_RAY_HPP
+
+#include "vector.hpp"
+
+namespace cosmodon
+{
+    /**
+     * A half-line, starting at an origin and extending along a direction.
+     */
+    class ray
+    {
+    public:
+        // Starting point.
+        vector origin;
+
+        // Direction, of unit length.
+        vector direction;
+
+        /**
+         * Constructor.
+         *
+         * Normalizes the direction.
+         */
+        ray(const vector &init_origin = vector(), const vector &init_direction = vector(0, 0, -1));
+
+        /**
+         * Retrieves the point at a distance along this ray.
+         */
+        vector at(number distance) const;
+    };
+}
+
+#endif
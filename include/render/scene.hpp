@@ -0,0 +1,84 @@
+#ifndef COSMODON_RENDER_SCENE_HPP
+#define COSMODON_RENDER_SCENE_HPP
+
+#include <vector>
+#include "../common/pool.hpp"
+#include "bvh.hpp"
+#include "model.hpp"
+
+namespace cosmodon
+{
+    /**
+     * A collection of models, for ray queries against all of them.
+     *
+     * Keeps a hierarchy over the bounds of models, and traces rays into the triangle hierarchy
+     * of each model they may hit. Models and hierarchies are referenced, not copied, and must
+     * outlive the scene.
+     */
+    class scene
+    {
+    protected:
+        // A model, its triangles, and its transformation from world to model space.
+        struct entry
+        {
+            const model *object;
+            const bvh *mesh;
+            matrix inverse;
+        };
+
+        // Models in the scene.
+        std::vector<entry> m_entries;
+
+        // Hierarchy over model bounds in world space.
+        bvh m_tree;
+
+    public:
+        /**
+         * Adds a model, with a hierarchy built over its vertices.
+         *
+         * @return  Index of the model, reported by hits.
+         */
+        uint32_t add(const model &object, const bvh &mesh);
+
+        /**
+         * Removes all models.
+         */
+        void clear();
+
+        /**
+         * Retrieves the amount of models.
+         */
+        uint32_t size() const;
+
+        /**
+         * Retrieves a model by index.
+         */
+        const model& get_model(uint32_t index) const;
+
+        /**
+         * Rebuilds the hierarchy over model bounds.
+         *
+         * Must be called after adding models and after models are transformed, before queries.
+         */
+        void update();
+
+        /**
+         * Finds the nearest model triangle hit by a ray.
+         *
+         * @return  Whether a triangle nearer than the hit's current distance was found.
+         */
+        bool intersect(const ray &r, bvh::hit &result) const;
+
+        /**
+         * Finds the nearest model triangles hit by many rays.
+         *
+         * @param  rays     Rays in world space.
+         * @param  results  Results, only replaced by hits nearer than their current distance.
+         * @param  count    Amount of rays.
+         * @param  threads  Pool to split rays across, or null to trace on the calling thread.
+         */
+        void intersect(const ray *rays, bvh::hit *results, uint32_t count, pool *threads = nullptr) const;
+    };
+}
+
+#endif
@@ -29,15 +29,24 @@ namespace cosmodon
         // Rotation matrix, about the z-axis.
         matrix m_rotation_z;
 
-        // Resulting transformation matrix.
-        matrix m_result;
+        // Resulting transformation matrix, computed on first use after a change.
+        mutable matrix m_result;
+        mutable bool m_stale;
+
+        // Whether the result changed since last marked clean.
+        bool m_dirty;
 
         /**
-         * Updates result matrix.
+         * Marks the result matrix as outdated.
          */
         void update();
 
     public:
+        /**
+         * Constructor.
+         */
+        transformation();
+
         /**
          * Sets the absolute scale.
          */
@@ -74,9 +83,24 @@ namespace cosmodon
 
         /**
          * Returns the resulting transformation matrix.
+         *
+         * Computed once after each change, so moving an object many times costs one product.
+         * Retrieve it before sharing a changed transformation between threads.
          */
         const matrix& get_matrix() const;
 
+        /**
+         * Checks if the transformation changed since last marked clean.
+         *
+         * Lets systems holding derived data, like spatial indices, update only what moved.
+         */
+        bool is_dirty() const;
+
+        /**
+         * Marks the transformation as unchanged.
+         */
+        void set_clean();
+
         /**
          * Convert to matrix, outputting the result matrix.
          */
@@ -1,6 +1,7 @@
 #ifndef COSMODON_RENDER_VERTICES_HPP
 #define COSMODON_RENDER_VERTICES_HPP
 
+#include "bounds.hpp"
 #include "vertex.hpp"
 #include "primitive.hpp"
 #include "transformation.hpp"
@@ -19,6 +20,12 @@ namespace cosmodon
         // Primitive explaining how vertices should be drawn.
         cosmodon::primitive m_primitive;
 
+        // Indices of vertices in drawing order, or empty to draw vertices in storage order.
+        std::vector<uint32_t> m_indices;
+
+        // Whether vertex alpha should be blended.
+        bool m_transparent;
+
     public:
         /**
          * Constructor.
@@ -31,7 +38,7 @@ namespace cosmodon
         ~vertices();
 
         /**
-         * Clears this collection of all vertices.
+         * Clears this collection of all vertices and indices.
          */
         void clear();
         
@@ -51,14 +58,30 @@ namespace cosmodon
 
         /**
          * Adds a set of vertices to the collection.
+         *
+         * Indexed sets stay indexed when added to an empty or indexed collection, and are added
+         * in drawing order otherwise.
          */
         void add(const vertices& verts);
 
+        /**
+         * Adds the index of a vertex to draw.
+         *
+         * Once indexed, a collection draws only the vertices its indices refer to, in index
+         * order, so shared vertices are stored once.
+         */
+        void add_index(uint32_t index);
+
         /**
          * Retrieves center vertex.
          */
         virtual vector get_center() const;
 
+        /**
+         * Retrieves the box around all stored vertices, without transformation.
+         */
+        bounds get_bounds() const;
+
         /**
          * Retrieves the vertex count of this collection.
          */
@@ -69,6 +92,47 @@ namespace cosmodon
          */
         void resize(uint32_t amount);
 
+        /**
+         * Reserves storage for a vertex count, so adding up to it does not reallocate.
+         */
+        void reserve(uint32_t amount);
+
+        /**
+         * Checks if this collection is drawn through indices.
+         */
+        bool is_indexed() const;
+
+        /**
+         * Retrieves the index count of this collection.
+         */
+        uint32_t get_index_count() const;
+
+        /**
+         * Changes the index count of this collection.
+         */
+        void resize_indices(uint32_t amount);
+
+        /**
+         * Reserves storage for an index count.
+         */
+        void reserve_indices(uint32_t amount);
+
+        /**
+         * Retrieves raw index storage.
+         */
+        uint32_t* get_indices();
+        const uint32_t* get_indices() const;
+
+        /**
+         * Retrieves the amount of vertices drawn, counting shared vertices once per use.
+         */
+        uint32_t get_drawn_count() const;
+
+        /**
+         * Retrieves a vertex by its position in drawing order.
+         */
+        const vertex& get_drawn(uint32_t index) const;
+
         /**
          * Sets the primitive of vertices.
          */
@@ -77,7 +141,20 @@ namespace cosmodon
         /**
          * Retrieves the primitive of vertices.
          */
-        cosmodon::primitive get_primitive();
+        cosmodon::primitive get_primitive() const;
+
+        /**
+         * Sets whether these vertices are see-through.
+         *
+         * Transparent vertices are blended using vertex alpha, and are drawn after opaque ones,
+         * back to front, by depth sorted command lists.
+         */
+        void set_transparent(bool transparent);
+
+        /**
+         * Checks if these vertices are see-through.
+         */
+        bool is_transparent() const;
 
         /**
          * Data access operators.
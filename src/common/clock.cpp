@@ -13,7 +13,7 @@ void cosmodon::clock::reset()
 }
 
 // Retrieve elapsed seconds.
-uint32_t cosmodon::clock::elapsed(cosmodon::unit unit, bool restart)
+uint64_t cosmodon::clock::elapsed(cosmodon::unit unit, bool restart)
 {
     // Determine result.
     std::chrono::high_resolution_clock::duration result;
@@ -0,0 +1,35 @@
+#include <common/hash.hpp>
+
+// Hash raw data.
+uint64_t cosmodon::hash::fnv(const void *data, size_t length, uint64_t value)
+{
+    const uint8_t *bytes = static_cast<const uint8_t*>(data);
+
+    for (size_t i = 0; i < length; i++) {
+        value ^= bytes[i];
+        value *= 1099511628211ULL;
+    }
+    return value;
+}
+
+// Hash a string.
+uint64_t cosmodon::hash::fnv(const std::string &data, uint64_t value)
+{
+    // Include the length, so consecutive strings cannot run into each other.
+    uint64_t length = data.size();
+    value = fnv(&length, sizeof(length), value);
+    return fnv(data.data(), data.size(), value);
+}
+
+// Format a hash.
+std::string cosmodon::hash::hex(uint64_t value)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string result(16, '0');
+
+    for (uint8_t i = 0; i < 16; i++) {
+        result[15 - i] = digits[value & 0xF];
+        value >>= 4;
+    }
+    return result;
+}
@@ -0,0 +1,124 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <common/exception.hpp>
+#include <common/mapped_file.hpp>
+
+// Local function to retrieve the size of a memory page.
+static uint64_t page_size()
+{
+    static const uint64_t size = ::sysconf(_SC_PAGESIZE);
+    return size;
+}
+
+// Constructor.
+cosmodon::mapped_file::mapped_file()
+  : m_data(nullptr), m_size(0), m_descriptor(-1)
+{
+
+}
+
+// Destructor.
+cosmodon::mapped_file::~mapped_file()
+{
+    close();
+}
+
+// Map a file.
+void cosmodon::mapped_file::open(const std::string &path)
+{
+    struct stat status;
+    void *mapping;
+
+    close();
+
+    // Open file.
+    m_descriptor = ::open(path.c_str(), O_RDONLY);
+    if (m_descriptor < 0) {
+        throw cosmodon::exception::error("Could not open file: " + path);
+    }
+    if (::fstat(m_descriptor, &status) != 0 || status.st_size <= 0) {
+        close();
+        throw cosmodon::exception::error("Could not map empty or unreadable file: " + path);
+    }
+
+    // Map file.
+    mapping = ::mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, m_descriptor, 0);
+    if (mapping == MAP_FAILED) {
+        close();
+        throw cosmodon::exception::error("Could not map file: " + path);
+    }
+    m_data = static_cast<uint8_t*>(mapping);
+    m_size = status.st_size;
+}
+
+// Unmap the file.
+void cosmodon::mapped_file::close()
+{
+    if (m_data != nullptr) {
+        ::munmap(m_data, m_size);
+        m_data = nullptr;
+        m_size = 0;
+    }
+    if (m_descriptor >= 0) {
+        ::close(m_descriptor);
+        m_descriptor = -1;
+    }
+}
+
+// Check if a file is mapped.
+bool cosmodon::mapped_file::is_open() const
+{
+    return m_data != nullptr;
+}
+
+// Retrieve mapped contents.
+const uint8_t* cosmodon::mapped_file::data() const
+{
+    return m_data;
+}
+
+// Retrieve file length.
+uint64_t cosmodon::mapped_file::size() const
+{
+    return m_size;
+}
+
+// Give the kernel an access hint.
+void cosmodon::mapped_file::advise(uint64_t offset, uint64_t length, cosmodon::mapped_file::advice hint) const
+{
+    const int hints[] = {MADV_NORMAL, MADV_SEQUENTIAL, MADV_RANDOM, MADV_WILLNEED, MADV_DONTNEED};
+    uint64_t start;
+
+    if (m_data == nullptr || offset >= m_size) {
+        return;
+    }
+    if (length > m_size - offset) {
+        length = m_size - offset;
+    }
+
+    // Widen to page boundaries, which madvise requires.
+    start = offset - offset % page_size();
+    length += offset - start;
+    ::madvise(m_data + start, length, hints[static_cast<uint8_t>(hint)]);
+}
+
+// Fault a range in.
+void cosmodon::mapped_file::touch(uint64_t offset, uint64_t length) const
+{
+    volatile uint8_t sink = 0;
+
+    if (m_data == nullptr || offset >= m_size) {
+        return;
+    }
+    if (length > m_size - offset) {
+        length = m_size - offset;
+    }
+    for (uint64_t i = offset; i < offset + length; i += page_size()) {
+        sink = sink + m_data[i];
+    }
+    if (length > 0) {
+        sink = sink + m_data[offset + length - 1];
+    }
+}
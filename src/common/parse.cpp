@@ -0,0 +1,201 @@
+#include <cmath>
+#include <cstring>
+#include <common/parse.hpp>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Powers of ten which are exact as doubles.
+static const double exact_powers[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Local function to check for a decimal digit.
+static bool is_digit(char c)
+{
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+// Local function to load eight digits at once, if the next eight characters are all digits.
+static bool eight_digits(const char *p, const char *end, uint32_t &value)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    uint64_t v;
+
+    if (end - p < 8) {
+        return false;
+    }
+    std::memcpy(&v, p, 8);
+
+    // All bytes are within '0' to '9' when both nibble tests pass.
+    if ((((v & 0xF0F0F0F0F0F0F0F0ULL) | (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4))
+      != 0x3333333333333333ULL)) {
+        return false;
+    }
+
+    // Combine digit pairs, then pairs of pairs, then both halves, within the register.
+    v -= 0x3030303030303030ULL;
+    v = (v * 10) + (v >> 8);
+    v = (((v & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+      (((v >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+    value = static_cast<uint32_t>(v);
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Local function to accumulate digits into a mantissa of up to 19 significant digits, returning
+// the amount of digits read. Digits past the point lower the exponent as they are kept, and
+// digits before it raise the exponent as they are dropped.
+static uint32_t read_digits(const char *&p, const char *end, bool fraction, uint64_t &mantissa,
+  uint32_t &kept, int32_t &exponent, bool &dropped)
+{
+    uint32_t count = 0;
+    uint32_t chunk;
+
+    while (kept + 8 <= 19 && eight_digits(p, end, chunk)) {
+        mantissa = mantissa * 100000000ULL + chunk;
+        kept = (mantissa == 0) ? 0 : kept + 8;
+        exponent -= fraction ? 8 : 0;
+        p += 8;
+        count += 8;
+    }
+    while (p < end && is_digit(*p)) {
+        if (kept < 19) {
+            mantissa = mantissa * 10 + (*p - '0');
+            kept = (mantissa == 0) ? 0 : kept + 1;
+            exponent -= fraction ? 1 : 0;
+        } else {
+            exponent += fraction ? 0 : 1;
+            dropped = true;
+        }
+        p++;
+        count++;
+    }
+    return count;
+}
+
+// Parse a real number.
+const char* cosmodon::parse::real(const char *begin, const char *end, cosmodon::number &value)
+{
+    const char *p = begin;
+    bool negative = false;
+    bool dropped = false;
+    uint64_t mantissa = 0;
+    uint32_t kept = 0;
+    uint32_t digits = 0;
+    int32_t exponent = 0;
+
+    // Sign.
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        p++;
+    }
+
+    // Integer and fractional parts.
+    digits += read_digits(p, end, false, mantissa, kept, exponent, dropped);
+    if (p < end && *p == '.') {
+        p++;
+        digits += read_digits(p, end, true, mantissa, kept, exponent, dropped);
+    }
+    if (digits == 0) {
+        return nullptr;
+    }
+
+    // Exponent, only if followed by digits.
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char *q = p + 1;
+        int64_t power;
+        if (q < end && *q == '+') {
+            q++;
+        }
+        if ((q = integer(q, end, power)) != nullptr) {
+            power = (power > 100000) ? 100000 : ((power < -100000) ? -100000 : power);
+            exponent += power;
+            p = q;
+        }
+    }
+
+    // Exact conversion, when mantissa and power of ten are both exact doubles.
+    if (!dropped && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+        double result = static_cast<double>(mantissa);
+        result = (exponent < 0) ? result / exact_powers[-exponent] : result * exact_powers[exponent];
+        value = static_cast<cosmodon::number>(negative ? -result : result);
+        return p;
+    }
+
+    // Scale in the widest type otherwise, which carries far more digits than a number keeps, so
+    // rounding to a number lands on the nearest value. Out of range results become infinity or
+    // zero.
+    long double result = (mantissa == 0) ? 0 : static_cast<long double>(mantissa) * std::pow(10.0L, exponent);
+    value = static_cast<cosmodon::number>(negative ? -result : result);
+    return p;
+}
+
+// Parse an integer.
+const char* cosmodon::parse::integer(const char *begin, const char *end, int64_t &value)
+{
+    const char *p = begin;
+    bool negative = false;
+    uint64_t result = 0;
+    uint32_t chunk;
+
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        p++;
+    }
+    if (p >= end || !is_digit(*p)) {
+        return nullptr;
+    }
+    if (eight_digits(p, end, chunk)) {
+        result = chunk;
+        p += 8;
+    }
+    while (p < end && is_digit(*p)) {
+        result = result * 10 + (*p - '0');
+        p++;
+    }
+    value = negative ? -static_cast<int64_t>(result) : static_cast<int64_t>(result);
+    return p;
+}
+
+// Find a character.
+const char* cosmodon::parse::find(const char *begin, const char *end, char c)
+{
+    const char *p = begin;
+
+#ifdef __SSE2__
+    const __m128i needle = _mm_set1_epi8(c);
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+#endif
+    while (p < end && *p != c) {
+        p++;
+    }
+    return p;
+}
+
+// Skip spaces and tabs.
+const char* cosmodon::parse::skip_space(const char *begin, const char *end)
+{
+    while (begin < end && (*begin == ' ' || *begin == '\t')) {
+        begin++;
+    }
+    return begin;
+}
+
+// Find the next line.
+const char* cosmodon::parse::next_line(const char *begin, const char *end)
+{
+    const char *p = find(begin, end, '\n');
+    return (p < end) ? p + 1 : end;
+}
@@ -0,0 +1,106 @@
+#include <common/pool.hpp>
+
+// Constructor.
+cosmodon::pool::pool(uint8_t threads)
+  : m_jobs(0), m_next(0), m_batch(0), m_busy(0), m_stop(false)
+{
+    // Default to one thread per hardware thread.
+    if (threads == 0) {
+        unsigned int hardware = std::thread::hardware_concurrency();
+        threads = (hardware == 0) ? 1 : ((hardware > 255) ? 255 : hardware);
+    }
+
+    // Start workers. The caller acts as thread 0.
+    for (uint8_t i = 1; i < threads; i++) {
+        m_threads.push_back(std::thread(&cosmodon::pool::loop, this, i));
+    }
+}
+
+// Destructor.
+cosmodon::pool::~pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_start.notify_all();
+
+    for (uint8_t i = 0; i < m_threads.size(); i++) {
+        m_threads[i].join();
+    }
+}
+
+// Retrieve thread count.
+uint8_t cosmodon::pool::size() const
+{
+    return m_threads.size() + 1;
+}
+
+// Claim and run jobs.
+void cosmodon::pool::work(uint8_t thread)
+{
+    uint32_t job;
+    while ((job = m_next.fetch_add(1)) < m_jobs) {
+        m_task(job, thread);
+    }
+}
+
+// Worker thread loop.
+void cosmodon::pool::loop(uint8_t thread)
+{
+    uint64_t batch = 0;
+
+    while (true) {
+        // Sleep until a new batch starts.
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start.wait(lock, [&] { return m_stop || m_batch != batch; });
+            if (m_stop) {
+                return;
+            }
+            batch = m_batch;
+        }
+
+        work(thread);
+
+        // Report completion.
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_busy--;
+        }
+        m_finish.notify_one();
+    }
+}
+
+// Run a batch of jobs.
+void cosmodon::pool::run(uint32_t jobs, const cosmodon::pool::task &function)
+{
+    if (jobs == 0) {
+        return;
+    }
+
+    // Small batches are not worth waking workers for.
+    if (jobs == 1 || m_threads.empty()) {
+        for (uint32_t i = 0; i < jobs; i++) {
+            function(i, 0);
+        }
+        return;
+    }
+
+    // Publish batch.
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_task = function;
+        m_jobs = jobs;
+        m_next = 0;
+        m_busy = m_threads.size();
+        m_batch++;
+    }
+    m_start.notify_all();
+
+    // Help out, then wait for workers.
+    work(0);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_finish.wait(lock, [&] { return m_busy == 0; });
+    m_task = nullptr;
+}
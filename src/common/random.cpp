@@ -1,3 +1,5 @@
+#include <cmath>
+#include <common/math.hpp>
 #include <common/random.hpp>
 
 // Seeds random operations with the current time.
@@ -17,3 +19,50 @@ uint32_t cosmodon::random::integer(uint32_t min, uint32_t max)
 {
     return std::rand() % (max - min + 1) + min;
 }
+
+// Stream constructor.
+cosmodon::random::stream::stream(uint64_t seed, uint64_t sequence)
+  : m_state(0), m_increment((sequence << 1) | 1)
+{
+    integer();
+    m_state += seed;
+    integer();
+}
+
+// Generate a random 32-bit integer.
+uint32_t cosmodon::random::stream::integer()
+{
+    uint64_t state = m_state;
+    m_state = state * 6364136223846793005ULL + m_increment;
+
+    uint32_t shifted = ((state >> 18) ^ state) >> 27;
+    uint32_t rotation = state >> 59;
+    return (shifted >> rotation) | (shifted << ((-rotation) & 31));
+}
+
+// Generate a random integer in a range.
+uint32_t cosmodon::random::stream::integer(uint32_t min, uint32_t max)
+{
+    uint64_t range = static_cast<uint64_t>(max) - min + 1;
+    return min + static_cast<uint32_t>((integer() * range) >> 32);
+}
+
+// Generate a random number in [0, 1).
+cosmodon::number cosmodon::random::stream::real()
+{
+    return (integer() >> 8) * (1.0f / 16777216.0f);
+}
+
+// Generate a random number in a range.
+cosmodon::number cosmodon::random::stream::real(number min, number max)
+{
+    return min + (max - min) * real();
+}
+
+// Generate a normally distributed random number.
+cosmodon::number cosmodon::random::stream::normal()
+{
+    number u = 1.0f - real();
+    number v = real();
+    return std::sqrt(-2.0f * std::log(u)) * std::cos(2.0f * cosmodon::math::pi * v);
+}
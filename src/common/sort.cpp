@@ -0,0 +1,76 @@
+#include <cstring>
+#include <common/sort.hpp>
+
+// Convert a real to an ordered key.
+uint32_t cosmodon::sort::key(cosmodon::number value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    // Negative reals order backwards, so flip all their bits. Positive reals only need to order
+    // after negative ones.
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
+// Pack a key and item.
+uint64_t cosmodon::sort::pack(uint32_t key, uint32_t item)
+{
+    return (static_cast<uint64_t>(key) << 32) | item;
+}
+
+// Retrieve a packed item.
+uint32_t cosmodon::sort::item(uint64_t packed)
+{
+    return static_cast<uint32_t>(packed);
+}
+
+// Radix sort packed values.
+void cosmodon::sort::radix(uint64_t *values, uint32_t count, uint64_t *scratch)
+{
+    const uint8_t shifts[3] = {32, 43, 54};
+    static thread_local uint32_t counts[3][2048];
+    uint64_t *source = values;
+    uint64_t *target = scratch;
+
+    if (count < 2) {
+        return;
+    }
+
+    // Count all digits in one pass.
+    std::memset(counts, 0, sizeof(counts));
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t v = values[i];
+        counts[0][(v >> 32) & 2047]++;
+        counts[1][(v >> 43) & 2047]++;
+        counts[2][(v >> 54) & 1023]++;
+    }
+
+    for (uint8_t pass = 0; pass < 3; pass++) {
+        uint32_t *bucket = counts[pass];
+        uint32_t total = 0;
+
+        // Skip passes which would not move anything.
+        if (bucket[(source[0] >> shifts[pass]) & 2047] == count) {
+            continue;
+        }
+
+        // Turn counts into starting offsets, then scatter.
+        for (uint32_t i = 0; i < 2048; i++) {
+            uint32_t amount = bucket[i];
+            bucket[i] = total;
+            total += amount;
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            uint64_t v = source[i];
+            target[bucket[(v >> shifts[pass]) & 2047]++] = v;
+        }
+
+        uint64_t *swap = source;
+        source = target;
+        target = swap;
+    }
+
+    if (source != values) {
+        std::memcpy(values, source, count * sizeof(uint64_t));
+    }
+}
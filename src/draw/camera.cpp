@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <common/simd.hpp>
 #include <draw/camera.hpp>
 
 // Camera constructor.
@@ -7,7 +9,8 @@ cosmodon::camera::camera()
   m_fov(90),
   m_aspect(0),
   m_near(0),
-  m_far(1)
+  m_far(1),
+  m_dirty(true)
 {
 
 }
@@ -26,6 +29,12 @@ void cosmodon::camera::set_fov(cosmodon::number degrees)
     update_projection();
 }
 
+// Retrieves vertical field of view.
+cosmodon::number cosmodon::camera::get_fov() const
+{
+    return m_fov;
+}
+
 // Sets aspect.
 void cosmodon::camera::set_aspect(cosmodon::number aspect)
 {
@@ -90,6 +99,7 @@ void cosmodon::camera::update_view()
         z.x, z.y, z.z, -z.dot(eye),
         0, 0, 0, 1.0f
     );
+    m_dirty = true;
 }
 
 // Updates the projection matrix.
@@ -98,6 +108,7 @@ void cosmodon::camera::update_projection()
     // Check for invalid parameters.
     if (m_fov == 0 || m_aspect == 0 || (m_near - m_far) == 0) {
         m_projection.set_identity();
+        m_dirty = true;
         return;
     }
 
@@ -111,6 +122,7 @@ void cosmodon::camera::update_projection()
         0, 0, ((m_far + m_near) / (m_near - m_far)), ((2*m_far*m_near)/(m_near - m_far)),
         0, 0, -1, 0
     );
+    m_dirty = true;
 }
 
 // Retrieves the orientation matrix.
@@ -124,3 +136,133 @@ const cosmodon::matrix& cosmodon::camera::get_projection() const
 {
     return m_projection;
 }
+
+// Rebuilds derived matrices.
+void cosmodon::camera::refresh() const
+{
+    if (!m_dirty) {
+        return;
+    }
+    m_view_projection = m_projection * m_view;
+    m_inverse_view = m_view.inverse();
+    m_inverse_view_projection = m_view_projection.inverse();
+    m_frustum.set(m_view_projection);
+    m_dirty = false;
+}
+
+// Retrieves the view-projection matrix.
+const cosmodon::matrix& cosmodon::camera::get_view_projection() const
+{
+    refresh();
+    return m_view_projection;
+}
+
+// Retrieves the inverse view matrix.
+const cosmodon::matrix& cosmodon::camera::get_inverse_view() const
+{
+    refresh();
+    return m_inverse_view;
+}
+
+// Retrieves the inverse view-projection matrix.
+const cosmodon::matrix& cosmodon::camera::get_inverse_view_projection() const
+{
+    refresh();
+    return m_inverse_view_projection;
+}
+
+// Retrieves the frustum.
+const cosmodon::frustum& cosmodon::camera::get_frustum() const
+{
+    refresh();
+    return m_frustum;
+}
+
+// Projects world points onto a screen.
+void cosmodon::camera::project(const cosmodon::vector *world, cosmodon::vector *screen, uint32_t count, cosmodon::number width, cosmodon::number height) const
+{
+    typedef cosmodon::simd::float4 float4;
+    const cosmodon::matrix &m = get_view_projection();
+
+    // Matrix rows, each value spread across four points.
+    float4 row[4][4];
+    for (uint8_t j = 0; j < 4; j++) {
+        for (uint8_t i = 0; i < 4; i++) {
+            row[j][i] = float4(m[j][i]);
+        }
+    }
+    const float4 zero(0);
+    const float4 one(1);
+    const float4 half_width(width / 2);
+    const float4 half_height(height / 2);
+    const float4 half(0.5f);
+
+    // Four points at a time, each axis in its own lanes. The last group repeats its final point.
+    for (uint32_t i = 0; i < count; i += 4) {
+        uint32_t n = std::min<uint32_t>(count - i, 4);
+        const cosmodon::vector &p0 = world[i];
+        const cosmodon::vector &p1 = world[i + std::min<uint32_t>(1, n - 1)];
+        const cosmodon::vector &p2 = world[i + std::min<uint32_t>(2, n - 1)];
+        const cosmodon::vector &p3 = world[i + n - 1];
+        float4 x(p0.x, p1.x, p2.x, p3.x);
+        float4 y(p0.y, p1.y, p2.y, p3.y);
+        float4 z(p0.z, p1.z, p2.z, p3.z);
+        float4 clip[4];
+        for (uint8_t j = 0; j < 4; j++) {
+            clip[j] = row[j][0] * x + row[j][1] * y + row[j][2] * z + row[j][3];
+        }
+
+        // Divide by w, then map to pixels and depth range. Points behind the camera divide by
+        // one instead, and are replaced afterwards.
+        float4 behind = clip[3] <= zero;
+        float4 w = select(behind, one, clip[3]);
+        float4 sx = select(behind, zero, clip[0] / w * half_width + half_width);
+        float4 sy = select(behind, zero, half_height - clip[1] / w * half_height);
+        float4 sz = select(behind, float4(-1), clip[2] / w * half + half);
+
+        cosmodon::number values[3][4];
+        sx.store(values[0]);
+        sy.store(values[1]);
+        sz.store(values[2]);
+        for (uint32_t k = 0; k < n; k++) {
+            screen[i + k] = cosmodon::vector(values[0][k], values[1][k], values[2][k]);
+        }
+    }
+}
+
+// Unprojects screen points into rays.
+void cosmodon::camera::unproject(const cosmodon::vector *screen, cosmodon::ray *rays, uint32_t count, cosmodon::number width, cosmodon::number height) const
+{
+    const cosmodon::matrix &m = get_inverse_view_projection();
+
+    cosmodon::simd::float4 column[4];
+    for (uint8_t i = 0; i < 4; i++) {
+        column[i] = cosmodon::simd::float4(m[0][i], m[1][i], m[2][i], m[3][i]);
+    }
+
+    // Points on the near and far planes share x and y, so z and w columns fold into them.
+    cosmodon::simd::float4 near = column[3] - column[2];
+    cosmodon::simd::float4 far = column[3] + column[2];
+
+    for (uint32_t i = 0; i < count; i++) {
+        cosmodon::number x = screen[i].x / width * 2 - 1;
+        cosmodon::number y = 1 - screen[i].y / height * 2;
+        cosmodon::simd::float4 plane = column[0] * cosmodon::simd::float4(x) + column[1] * cosmodon::simd::float4(y);
+        cosmodon::number a[4], b[4];
+        (plane + near).store(a);
+        (plane + far).store(b);
+
+        cosmodon::vector origin(a[0] / a[3], a[1] / a[3], a[2] / a[3]);
+        cosmodon::vector target(b[0] / b[3], b[1] / b[3], b[2] / b[3]);
+        rays[i] = cosmodon::ray(origin, target - origin);
+    }
+}
+
+// Retrieves the ray through a pixel.
+cosmodon::ray cosmodon::camera::get_ray(cosmodon::number x, cosmodon::number y, cosmodon::number width, cosmodon::number height) const
+{
+    cosmodon::vector point(x, y, 0);
+    cosmodon::ray result;
+    unproject(&point, &result, 1, width, height);
+    return result;
+}
@@ -6,6 +6,38 @@ void cosmodon::canvas::draw(const cosmodon::vertices *vertices, const cosmodon::
     draw(vertices, transform.get_matrix());
 }
 
+// Draw many copies of a collection of vertices.
+void cosmodon::canvas::draw_instanced(const cosmodon::vertices *vertices, const cosmodon::matrix *transforms,
+  const cosmodon::color *colors, uint32_t count, bool fill)
+{
+    // Untinted instances share the original vertices.
+    if (colors == nullptr) {
+        for (uint32_t i = 0; i < count; i++) {
+            draw(vertices, transforms[i], fill);
+        }
+        return;
+    }
+
+    // Tinted instances share a single scratch copy, recolored per instance.
+    cosmodon::vertices tinted = *vertices;
+    for (uint32_t i = 0; i < count; i++) {
+        for (uint32_t j = 0; j < tinted.size(); j++) {
+            const cosmodon::vertex &source = (*vertices)[j];
+            tinted[j].r = (source.r * colors[i].r) / 255;
+            tinted[j].g = (source.g * colors[i].g) / 255;
+            tinted[j].b = (source.b * colors[i].b) / 255;
+            tinted[j].a = (source.a * colors[i].a) / 255;
+        }
+        draw(&tinted, transforms[i], fill);
+    }
+}
+
+// Set blending. Ignored by default.
+void cosmodon::canvas::set_blend(bool blend)
+{
+
+}
+
 // Draw a graphic.
 void cosmodon::canvas::draw(const cosmodon::graphic *object)
 {
@@ -0,0 +1,187 @@
+#include <algorithm>
+#include <common/exception.hpp>
+#include <common/sort.hpp>
+#include <draw/command.hpp>
+
+// Forget recorded commands.
+void cosmodon::draw::command_list::reset()
+{
+    m_commands.clear();
+    m_order.clear();
+}
+
+// Retrieve recorded command count.
+uint32_t cosmodon::draw::command_list::size() const
+{
+    return m_commands.size();
+}
+
+// Record a draw.
+void cosmodon::draw::command_list::draw(const cosmodon::vertices *v, const cosmodon::matrix &transform, bool fill)
+{
+    const cosmodon::number *values = transform.raw();
+
+    m_order.clear();
+    m_commands.emplace_back();
+    command &record = m_commands.back();
+    record.operation = command::type::draw;
+    record.source = v;
+    record.fill = fill;
+    record.transparent = v->is_transparent();
+    for (uint8_t i = 0; i < 16; i++) {
+        record.transform[i] = values[i];
+    }
+}
+
+// Record a clear.
+void cosmodon::draw::command_list::clear(const cosmodon::color c)
+{
+    m_order.clear();
+    m_commands.emplace_back();
+    command &record = m_commands.back();
+    record.operation = command::type::clear;
+    record.source = nullptr;
+    record.background = c;
+}
+
+// Sort draws by depth.
+void cosmodon::draw::command_list::sort(const cosmodon::camera &view)
+{
+    sort(this, 1, view, m_order, m_scratch);
+}
+
+// Perform recorded commands.
+void cosmodon::draw::command_list::execute(cosmodon::canvas *target) const
+{
+    cosmodon::matrix transform;
+    bool blend = false;
+
+    if (!m_order.empty()) {
+        execute(this, m_order, target);
+        return;
+    }
+    for (uint32_t i = 0; i < m_commands.size(); i++) {
+        const command &record = m_commands[i];
+        bool transparent = (record.operation == command::type::draw && record.transparent);
+
+        if (transparent != blend) {
+            blend = transparent;
+            target->set_blend(blend);
+        }
+        if (record.operation == command::type::clear) {
+            target->clear(record.background);
+        } else {
+            transform.set(record.transform);
+            target->draw(record.source, transform, record.fill);
+        }
+    }
+    if (blend) {
+        target->set_blend(false);
+    }
+}
+
+// Order commands of several lists by depth.
+void cosmodon::draw::command_list::sort(const cosmodon::draw::command_list *lists, uint32_t count,
+  const cosmodon::camera &view, std::vector<uint64_t> &order, std::vector<uint64_t> &scratch)
+{
+    const cosmodon::matrix &matrix = view.get_view();
+    const cosmodon::number row[4] = {matrix[2][0], matrix[2][1], matrix[2][2], matrix[2][3]};
+    uint32_t total = 0;
+    uint32_t run = 0;
+    uint32_t opaque = 0;
+    uint32_t transparent = 0;
+
+    // Items hold a list index in 8 bits and a command index in 24 bits, so larger inputs would
+    // wrap into other commands.
+    if (count > 0x100) {
+        throw cosmodon::exception::error("Too many command lists to sort");
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        if (lists[i].m_commands.size() > 0x1000000) {
+            throw cosmodon::exception::error("Too many commands to sort");
+        }
+        total += lists[i].m_commands.size();
+    }
+    order.resize(total);
+    scratch.resize(total * 2);
+
+    // Opaque keys collect in the first half of scratch storage, and transparent keys in the
+    // second. Each run of draws ends at a clear, or after the last list.
+    auto finish_run = [&]() {
+        uint64_t *opaque_keys = scratch.data();
+        uint64_t *transparent_keys = scratch.data() + total;
+
+        cosmodon::sort::radix(opaque_keys, opaque, order.data() + run);
+        cosmodon::sort::radix(transparent_keys, transparent, order.data() + run);
+        std::copy(opaque_keys, opaque_keys + opaque, order.begin() + run);
+        std::copy(transparent_keys, transparent_keys + transparent, order.begin() + run + opaque);
+        run += opaque + transparent;
+        opaque = transparent = 0;
+    };
+
+    for (uint32_t i = 0; i < count; i++) {
+        const std::vector<command> &commands = lists[i].m_commands;
+        for (uint32_t j = 0; j < commands.size(); j++) {
+            const command &record = commands[j];
+            uint32_t item = (i << 24) | j;
+
+            // Clears end a run, and stay in place.
+            if (record.operation == command::type::clear) {
+                finish_run();
+                order[run++] = cosmodon::sort::pack(0, item);
+                continue;
+            }
+
+            // Key opaque draws by distance in front of the camera, and transparent draws by
+            // negated distance.
+            const number *t = record.transform;
+            number distance = -(row[0] * t[3] + row[1] * t[7] + row[2] * t[11] + row[3]);
+            if (record.transparent) {
+                scratch[total + transparent++] = cosmodon::sort::pack(cosmodon::sort::key(-distance), item);
+            } else {
+                scratch[opaque++] = cosmodon::sort::pack(cosmodon::sort::key(distance), item);
+            }
+        }
+    }
+    finish_run();
+}
+
+// Perform commands of several lists in order.
+void cosmodon::draw::command_list::execute(const cosmodon::draw::command_list *lists,
+  const std::vector<uint64_t> &order, cosmodon::canvas *target)
+{
+    cosmodon::matrix transform;
+    bool blend = false;
+
+    for (uint32_t i = 0; i < order.size(); i++) {
+        uint32_t item = cosmodon::sort::item(order[i]);
+        const command &record = lists[item >> 24].m_commands[item & 0xFFFFFF];
+        bool transparent = (record.operation == command::type::draw && record.transparent);
+
+        if (transparent != blend) {
+            blend = transparent;
+            target->set_blend(blend);
+        }
+        if (record.operation == command::type::clear) {
+            target->clear(record.background);
+        } else {
+            transform.set(record.transform);
+            target->draw(record.source, transform, record.fill);
+        }
+    }
+    if (blend) {
+        target->set_blend(false);
+    }
+}
+
+// Data access operator.
+cosmodon::draw::command& cosmodon::draw::command_list::operator [](const uint32_t index)
+{
+    return m_commands[index];
+}
+
+// Const data access operator.
+const cosmodon::draw::command& cosmodon::draw::command_list::operator [](const uint32_t index) const
+{
+    return m_commands[index];
+}
@@ -1,6 +1,78 @@
 #include <draw/driver.hpp>
 
+// Constructor.
+cosmodon::draw::driver::driver() : m_in_pass(false)
+{
+    m_current.reset(0);
+}
+
 uint32_t cosmodon::draw::driver::get_fps() const
 {
     return m_fps.get();
 }
+
+// Count a draw call.
+void cosmodon::draw::driver::count_draw(uint64_t vertices, uint64_t bytes)
+{
+    m_current.draws++;
+    m_current.vertices += vertices;
+    m_current.bytes += bytes;
+
+    if (m_in_pass) {
+        pass_record &pass = m_current.passes.back();
+        pass.draws++;
+        pass.vertices += vertices;
+        pass.bytes += bytes;
+    }
+}
+
+// Begin a pass.
+void cosmodon::draw::driver::begin_pass(const std::string &name)
+{
+    if (m_in_pass) {
+        end_pass();
+    }
+
+    m_current.passes.push_back(pass_record());
+    pass_record &pass = m_current.passes.back();
+    pass.name = name;
+    pass.cpu_time = 0;
+    pass.gpu_time = 0;
+    pass.draws = 0;
+    pass.vertices = 0;
+    pass.bytes = 0;
+
+    m_in_pass = true;
+    m_pass_clock.reset();
+}
+
+// End a pass.
+void cosmodon::draw::driver::end_pass()
+{
+    if (!m_in_pass) {
+        return;
+    }
+
+    m_current.passes.back().cpu_time = m_pass_clock.elapsed(cosmodon::unit::nanosecond);
+    m_in_pass = false;
+}
+
+// Complete the current frame.
+void cosmodon::draw::driver::finish_frame()
+{
+    uint64_t number = m_current.frame + 1;
+
+    end_pass();
+    m_current.cpu_time = m_frame_clock.elapsed(cosmodon::unit::nanosecond, true);
+
+    // Rotate records, reusing the oldest for the next frame.
+    std::swap(m_complete, m_pending);
+    std::swap(m_pending, m_current);
+    m_current.reset(number);
+}
+
+// Retrieve latest complete frame.
+const cosmodon::draw::frame_record& cosmodon::draw::driver::get_frame() const
+{
+    return m_complete;
+}
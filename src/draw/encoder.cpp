@@ -0,0 +1,58 @@
+#include <draw/encoder.hpp>
+
+// Constructor.
+cosmodon::draw::encoder::encoder(cosmodon::pool &workers)
+  : m_pool(workers), m_lists(workers.size())
+{
+
+}
+
+// Encode a scene.
+void cosmodon::draw::encoder::encode(const cosmodon::graphic *const *objects, uint32_t count,
+  const cosmodon::draw::encoder::filter &visible)
+{
+    uint32_t ranges = m_lists.size();
+
+    m_order.clear();
+
+    m_pool.run(ranges, [&](uint32_t range, uint8_t thread) {
+        command_list &list = m_lists[range];
+        uint32_t first = static_cast<uint64_t>(count) * range / ranges;
+        uint32_t last = static_cast<uint64_t>(count) * (range + 1) / ranges;
+
+        list.reset();
+        for (uint32_t i = first; i < last; i++) {
+            if (!visible || visible(objects[i])) {
+                list.draw(objects[i]);
+            }
+        }
+    });
+}
+
+// Sort encoded commands.
+void cosmodon::draw::encoder::sort(const cosmodon::camera &view)
+{
+    command_list::sort(m_lists.data(), m_lists.size(), view, m_order, m_scratch);
+}
+
+// Retrieve encoded command count.
+uint32_t cosmodon::draw::encoder::size() const
+{
+    uint32_t result = 0;
+    for (uint32_t i = 0; i < m_lists.size(); i++) {
+        result += m_lists[i].size();
+    }
+    return result;
+}
+
+// Perform encoded commands.
+void cosmodon::draw::encoder::execute(cosmodon::canvas *target) const
+{
+    if (!m_order.empty()) {
+        command_list::execute(m_lists.data(), m_order, target);
+        return;
+    }
+    for (uint32_t i = 0; i < m_lists.size(); i++) {
+        m_lists[i].execute(target);
+    }
+}
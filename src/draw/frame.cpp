@@ -0,0 +1,18 @@
+#include <draw/frame.hpp>
+
+// Frame record constructor.
+cosmodon::draw::frame_record::frame_record()
+{
+    reset(0);
+}
+
+// Reset frame record.
+void cosmodon::draw::frame_record::reset(uint64_t number)
+{
+    frame = number;
+    cpu_time = 0;
+    draws = 0;
+    vertices = 0;
+    bytes = 0;
+    passes.clear();
+}
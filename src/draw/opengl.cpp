@@ -1,9 +1,61 @@
+#include <cstdio>
+#include <fstream>
+#include <utility>
 #include <common/exception.hpp>
+#include <common/hash.hpp>
 #include <draw/opengl.hpp>
 
+// Identifies cached program binaries ("CSPB").
+static const uint32_t program_magic = 0x42505343;
+
+// Handle of no shader program.
+static const uint32_t no_program = 0xFFFFFFFF;
+
+// Query of GL_KHR_parallel_shader_compile, for headers which predate it.
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// Local function to retrieve the output of a shader or program build.
+static std::string build_log(GLuint object, bool program)
+{
+    GLint length = 0;
+    std::vector<GLchar> report;
+
+    if (program) {
+        ::glGetProgramiv(object, GL_INFO_LOG_LENGTH, &length);
+    } else {
+        ::glGetShaderiv(object, GL_INFO_LOG_LENGTH, &length);
+    }
+    if (length <= 0) {
+        return "";
+    }
+
+    report.resize(length + 1);
+    if (program) {
+        ::glGetProgramInfoLog(object, length, nullptr, report.data());
+    } else {
+        ::glGetShaderInfoLog(object, length, nullptr, report.data());
+    }
+    return std::string(report.data());
+}
+
 // Set total running OpenGL instances.
 uint8_t cosmodon::opengl::m_instances = 0;
 
+// Local function to map primitives to OpenGL drawing modes.
+static GLenum primitive_mode(cosmodon::primitive primitive)
+{
+    switch (primitive) {
+        case cosmodon::primitive::point:
+            return GL_POINTS;
+        case cosmodon::primitive::line:
+            return GL_LINES;
+        default:
+            return GL_TRIANGLES;
+    }
+}
+
 // Local callback function to handle GLFW errors.
 static void handle_glfw_error(int error, const char *description)
 {
@@ -12,7 +64,8 @@ static void handle_glfw_error(int error, const char *description)
 
 // Constructor.
 cosmodon::opengl::opengl(uint16_t width, uint16_t height, std::string title)
-  : m_width(width), m_height(height), m_camera(nullptr)
+  : m_batching(true), m_point_size(1), m_blend(false), m_shader_program(0), m_default_program(no_program),
+    m_parallel_compile(false), m_width(width), m_height(height), m_camera(nullptr)
 {
     // Ensure this is the only active instance. @@@ Change later.
     if (m_instances != 0) {
@@ -40,9 +93,18 @@ cosmodon::opengl::opengl(uint16_t width, uint16_t height, std::string title)
         throw cosmodon::exception::fatal("Failed to initialize GLEW.");
     }
 
+    // Let the driver compile shaders on as many threads as it likes.
+    if (GLEW_KHR_parallel_shader_compile) {
+        ::glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+        m_parallel_compile = true;
+    }
+
     // Generate OpenGL buffers.
     ::glGenBuffers(1, &m_positions);
     ::glGenBuffers(1, &m_colors);
+    ::glGenBuffers(1, &m_elements);
+    ::glGenBuffers(1, &m_instance_transforms);
+    ::glGenBuffers(1, &m_instance_colors);
 
     // Generate OpenGL vertex array objects.
     ::glGenVertexArrays(1, &m_array);
@@ -57,6 +119,9 @@ cosmodon::opengl::opengl(uint16_t width, uint16_t height, std::string title)
     ::glDepthRange(0.0f, 1.0f);
     ::glDisable(GL_DEPTH_CLAMP);
     //::glEnable(GL_DEPTH_CLAMP);
+
+    // Let shaders size points.
+    ::glEnable(GL_PROGRAM_POINT_SIZE);
 }
 
 // Destructor.
@@ -64,7 +129,22 @@ cosmodon::opengl::~opengl()
 {
     // Destroy OpenGL buffers.
     ::glDeleteBuffers(1, &m_positions);
-    ::glDeleteBuffers(1, &m_positions);
+    ::glDeleteBuffers(1, &m_colors);
+    ::glDeleteBuffers(1, &m_elements);
+    ::glDeleteBuffers(1, &m_instance_transforms);
+    ::glDeleteBuffers(1, &m_instance_colors);
+    ::glDeleteVertexArrays(1, &m_array);
+
+    // Destroy timer queries.
+    for (uint8_t i = 0; i < 2; i++) {
+        ::glDeleteQueries(m_queries[i].size(), m_queries[i].data());
+    }
+
+    // Destroy shader programs.
+    ::glUseProgram(0);
+    for (uint32_t i = 0; i < m_programs.size(); i++) {
+        delete_program(i);
+    }
 
     // Deinitialize GLFW.
     ::glfwTerminate();
@@ -76,67 +156,112 @@ cosmodon::opengl::~opengl()
 // Set the camera.
 void cosmodon::opengl::set_camera(const cosmodon::camera &camera)
 {
+    flush();
     m_camera = &camera;
 }
 
 // Clear drawing area using a color.
 void cosmodon::opengl::clear(const cosmodon::color color)
 {
+    flush();
     ::glClearColor(color.r / 255.0f, color.g / 255.0f, color.b / 255.0f, color.a / 255.0f);
     ::glClearDepth(1.0f);
+
+    // Depth writes are off while blending, which would also keep depth from clearing.
+    ::glDepthMask(GL_TRUE);
     ::glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    ::glDepthMask(m_blend ? GL_FALSE : GL_TRUE);
 }
 
-// Render vertices.
-void cosmodon::opengl::draw(const cosmodon::vertices *v, const cosmodon::matrix &transform, bool fill)
+// Upload vertex positions and colors.
+void cosmodon::opengl::upload(const GLfloat *positions, const GLubyte *colors, uint32_t count)
 {
-    uint32_t i, j;
-    GLfloat *positions;
-    GLfloat *colors;
-    cosmodon::vertices vertices = *v;
-    GLuint matrix_id;
-    const float *matrix_values;
-
-    static matrix identity;
+    // Point to vertex positions. The w component defaults to one.
+    ::glBindBuffer(GL_ARRAY_BUFFER, m_positions);
+    ::glBufferData(GL_ARRAY_BUFFER, count*3*sizeof(GLfloat), positions, GL_STREAM_DRAW);
+    ::glEnableVertexAttribArray(0);
+    ::glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
-    // Prepare vertices information.
-    uint32_t count = vertices.size() * 4;
+    // Point to vertex colors.
+    ::glBindBuffer(GL_ARRAY_BUFFER, m_colors);
+    ::glBufferData(GL_ARRAY_BUFFER, count*4*sizeof(GLubyte), colors, GL_STREAM_DRAW);
+    ::glEnableVertexAttribArray(1);
+    ::glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, 0);
+}
 
-    // Prepare correct filling mode.
-    ::glPolygonMode(GL_FRONT_AND_BACK, fill ? GL_FILL : GL_LINE);
+// Upload a collection of vertices.
+void cosmodon::opengl::upload(const cosmodon::vertices *v)
+{
+    uint32_t i, j, k;
+    const cosmodon::vertices &vertices = *v;
+
+    m_scratch.resize(vertices.size() * 3);
+    m_scratch_colors.resize(vertices.size() * 4);
+
+    // Get vertex positions and colors.
+    for (i = j = k = 0; i < vertices.size(); i++) {
+        m_scratch[j++] = vertices[i].x;
+        m_scratch[j++] = vertices[i].y;
+        m_scratch[j++] = vertices[i].z;
+
+        m_scratch_colors[k++] = vertices[i].r;
+        m_scratch_colors[k++] = vertices[i].g;
+        m_scratch_colors[k++] = vertices[i].b;
+        m_scratch_colors[k++] = vertices[i].a;
+    }
 
-    // Bind vertex array.
-    ::glBindVertexArray(m_array);
+    upload(m_scratch.data(), m_scratch_colors.data(), vertices.size());
 
-    // Get vertex positions.
-    positions = new GLfloat[count];
-    for (i = j = 0; i < vertices.size(); i++) {
-        positions[j++] = vertices[i].x;
-        positions[j++] = vertices[i].y;
-        positions[j++] = vertices[i].z;
-        positions[j++] = 1.0f;
+    // Upload indices into the bound vertex array.
+    if (vertices.is_indexed()) {
+        ::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_elements);
+        ::glBufferData(GL_ELEMENT_ARRAY_BUFFER, vertices.get_index_count()*sizeof(GLuint),
+          vertices.get_indices(), GL_STREAM_DRAW);
     }
+}
 
-    // Point to vertex positions.
-    ::glBindBuffer(GL_ARRAY_BUFFER, m_positions);
-    ::glBufferData(GL_ARRAY_BUFFER, count*sizeof(GLfloat), positions, GL_DYNAMIC_DRAW);
-    ::glEnableVertexAttribArray(0);
-    ::glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
+// Set default instance attributes.
+void cosmodon::opengl::set_instance_defaults()
+{
+    ::glVertexAttrib4f(2, 1.0f, 0.0f, 0.0f, 0.0f);
+    ::glVertexAttrib4f(3, 0.0f, 1.0f, 0.0f, 0.0f);
+    ::glVertexAttrib4f(4, 0.0f, 0.0f, 1.0f, 0.0f);
+    ::glVertexAttrib4f(5, 0.0f, 0.0f, 0.0f, 1.0f);
+    ::glVertexAttrib4f(6, 1.0f, 1.0f, 1.0f, 1.0f);
+}
+
+// Append vertices to a batch.
+void cosmodon::opengl::append(const cosmodon::vertices *v, const cosmodon::matrix &transform)
+{
+    batch &target = m_batches[static_cast<uint8_t>(v->get_primitive())];
+    const cosmodon::number *m = transform.raw();
+    uint32_t j = target.positions.size();
+    uint32_t k = target.colors.size();
 
-    // Get vertex colors.
-    colors = new GLfloat[count];
-    for (i = j = 0; i < vertices.size(); i++) {
-        colors[j++] = vertices[i].r / 255.0f;
-        colors[j++] = vertices[i].g / 255.0f;
-        colors[j++] = vertices[i].b / 255.0f;
-        colors[j++] = 255.0f / 255.0f;
+    target.positions.resize(j + v->get_drawn_count() * 3);
+    target.colors.resize(k + v->get_drawn_count() * 4);
+
+    for (uint32_t i = 0; i < v->get_drawn_count(); i++) {
+        const cosmodon::vertex &p = v->get_drawn(i);
+
+        target.positions[j++] = m[0]*p.x + m[1]*p.y + m[2]*p.z + m[3];
+        target.positions[j++] = m[4]*p.x + m[5]*p.y + m[6]*p.z + m[7];
+        target.positions[j++] = m[8]*p.x + m[9]*p.y + m[10]*p.z + m[11];
+
+        target.colors[k++] = p.r;
+        target.colors[k++] = p.g;
+        target.colors[k++] = p.b;
+        target.colors[k++] = p.a;
     }
+}
 
-    // Point to vertex colors.
-    ::glBindBuffer(GL_ARRAY_BUFFER, m_colors);
-    ::glBufferData(GL_ARRAY_BUFFER, count*sizeof(GLfloat), colors, GL_DYNAMIC_DRAW);
-    ::glEnableVertexAttribArray(1);
-    ::glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 0, 0);
+// Upload transformation matrices.
+void cosmodon::opengl::set_uniforms(const cosmodon::matrix &transform)
+{
+    GLuint matrix_id;
+    const float *matrix_values;
+
+    static matrix identity;
 
     // Prepare model matrix.
     matrix_id = ::glGetUniformLocation(m_shader_program, "matrix_model");
@@ -160,35 +285,251 @@ void cosmodon::opengl::draw(const cosmodon::vertices *v, const cosmodon::matrix
     }
     ::glUniformMatrix4fv(matrix_id, 1, GL_TRUE, matrix_values);
 
+    // Prepare point size.
+    ::glUniform1f(::glGetUniformLocation(m_shader_program, "point_size"), m_point_size);
+}
+
+// Render vertices.
+void cosmodon::opengl::draw(const cosmodon::vertices *v, const cosmodon::matrix &transform, bool fill)
+{
+    cosmodon::primitive primitive = v->get_primitive();
+
+    // Merge points and lines into batches.
+    if (m_batching && primitive != cosmodon::primitive::triangle) {
+        append(v, transform);
+        return;
+    }
+
+    // Prepare correct filling mode.
+    if (primitive == cosmodon::primitive::triangle) {
+        ::glPolygonMode(GL_FRONT_AND_BACK, fill ? GL_FILL : GL_LINE);
+    }
+
+    // Bind vertex array, and upload vertices.
+    ::glBindVertexArray(m_array);
+    upload(v);
+    set_instance_defaults();
+
     // Render.
-    ::glDrawArrays(GL_TRIANGLES, 0, vertices.size());
-    
+    set_uniforms(transform);
+    if (v->is_indexed()) {
+        ::glDrawElements(primitive_mode(primitive), v->get_index_count(), GL_UNSIGNED_INT, 0);
+    } else {
+        ::glDrawArrays(primitive_mode(primitive), 0, v->size());
+    }
+    count_draw(v->get_drawn_count(), v->size() * (3*sizeof(GLfloat) + 4) + v->get_index_count() * sizeof(GLuint));
+
     // Clean up.
-    delete [] positions;
-    delete [] colors;
     ::glDisableVertexAttribArray(0);
     ::glDisableVertexAttribArray(1);
 }
 
+// Set batching.
+void cosmodon::opengl::set_batching(bool batching)
+{
+    flush();
+    m_batching = batching;
+}
+
+// Set blending.
+void cosmodon::opengl::set_blend(bool blend)
+{
+    if (blend == m_blend) {
+        return;
+    }
+    flush();
+    m_blend = blend;
+
+    // Blend over what is already drawn, without hiding anything drawn later behind.
+    if (blend) {
+        ::glEnable(GL_BLEND);
+        ::glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        ::glDepthMask(GL_FALSE);
+    } else {
+        ::glDisable(GL_BLEND);
+        ::glDepthMask(GL_TRUE);
+    }
+}
+
+// Set point size.
+void cosmodon::opengl::set_point_size(cosmodon::number size)
+{
+    flush();
+    m_point_size = size;
+}
+
+// Draw batches.
+void cosmodon::opengl::flush()
+{
+    static matrix identity;
+    const GLenum modes[] = {GL_POINTS, GL_LINES};
+
+    for (uint8_t i = 0; i < 2; i++) {
+        batch &source = m_batches[i];
+        uint32_t count = source.positions.size() / 3;
+        if (count == 0) {
+            continue;
+        }
+
+        // Upload batch.
+        ::glBindVertexArray(m_array);
+        upload(source.positions.data(), source.colors.data(), count);
+        set_instance_defaults();
+
+        // Render, with vertices already in world coordinates.
+        set_uniforms(identity);
+        ::glDrawArrays(modes[i], 0, count);
+        count_draw(count, count * (3*sizeof(GLfloat) + 4));
+
+        // Clean up, keeping storage for the next batch.
+        source.positions.clear();
+        source.colors.clear();
+        ::glDisableVertexAttribArray(0);
+        ::glDisableVertexAttribArray(1);
+    }
+}
+
+// Render many copies of vertices.
+void cosmodon::opengl::draw_instanced(const cosmodon::vertices *v, const cosmodon::matrix *transforms,
+  const cosmodon::color *colors, uint32_t count, bool fill)
+{
+    uint32_t i, j;
+    uint8_t row, column;
+
+    static matrix identity;
+    static_assert(sizeof(cosmodon::color) == 4, "Instance colors are uploaded as packed bytes.");
+
+    if (count == 0 || v->size() == 0) {
+        return;
+    }
+
+    // Prepare correct filling mode.
+    if (v->get_primitive() == cosmodon::primitive::triangle) {
+        ::glPolygonMode(GL_FRONT_AND_BACK, fill ? GL_FILL : GL_LINE);
+    }
+
+    // Bind vertex array, and upload shared vertices once.
+    ::glBindVertexArray(m_array);
+    upload(v);
+
+    // Pack instance matrices by column, since cosmodon matrices are row-major.
+    m_scratch.resize(count * 16);
+    for (i = j = 0; i < count; i++) {
+        for (column = 0; column < 4; column++) {
+            for (row = 0; row < 4; row++) {
+                m_scratch[j++] = transforms[i][row][column];
+            }
+        }
+    }
+
+    // Point to instance matrices, one column per attribute location.
+    ::glBindBuffer(GL_ARRAY_BUFFER, m_instance_transforms);
+    ::glBufferData(GL_ARRAY_BUFFER, count*16*sizeof(GLfloat), m_scratch.data(), GL_STREAM_DRAW);
+    for (column = 0; column < 4; column++) {
+        ::glEnableVertexAttribArray(2 + column);
+        ::glVertexAttribPointer(2 + column, 4, GL_FLOAT, GL_FALSE, 16*sizeof(GLfloat),
+          reinterpret_cast<const GLvoid*>(column*4*sizeof(GLfloat)));
+        ::glVertexAttribDivisor(2 + column, 1);
+    }
+
+    // Point to instance colors, which are already packed bytes.
+    if (colors != nullptr) {
+        ::glBindBuffer(GL_ARRAY_BUFFER, m_instance_colors);
+        ::glBufferData(GL_ARRAY_BUFFER, count*sizeof(cosmodon::color), colors, GL_STREAM_DRAW);
+        ::glEnableVertexAttribArray(6);
+        ::glVertexAttribPointer(6, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(cosmodon::color), 0);
+        ::glVertexAttribDivisor(6, 1);
+    } else {
+        ::glVertexAttrib4f(6, 1.0f, 1.0f, 1.0f, 1.0f);
+    }
+
+    // Render, with instance matrices standing in for the model matrix.
+    set_uniforms(identity);
+    if (v->is_indexed()) {
+        ::glDrawElementsInstanced(primitive_mode(v->get_primitive()), v->get_index_count(),
+          GL_UNSIGNED_INT, 0, count);
+    } else {
+        ::glDrawArraysInstanced(primitive_mode(v->get_primitive()), 0, v->size(), count);
+    }
+    count_draw(v->get_drawn_count(), v->size() * (3*sizeof(GLfloat) + 4) + v->get_index_count() * sizeof(GLuint)
+      + count * 16 * sizeof(GLfloat) + ((colors != nullptr) ? count * sizeof(cosmodon::color) : 0));
+
+    // Clean up.
+    for (i = 0; i <= 6; i++) {
+        ::glDisableVertexAttribArray(i);
+    }
+}
+
 // Display drawing area.
 void cosmodon::opengl::display()
 {
+    // Complete frame statistics before waiting on the swap.
+    flush();
+    finish_frame();
     ::glfwSwapBuffers(m_handle);
 
     // Tally frame towards FPS.
     m_fps.tally();
 }
 
-// Compile shader.
-GLuint cosmodon::opengl::compile_shader(cosmodon::shader *shader)
+// Begin a timed pass.
+void cosmodon::opengl::begin_pass(const std::string &name)
+{
+    std::vector<GLuint> &queries = m_queries[m_current.frame % 2];
+    uint32_t index;
+
+    flush();
+    draw::driver::begin_pass(name);
+
+    // Queries are created as passes are first used, then reused every other frame.
+    index = m_current.passes.size() - 1;
+    if (index >= queries.size()) {
+        queries.push_back(0);
+        ::glGenQueries(1, &queries.back());
+    }
+    ::glBeginQuery(GL_TIME_ELAPSED, queries[index]);
+}
+
+// End a timed pass.
+void cosmodon::opengl::end_pass()
+{
+    flush();
+    if (m_in_pass) {
+        ::glEndQuery(GL_TIME_ELAPSED);
+    }
+    draw::driver::end_pass();
+}
+
+// Complete frame.
+void cosmodon::opengl::finish_frame()
+{
+    std::vector<GLuint> &queries = m_queries[m_pending.frame % 2];
+    GLint available;
+    GLuint64 elapsed;
+
+    end_pass();
+
+    // Collect the pending frame's GPU timings, if they have arrived.
+    for (uint32_t i = 0; i < m_pending.passes.size() && i < queries.size(); i++) {
+        ::glGetQueryObjectiv(queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == GL_TRUE) {
+            ::glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &elapsed);
+            m_pending.passes[i].gpu_time = elapsed;
+        }
+    }
+
+    draw::driver::finish_frame();
+}
+
+// Create and start compiling a shader.
+GLuint cosmodon::opengl::create_shader(const cosmodon::shader &source)
 {
-    GLint status;
     GLuint type;
     GLuint object;
-    const char *code = shader->code.c_str();
+    const char *code = source.code.c_str();
 
     // Determine shader type.
-    switch (shader->level) {
+    switch (source.level) {
         case cosmodon::shader::vertex:
             type = GL_VERTEX_SHADER;
             break;
@@ -200,77 +541,292 @@ GLuint cosmodon::opengl::compile_shader(cosmodon::shader *shader)
             break;
     }
 
-    // Compile shader.
+    // Start compiling. The status is checked once the program is resolved.
     object = ::glCreateShader(type);
     ::glShaderSource(object, 1, &code, nullptr);
     ::glCompileShader(object);
-    ::glGetShaderiv(object, GL_COMPILE_STATUS, &status);
+    return object;
+}
+
+// Start building a program from source.
+void cosmodon::opengl::start_program(cosmodon::opengl::program &record)
+{
+    // Create program.
+    record.object = ::glCreateProgram();
+    if (record.key != 0) {
+        ::glProgramParameteri(record.object, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
 
-    // Report compilation errors.
-    if (status == GL_FALSE) {
-        GLchar *report;
-        GLint report_length;
-        std::string msg;
+    // Bind attribute locations.
+    ::glBindAttribLocation(record.object, 0, "position");
+    ::glBindAttribLocation(record.object, 1, "color");
+    ::glBindAttribLocation(record.object, 2, "instance_model");
+    ::glBindAttribLocation(record.object, 6, "instance_color");
+
+    // Compile shaders, and link without waiting for either.
+    record.shaders.clear();
+    for (uint32_t i = 0; i < record.sources.size(); i++) {
+        record.shaders.push_back(create_shader(record.sources[i]));
+        ::glAttachShader(record.object, record.shaders.back());
+    }
+    ::glLinkProgram(record.object);
 
-        // Retrieve error information.
-        ::glGetShaderiv(object, GL_INFO_LOG_LENGTH, &report_length);
-        report = new GLchar[report_length + 1];
-        ::glGetShaderInfoLog(object, report_length, nullptr, report);
+    record.cached = false;
+    record.status = program_status::pending;
+    record.deleted = false;
+}
 
-        // Prepare exception message.
-        msg = report;
-        delete [] report;
+// Resolve a pending program.
+void cosmodon::opengl::resolve_program(cosmodon::opengl::program &record, bool wait)
+{
+    GLint status;
 
-        // Throw exception.
-        ::glDeleteShader(object);
-        throw cosmodon::exception::fatal(std::string("Failed to compile OpenGL shader: ") + msg);
+    while (record.status == program_status::pending) {
+        // Leave programs still being built alone, rather than stalling on them.
+        if (!wait && m_parallel_compile) {
+            ::glGetProgramiv(record.object, GL_COMPLETION_STATUS_KHR, &status);
+            if (status == GL_FALSE) {
+                return;
+            }
+        }
+
+        // Check link status. This blocks until the program is built.
+        ::glGetProgramiv(record.object, GL_LINK_STATUS, &status);
+
+        // Rebuild rejected cached binaries from source.
+        if (status == GL_FALSE && record.cached) {
+            ::glDeleteProgram(record.object);
+            start_program(record);
+            continue;
+        }
+
+        // Collect errors of failed builds.
+        if (status == GL_FALSE) {
+            for (uint32_t i = 0; i < record.shaders.size(); i++) {
+                record.log += build_log(record.shaders[i], false);
+            }
+            record.log += build_log(record.object, true);
+        }
+
+        // Destroy shaders.
+        for (uint32_t i = 0; i < record.shaders.size(); i++) {
+            ::glDetachShader(record.object, record.shaders[i]);
+            ::glDeleteShader(record.shaders[i]);
+        }
+        record.shaders.clear();
+
+        // Finish up.
+        if (status == GL_FALSE) {
+            ::glDeleteProgram(record.object);
+            record.object = 0;
+            record.status = program_status::failed;
+        } else {
+            if (record.key != 0 && !record.cached) {
+                store_program(record.key, record.object);
+            }
+            record.status = program_status::ready;
+        }
     }
+}
 
-    // Return compiled OpenGL shader.
-    return object;
+// Compute program cache key.
+uint64_t cosmodon::opengl::program_key(cosmodon::shader *vertex, cosmodon::shader *fragment) const
+{
+    const GLenum strings[] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+    uint64_t key = cosmodon::hash::fnv("cosmodon program 1");
+
+    // Hash driver identity.
+    for (uint8_t i = 0; i < 3; i++) {
+        const GLubyte *value = ::glGetString(strings[i]);
+        key = cosmodon::hash::fnv(value ? reinterpret_cast<const char*>(value) : "", key);
+    }
+
+    // Hash shader sources.
+    key = cosmodon::hash::fnv(vertex->code, key);
+    key = cosmodon::hash::fnv(fragment->code, key);
+    return key;
 }
 
-// Set shaders.
-bool cosmodon::opengl::set_shaders(cosmodon::shader *vertex, cosmodon::shader *fragment, cosmodon::shader *geometry)
+// Start loading a program from the binary cache.
+GLuint cosmodon::opengl::load_program(uint64_t key)
 {
-    GLint status;
-    GLuint shader_vertex;
-    GLuint shader_fragment;
+    GLuint program;
+    uint32_t header[3];
+    std::vector<char> data;
+
+    // Read cached binary: magic, binary format, and length, followed by the binary.
+    std::ifstream file(m_cache_directory + "/" + cosmodon::hash::hex(key) + ".program", std::ios::binary);
+    if (!file.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != program_magic) {
+        return 0;
+    }
+    data.resize(header[2]);
+    if (!file.read(data.data(), data.size())) {
+        return 0;
+    }
 
-    // Destroy old program.
-    ::glUseProgram(0);
-    ::glDeleteProgram(m_shader_program);
-    m_shader_program = ::glCreateProgram();
+    // Offer binary to the driver, which may reject it after an update.
+    program = ::glCreateProgram();
+    ::glProgramBinary(program, header[1], data.data(), data.size());
+    return program;
+}
 
-    // Bind attribute locations.
-    ::glBindAttribLocation(m_shader_program, 0, "position");
-    ::glBindAttribLocation(m_shader_program, 1, "color");
-
-    // Compile shaders.
-    shader_vertex = compile_shader(vertex);
-    shader_fragment = compile_shader(fragment);
-
-    // Link shaders.
-    ::glAttachShader(m_shader_program, shader_vertex);
-    ::glAttachShader(m_shader_program, shader_fragment);
-    ::glLinkProgram(m_shader_program);
-    ::glGetProgramiv(m_shader_program, GL_LINK_STATUS, &status);
-
-    // Destroy shaders.
-    ::glDetachShader(m_shader_program, shader_vertex);
-    ::glDetachShader(m_shader_program, shader_fragment);
-    ::glDeleteShader(shader_vertex);
-    ::glDeleteShader(shader_fragment);
-
-    // Report linking errors.
-    if (status == GL_FALSE) {
+// Store a program in the binary cache.
+void cosmodon::opengl::store_program(uint64_t key, GLuint program)
+{
+    GLint length = 0;
+    GLsizei written = 0;
+    GLenum format;
+    uint32_t header[3];
+    std::vector<char> data;
+    std::string path = m_cache_directory + "/" + cosmodon::hash::hex(key) + ".program";
+
+    // Retrieve binary.
+    ::glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+    data.resize(length);
+    ::glGetProgramBinary(program, length, &written, &format, data.data());
+    if (written <= 0) {
+        return;
+    }
+
+    // Write to a temporary file, then move it in place, so readers never see partial binaries.
+    header[0] = program_magic;
+    header[1] = format;
+    header[2] = written;
+    {
+        std::ofstream file(path + ".tmp", std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(header), sizeof(header));
+        file.write(data.data(), written);
+        if (!file) {
+            std::remove((path + ".tmp").c_str());
+            return;
+        }
+    }
+    std::rename((path + ".tmp").c_str(), path.c_str());
+}
+
+// Set program cache directory.
+void cosmodon::opengl::set_program_cache(const std::string directory)
+{
+    m_cache_directory = directory;
+}
+
+// Queue a program.
+uint32_t cosmodon::opengl::queue_program(cosmodon::shader *vertex, cosmodon::shader *fragment)
+{
+    program record;
+
+    record.object = 0;
+    record.sources.push_back(*vertex);
+    record.sources.push_back(*fragment);
+    record.key = 0;
+    record.cached = false;
+    record.status = program_status::pending;
+    record.deleted = false;
+
+    // Prefer a cached binary, otherwise build from source.
+    if (!m_cache_directory.empty() && (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary)) {
+        record.key = program_key(vertex, fragment);
+        record.object = load_program(record.key);
+        record.cached = (record.object != 0);
+    }
+    if (!record.cached) {
+        start_program(record);
+    }
+
+    // Reuse the handle of a destroyed program if there is one.
+    if (!m_free_programs.empty()) {
+        uint32_t handle = m_free_programs.back();
+        m_free_programs.pop_back();
+        m_programs[handle] = std::move(record);
+        return handle;
+    }
+    m_programs.push_back(std::move(record));
+    return m_programs.size() - 1;
+}
+
+// Retrieve program status.
+cosmodon::opengl::program_status cosmodon::opengl::get_program_status(uint32_t handle)
+{
+    resolve_program(m_programs[handle], false);
+    return m_programs[handle].status;
+}
+
+// Retrieve program log.
+std::string cosmodon::opengl::get_program_log(uint32_t handle) const
+{
+    return m_programs[handle].log;
+}
+
+// Use a program.
+bool cosmodon::opengl::use_program(uint32_t handle)
+{
+    bool ready = (get_program_status(handle) == program_status::ready);
+
+    // Fall back to the default program.
+    if (!ready) {
+        handle = m_default_program;
+    }
+
+    flush();
+    m_shader_program = (handle == no_program) ? 0 : m_programs[handle].object;
+    ::glUseProgram(m_shader_program);
+    return ready;
+}
+
+// Destroy a program.
+void cosmodon::opengl::delete_program(uint32_t handle)
+{
+    program &record = m_programs[handle];
+    if (record.deleted) {
+        return;
+    }
+
+    // Stop using program, and drop it as the fallback.
+    if (record.object != 0 && record.object == m_shader_program) {
+        ::glUseProgram(0);
         m_shader_program = 0;
-        throw cosmodon::exception::fatal("Failed to link OpenGL shaders.");
-        // @@@ return false;
+    }
+    if (handle == m_default_program) {
+        m_default_program = no_program;
+    }
+
+    // Destroy OpenGL objects.
+    for (uint32_t i = 0; i < record.shaders.size(); i++) {
+        ::glDeleteShader(record.shaders[i]);
+    }
+    ::glDeleteProgram(record.object);
+    record.shaders.clear();
+    record.sources.clear();
+    record.object = 0;
+    record.status = program_status::failed;
+    record.deleted = true;
+    m_free_programs.push_back(handle);
+}
+
+// Set shaders.
+bool cosmodon::opengl::set_shaders(cosmodon::shader *vertex, cosmodon::shader *fragment, cosmodon::shader *geometry)
+{
+    uint32_t handle = queue_program(vertex, fragment);
+
+    // Wait for program.
+    resolve_program(m_programs[handle], true);
+    if (m_programs[handle].status == program_status::failed) {
+        std::string log = m_programs[handle].log;
+        delete_program(handle);
+        throw cosmodon::exception::fatal(std::string("Failed to link OpenGL shaders: ") + log);
     }
 
+    // Replace old default program.
+    if (m_default_program != no_program) {
+        delete_program(m_default_program);
+    }
+    m_default_program = handle;
+
     // Start using new shader program.
-    ::glUseProgram(m_shader_program);
+    use_program(handle);
     return true;
 }
 
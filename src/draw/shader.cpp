@@ -13,18 +13,22 @@ cosmodon::shader::shader(cosmodon::shader::level_type init_level, std::string in
                    "\n"
                    "layout (location = 0) in vec4 position;\n"
                    "layout (location = 1) in vec4 color;\n"
+                   "layout (location = 2) in mat4 instance_model;\n"
+                   "layout (location = 6) in vec4 instance_color;\n"
                    "smooth out vec4 frag_color;\n"
                    "\n"
                    "uniform mat4 matrix_model;\n"
                    "uniform mat4 matrix_view;\n"
                    "uniform mat4 matrix_projection;\n"
+                   "uniform float point_size;\n"
                    "\n"
                    "void main()\n"
                    "{\n"
                    //"    gl_Position = matrix_projection * matrix_view * matrix_model * position;\n"
-                   "    gl_Position = matrix_projection * matrix_view * matrix_model * position;\n"
+                   "    gl_Position = matrix_projection * matrix_view * matrix_model * instance_model * position;\n"
                    //"gl_Position = position * matrix_model * matrix_orientation * matrix_perspective;\n"
-                   "    frag_color = color;\n"
+                   "    gl_PointSize = point_size;\n"
+                   "    frag_color = color * instance_color;\n"
                    "}";
         }
 
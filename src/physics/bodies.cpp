@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <common/simd.hpp>
+#include <physics/bodies.hpp>
+
+// Constructor.
+cosmodon::physics::bodies::bodies()
+  : m_count(0)
+{
+
+}
+
+// Resize bodies.
+void cosmodon::physics::bodies::resize(uint32_t count)
+{
+    uint32_t padded = (count + 3) & ~3;
+    for (uint8_t i = 0; i < 3; i++) {
+        m_position[i].resize(padded, 0);
+        m_velocity[i].resize(padded, 0);
+        m_acceleration[i].resize(padded, 0);
+        m_previous[i].resize(padded, 0);
+    }
+    m_half.resize(padded, 0);
+    m_mobile.resize(padded, 0);
+
+    // Padding stays still.
+    std::fill(m_mobile.begin() + count, m_mobile.end(), 0.0f);
+    m_count = count;
+}
+
+// Retrieve body count.
+uint32_t cosmodon::physics::bodies::size() const
+{
+    return m_count;
+}
+
+// Set body state.
+void cosmodon::physics::bodies::set(uint32_t body, const cosmodon::vector &position, const cosmodon::vector &velocity,
+  const cosmodon::vector &acceleration, bool is_static, bool restart)
+{
+    const cosmodon::number p[3] = {position.x, position.y, position.z};
+    const cosmodon::number v[3] = {velocity.x, velocity.y, velocity.z};
+    const cosmodon::number a[3] = {acceleration.x, acceleration.y, acceleration.z};
+    for (uint8_t i = 0; i < 3; i++) {
+        m_position[i][body] = p[i];
+        m_velocity[i][body] = v[i];
+        m_acceleration[i][body] = a[i];
+        if (restart) {
+            m_previous[i][body] = a[i];
+        }
+    }
+    if (restart) {
+        m_half[body] = 0;
+    }
+    m_mobile[body] = is_static ? 0 : 1;
+}
+
+// Copy a body.
+void cosmodon::physics::bodies::move(uint32_t from, uint32_t to)
+{
+    for (uint8_t i = 0; i < 3; i++) {
+        m_position[i][to] = m_position[i][from];
+        m_velocity[i][to] = m_velocity[i][from];
+        m_acceleration[i][to] = m_acceleration[i][from];
+        m_previous[i][to] = m_previous[i][from];
+    }
+    m_half[to] = m_half[from];
+    m_mobile[to] = m_mobile[from];
+}
+
+// Retrieve position.
+cosmodon::vector cosmodon::physics::bodies::get_position(uint32_t body) const
+{
+    return cosmodon::vector(m_position[0][body], m_position[1][body], m_position[2][body]);
+}
+
+// Retrieve velocity.
+cosmodon::vector cosmodon::physics::bodies::get_velocity(uint32_t body) const
+{
+    return cosmodon::vector(m_velocity[0][body], m_velocity[1][body], m_velocity[2][body]);
+}
+
+// Check static status.
+bool cosmodon::physics::bodies::is_static(uint32_t body) const
+{
+    return m_mobile[body] == 0;
+}
+
+// Retrieve positions.
+float* cosmodon::physics::bodies::get_positions(uint8_t axis)
+{
+    return m_position[axis].data();
+}
+
+// Retrieve velocities.
+float* cosmodon::physics::bodies::get_velocities(uint8_t axis)
+{
+    return m_velocity[axis].data();
+}
+
+// Retrieve accelerations.
+float* cosmodon::physics::bodies::get_accelerations(uint8_t axis)
+{
+    return m_acceleration[axis].data();
+}
+
+// Integrate bodies.
+void cosmodon::physics::bodies::integrate(cosmodon::number seconds, cosmodon::physics::integrator method, uint32_t first, uint32_t count)
+{
+    typedef cosmodon::simd::float4 float4;
+    uint32_t last = std::min<uint32_t>(first + count, m_mobile.size());
+    bool verlet = method == cosmodon::physics::integrator::verlet;
+    float4 dt(seconds);
+    float4 half_dt2(seconds * seconds / 2);
+
+    for (uint32_t i = first; i < last; i += 4) {
+        float4 mobile = float4::load(&m_mobile[i]);
+        for (uint8_t axis = 0; axis < 3; axis++) {
+            float *position = &m_position[axis][i];
+            float *velocity = &m_velocity[axis][i];
+            float4 p = float4::load(position);
+            float4 v = float4::load(velocity);
+            float4 a = float4::load(&m_acceleration[axis][i]);
+
+            // Verlet moves by the current velocity, then takes the velocity through the whole
+            // step on the current acceleration until corrected.
+            if (verlet) {
+                p = p + (v * dt + a * half_dt2) * mobile;
+                v = (v + a * dt) * mobile;
+                a.store(&m_previous[axis][i]);
+            } else {
+                v = (v + a * dt) * mobile;
+                p = p + v * dt;
+            }
+            p.store(position);
+            v.store(velocity);
+        }
+        float4(verlet ? seconds / 2 : 0).store(&m_half[i]);
+    }
+}
+
+// Correct velocities.
+void cosmodon::physics::bodies::correct(uint32_t first, uint32_t count)
+{
+    typedef cosmodon::simd::float4 float4;
+    uint32_t last = std::min<uint32_t>(first + count, m_mobile.size());
+
+    for (uint32_t i = first; i < last; i += 4) {
+        float4 half = float4::load(&m_half[i]) * float4::load(&m_mobile[i]);
+        for (uint8_t axis = 0; axis < 3; axis++) {
+            float *velocity = &m_velocity[axis][i];
+            float *previous = &m_previous[axis][i];
+            float4 a = float4::load(&m_acceleration[axis][i]);
+            (float4::load(velocity) + (a - float4::load(previous)) * half).store(velocity);
+            a.store(previous);
+        }
+        float4().store(&m_half[i]);
+    }
+}
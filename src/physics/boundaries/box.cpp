@@ -0,0 +1,95 @@
+#include <physics/boundaries/box.hpp>
+#include <physics/physical.hpp>
+
+// Local function to compare the hull of a box against a model.
+static bool intersects(const cosmodon::physics::hull &shape, const cosmodon::matrix &transform, const cosmodon::model &other)
+{
+    // Physical objects keep their hull, so only plain models build one here.
+    const cosmodon::physical *object = dynamic_cast<const cosmodon::physical*>(&other);
+    cosmodon::physics::hull built;
+    if (object == nullptr) {
+        built.build(other);
+    }
+    const cosmodon::physics::hull &other_hull = object ? object->get_hull() : built;
+    if (shape.is_empty() || other_hull.is_empty()) {
+        return false;
+    }
+    return cosmodon::physics::intersects(
+        cosmodon::physics::convex(shape, transform),
+        cosmodon::physics::convex(other_hull, other.get_matrix())
+    );
+}
+
+// Constructor.
+cosmodon::boundaries::box::box()
+  : m_width(0), m_height(0), m_depth(0)
+{
+    resize(0, 0, 0);
+}
+
+// Change the size.
+void cosmodon::boundaries::box::resize(cosmodon::number width, cosmodon::number height, cosmodon::number depth)
+{
+    m_width = width;
+    m_height = height;
+    m_depth = depth;
+
+    // Corners, then two triangles per face.
+    static const uint8_t faces[12][3] = {
+        {0, 2, 1}, {1, 2, 3}, {4, 5, 6}, {5, 7, 6}, {0, 1, 4}, {1, 5, 4},
+        {2, 6, 3}, {3, 6, 7}, {0, 4, 2}, {2, 4, 6}, {1, 3, 5}, {3, 7, 5}
+    };
+    cosmodon::vector corners[8];
+    clear();
+    for (uint8_t i = 0; i < 8; i++) {
+        corners[i] = cosmodon::vector(
+            (i & 1) ? width / 2 : -width / 2,
+            (i & 2) ? height / 2 : -height / 2,
+            (i & 4) ? depth / 2 : -depth / 2
+        );
+        add(corners[i].x, corners[i].y, corners[i].z);
+    }
+    for (uint8_t i = 0; i < 12; i++) {
+        for (uint8_t j = 0; j < 3; j++) {
+            add_index(faces[i][j]);
+        }
+    }
+    m_hull.build(corners, 8);
+}
+
+// Retrieve the world box.
+cosmodon::physics::cuboid cosmodon::boundaries::box::get_cuboid() const
+{
+    cosmodon::vector half(m_width / 2, m_height / 2, m_depth / 2);
+    return cosmodon::physics::cuboid(cosmodon::bounds(cosmodon::vector(0, 0, 0) - half, half), get_matrix());
+}
+
+// Retrieve the box placed by an object.
+cosmodon::physics::cuboid cosmodon::boundaries::box::get_cuboid(const cosmodon::matrix &placement) const
+{
+    cosmodon::vector half(m_width / 2, m_height / 2, m_depth / 2);
+    return cosmodon::physics::cuboid(cosmodon::bounds(cosmodon::vector(0, 0, 0) - half, half), placement * get_matrix());
+}
+
+// Retrieve the corners.
+const cosmodon::physics::hull& cosmodon::boundaries::box::get_hull() const
+{
+    return m_hull;
+}
+
+// Compare against a model.
+bool cosmodon::boundaries::box::intersects(const cosmodon::model &other) const
+{
+    return ::intersects(m_hull, get_matrix(), other);
+}
+
+// Compare against a boundary.
+bool cosmodon::boundaries::box::intersects(const cosmodon::boundary &other) const
+{
+    const box *other_box = dynamic_cast<const box*>(&other);
+    if (other_box != nullptr) {
+        cosmodon::physics::contact result;
+        return cosmodon::physics::collide(get_cuboid(), other_box->get_cuboid(), result);
+    }
+    return ::intersects(m_hull, get_matrix(), other);
+}
@@ -0,0 +1,213 @@
+#include <algorithm>
+#include <cmath>
+#include <physics/grid.hpp>
+
+namespace
+{
+    // Fewest boxes worth a job of their own.
+    const uint32_t boxes_per_job = 1024;
+
+    // Cells searched from each cell, so that every pair of neighbouring cells is searched once.
+    const int8_t forward[13][3] = {
+        {1, 0, 0}, {-1, 1, 0}, {0, 1, 0}, {1, 1, 0},
+        {-1, -1, 1}, {0, -1, 1}, {1, -1, 1}, {-1, 0, 1}, {0, 0, 1}, {1, 0, 1}, {-1, 1, 1}, {0, 1, 1}, {1, 1, 1}
+    };
+}
+
+// Local function to run jobs on a pool, or in order on the calling thread.
+template <typename function>
+static void run(cosmodon::pool *threads, uint32_t jobs, function work)
+{
+    if (threads == nullptr || jobs == 1) {
+        for (uint32_t i = 0; i < jobs; i++) {
+            work(i);
+        }
+    } else {
+        threads->run(jobs, [&](uint32_t job, uint8_t) {
+            work(job);
+        });
+    }
+}
+
+// Constructor.
+cosmodon::physics::grid::grid()
+  : m_requested(0), m_cell_size(0), m_mask(0)
+{
+
+}
+
+// Find the bucket of a cell.
+uint32_t cosmodon::physics::grid::get_bucket(int32_t x, int32_t y, int32_t z) const
+{
+    uint32_t hash = (static_cast<uint32_t>(x) * 73856093u) ^ (static_cast<uint32_t>(y) * 19349663u) ^
+      (static_cast<uint32_t>(z) * 83492791u);
+    return hash & m_mask;
+}
+
+// Set the cell size.
+void cosmodon::physics::grid::set_cell_size(cosmodon::number size)
+{
+    m_requested = size;
+}
+
+// Retrieve the cell size.
+cosmodon::number cosmodon::physics::grid::get_cell_size() const
+{
+    return m_cell_size;
+}
+
+// Sort boxes into cells and find pairs.
+void cosmodon::physics::grid::build(const cosmodon::bounds *boxes, uint32_t count, cosmodon::pool *threads)
+{
+    m_pairs.clear();
+    if (count == 0) {
+        return;
+    }
+
+    uint32_t jobs = 1;
+    if (threads != nullptr) {
+        jobs = std::max<uint32_t>(1, std::min<uint32_t>(threads->size(), count / boxes_per_job));
+    }
+    auto first = [&](uint32_t job) { return static_cast<uint32_t>(static_cast<uint64_t>(count) * job / jobs); };
+
+    // Fit cells to the largest box.
+    std::vector<cosmodon::number> largest(jobs, 0);
+    run(threads, jobs, [&](uint32_t job) {
+        for (uint32_t i = first(job); i < first(job + 1); i++) {
+            cosmodon::vector size = boxes[i].get_size();
+            largest[job] = std::max(largest[job], std::max(std::max(size.x, size.y), size.z));
+        }
+    });
+    m_cell_size = std::max(m_requested, *std::max_element(largest.begin(), largest.end()));
+    if (m_cell_size <= 0) {
+        m_cell_size = 1;
+    }
+
+    // Twice as many buckets as boxes, a power of two, keeps collisions between cells rare.
+    // Buckets split into a power of two segments, at least one per job, by their top bits.
+    uint32_t buckets = 1;
+    while (buckets < count * 2) {
+        buckets <<= 1;
+    }
+    uint32_t segments = 1;
+    while (segments < jobs) {
+        segments <<= 1;
+    }
+    uint8_t shift = 0;
+    while ((segments << shift) < buckets) {
+        shift++;
+    }
+    m_mask = buckets - 1;
+    m_starts.assign(buckets + 1, 0);
+    m_next.resize(buckets);
+    m_cells.resize(count * 3);
+    m_buckets.resize(count);
+    m_sorted.resize(count);
+    m_grouped.resize(count);
+    m_counts.assign(static_cast<size_t>(jobs) * segments, 0);
+    m_segments.resize(segments + 1);
+
+    // Count boxes per segment, separately for each job.
+    cosmodon::number inverse = 1 / m_cell_size;
+    run(threads, jobs, [&](uint32_t job) {
+        uint32_t *counts = &m_counts[static_cast<size_t>(job) * segments];
+        for (uint32_t i = first(job); i < first(job + 1); i++) {
+            cosmodon::vector center = boxes[i].get_center();
+            int32_t *cell = &m_cells[i * 3];
+            cell[0] = static_cast<int32_t>(std::floor(center.x * inverse));
+            cell[1] = static_cast<int32_t>(std::floor(center.y * inverse));
+            cell[2] = static_cast<int32_t>(std::floor(center.z * inverse));
+            m_buckets[i] = get_bucket(cell[0], cell[1], cell[2]);
+            counts[m_buckets[i] >> shift]++;
+        }
+    });
+
+    // Turn counts into write offsets, segment by segment, each job after the one before.
+    uint32_t offset = 0;
+    for (uint32_t s = 0; s < segments; s++) {
+        m_segments[s] = offset;
+        for (uint32_t job = 0; job < jobs; job++) {
+            uint32_t &slot = m_counts[static_cast<size_t>(job) * segments + s];
+            uint32_t amount = slot;
+            slot = offset;
+            offset += amount;
+        }
+    }
+    m_segments[segments] = count;
+
+    // Group boxes by segment. Jobs write disjoint ranges, keeping boxes in order.
+    run(threads, jobs, [&](uint32_t job) {
+        uint32_t *offsets = &m_counts[static_cast<size_t>(job) * segments];
+        for (uint32_t i = first(job); i < first(job + 1); i++) {
+            m_grouped[offsets[m_buckets[i] >> shift]++] = i;
+        }
+    });
+
+    // Sort each segment into its own buckets, still keeping boxes in order.
+    run(threads, segments, [&](uint32_t s) {
+        uint32_t low = s << shift;
+        uint32_t high = (s + 1) << shift;
+        for (uint32_t k = m_segments[s]; k < m_segments[s + 1]; k++) {
+            m_starts[m_buckets[m_grouped[k]]]++;
+        }
+        uint32_t next = m_segments[s];
+        for (uint32_t b = low; b < high; b++) {
+            uint32_t amount = m_starts[b];
+            m_starts[b] = m_next[b] = next;
+            next += amount;
+        }
+        for (uint32_t k = m_segments[s]; k < m_segments[s + 1]; k++) {
+            uint32_t i = m_grouped[k];
+            m_sorted[m_next[m_buckets[i]]++] = i;
+        }
+    });
+    m_starts[buckets] = count;
+
+    // Search the own cell and forward neighbours of each box.
+    m_found.resize(jobs);
+    run(threads, jobs, [&](uint32_t job) {
+        std::vector<pair> &found = m_found[job];
+        found.clear();
+        for (uint32_t k = first(job); k < first(job + 1); k++) {
+            uint32_t a = m_sorted[k];
+            const int32_t *cell = &m_cells[a * 3];
+
+            // Boxes later in the same cell.
+            uint32_t end = m_starts[m_buckets[a] + 1];
+            for (uint32_t j = k + 1; j < end; j++) {
+                uint32_t b = m_sorted[j];
+                const int32_t *other = &m_cells[b * 3];
+                if (other[0] == cell[0] && other[1] == cell[1] && other[2] == cell[2] && boxes[a].overlaps(boxes[b])) {
+                    pair p = {std::min(a, b), std::max(a, b)};
+                    found.push_back(p);
+                }
+            }
+
+            // Boxes in forward cells. Buckets may hold other cells, which are skipped.
+            for (uint8_t n = 0; n < 13; n++) {
+                int32_t x = cell[0] + forward[n][0];
+                int32_t y = cell[1] + forward[n][1];
+                int32_t z = cell[2] + forward[n][2];
+                uint32_t bucket = get_bucket(x, y, z);
+                for (uint32_t j = m_starts[bucket]; j < m_starts[bucket + 1]; j++) {
+                    uint32_t b = m_sorted[j];
+                    const int32_t *other = &m_cells[b * 3];
+                    if (other[0] == x && other[1] == y && other[2] == z && boxes[a].overlaps(boxes[b])) {
+                        pair p = {std::min(a, b), std::max(a, b)};
+                        found.push_back(p);
+                    }
+                }
+            }
+        }
+    });
+
+    for (uint32_t job = 0; job < jobs; job++) {
+        m_pairs.insert(m_pairs.end(), m_found[job].begin(), m_found[job].end());
+    }
+}
+
+// Retrieve pairs.
+const std::vector<cosmodon::physics::grid::pair>& cosmodon::physics::grid::get_pairs() const
+{
+    return m_pairs;
+}
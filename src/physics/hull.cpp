@@ -0,0 +1,231 @@
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <utility>
+#include <physics/hull.hpp>
+
+namespace
+{
+    // A face of a hull under construction, wound counterclockwise seen from outside.
+    struct face
+    {
+        uint32_t corners[3];
+        cosmodon::vector normal;
+        cosmodon::number offset;
+    };
+}
+
+// Local function to build a face, facing away from an inner point.
+static face make_face(const std::vector<cosmodon::vector> &points, uint32_t a, uint32_t b, uint32_t c, const cosmodon::vector &inside)
+{
+    face result;
+    result.corners[0] = a;
+    result.corners[1] = b;
+    result.corners[2] = c;
+    result.normal = ((points[b] - points[a]) * (points[c] - points[a])).normal();
+    if (result.normal.dot(inside - points[a]) > 0) {
+        std::swap(result.corners[1], result.corners[2]);
+        result.normal = cosmodon::vector(0, 0, 0) - result.normal;
+    }
+    result.offset = result.normal.dot(points[a]);
+    return result;
+}
+
+// Build from vertices.
+void cosmodon::physics::hull::build(const cosmodon::vertices &source)
+{
+    std::vector<cosmodon::vector> points;
+    points.reserve(source.size());
+    for (uint32_t i = 0; i < source.size(); i++) {
+        points.push_back(cosmodon::vector(source[i].x, source[i].y, source[i].z));
+    }
+    build(points.data(), points.size());
+}
+
+// Build from points.
+void cosmodon::physics::hull::build(const cosmodon::vector *input, uint32_t count)
+{
+    clear();
+
+    // Drop repeated points.
+    std::vector<cosmodon::vector> points;
+    std::set<std::pair<std::pair<float, float>, float>> seen;
+    for (uint32_t i = 0; i < count; i++) {
+        if (seen.insert(std::make_pair(std::make_pair(input[i].x, input[i].y), input[i].z)).second) {
+            points.push_back(input[i]);
+        }
+    }
+
+    // Keep everything when the set cannot enclose a volume.
+    auto keep_all = [&]() {
+        for (const cosmodon::vector &p : points) {
+            m_points[0].push_back(p.x);
+            m_points[1].push_back(p.y);
+            m_points[2].push_back(p.z);
+        }
+    };
+    if (points.size() < 4) {
+        keep_all();
+        return;
+    }
+
+    // Tolerance scaled to the size of the set.
+    cosmodon::vector low = points[0];
+    cosmodon::vector high = points[0];
+    for (const cosmodon::vector &p : points) {
+        low = cosmodon::vector(std::min(low.x, p.x), std::min(low.y, p.y), std::min(low.z, p.z));
+        high = cosmodon::vector(std::max(high.x, p.x), std::max(high.y, p.y), std::max(high.z, p.z));
+    }
+    cosmodon::number tolerance = (high - low).magnitude() * 1e-5f;
+
+    // Start from a tetrahedron of spread out points: the extremes along x, the furthest from
+    // their line, then the furthest from their plane.
+    uint32_t a = 0;
+    uint32_t b = 0;
+    for (uint32_t i = 1; i < points.size(); i++) {
+        a = (points[i].x < points[a].x) ? i : a;
+        b = (points[i].x > points[b].x) ? i : b;
+    }
+    if (a == b) {
+        b = (a == 0) ? 1 : 0;
+        for (uint32_t i = 0; i < points.size(); i++) {
+            if ((points[i] - points[a]).magnitude() > (points[b] - points[a]).magnitude()) {
+                b = i;
+            }
+        }
+    }
+    cosmodon::vector line = (points[b] - points[a]).normal();
+    uint32_t c = a;
+    cosmodon::number furthest = 0;
+    for (uint32_t i = 0; i < points.size(); i++) {
+        cosmodon::number d = ((points[i] - points[a]) * line).magnitude();
+        if (d > furthest) {
+            furthest = d;
+            c = i;
+        }
+    }
+    if (furthest <= tolerance) {
+        keep_all();
+        return;
+    }
+    cosmodon::vector plane = ((points[b] - points[a]) * (points[c] - points[a])).normal();
+    uint32_t d = a;
+    furthest = 0;
+    for (uint32_t i = 0; i < points.size(); i++) {
+        cosmodon::number distance = std::fabs(plane.dot(points[i] - points[a]));
+        if (distance > furthest) {
+            furthest = distance;
+            d = i;
+        }
+    }
+    if (furthest <= tolerance) {
+        keep_all();
+        return;
+    }
+
+    cosmodon::vector inside = points[a] + points[b] + points[c] + points[d];
+    inside = cosmodon::vector(inside.x / 4, inside.y / 4, inside.z / 4);
+    std::vector<face> faces;
+    faces.push_back(make_face(points, a, b, c, inside));
+    faces.push_back(make_face(points, a, b, d, inside));
+    faces.push_back(make_face(points, a, c, d, inside));
+    faces.push_back(make_face(points, b, c, d, inside));
+
+    // Add points one at a time, replacing the faces each sees with a cone to its horizon.
+    std::vector<bool> visible;
+    std::set<std::pair<uint32_t, uint32_t>> edges;
+    for (uint32_t i = 0; i < points.size(); i++) {
+        visible.assign(faces.size(), false);
+        bool outside = false;
+        for (uint32_t f = 0; f < faces.size(); f++) {
+            if (faces[f].normal.dot(points[i]) - faces[f].offset > tolerance) {
+                visible[f] = true;
+                outside = true;
+            }
+        }
+        if (!outside) {
+            continue;
+        }
+
+        // Edges of seen faces whose reverse belongs to no seen face form the horizon.
+        edges.clear();
+        for (uint32_t f = 0; f < faces.size(); f++) {
+            if (visible[f]) {
+                for (uint8_t e = 0; e < 3; e++) {
+                    edges.insert(std::make_pair(faces[f].corners[e], faces[f].corners[(e + 1) % 3]));
+                }
+            }
+        }
+        std::vector<face> kept;
+        for (uint32_t f = 0; f < faces.size(); f++) {
+            if (!visible[f]) {
+                kept.push_back(faces[f]);
+            }
+        }
+        for (const std::pair<uint32_t, uint32_t> &edge : edges) {
+            if (edges.count(std::make_pair(edge.second, edge.first)) == 0) {
+                kept.push_back(make_face(points, edge.first, edge.second, i, inside));
+            }
+        }
+        faces.swap(kept);
+    }
+
+    // Keep corners used by faces.
+    std::vector<bool> used(points.size(), false);
+    for (const face &f : faces) {
+        for (uint8_t e = 0; e < 3; e++) {
+            used[f.corners[e]] = true;
+        }
+    }
+    for (uint32_t i = 0; i < points.size(); i++) {
+        if (used[i]) {
+            m_points[0].push_back(points[i].x);
+            m_points[1].push_back(points[i].y);
+            m_points[2].push_back(points[i].z);
+        }
+    }
+}
+
+// Remove all points.
+void cosmodon::physics::hull::clear()
+{
+    for (uint8_t i = 0; i < 3; i++) {
+        m_points[i].clear();
+    }
+}
+
+// Check if empty.
+bool cosmodon::physics::hull::is_empty() const
+{
+    return m_points[0].empty();
+}
+
+// Retrieve the amount of corners.
+uint32_t cosmodon::physics::hull::size() const
+{
+    return m_points[0].size();
+}
+
+// Retrieve a corner.
+cosmodon::vector cosmodon::physics::hull::get_point(uint32_t index) const
+{
+    return cosmodon::vector(m_points[0][index], m_points[1][index], m_points[2][index]);
+}
+
+// Retrieve the furthest corner along a direction.
+cosmodon::vector cosmodon::physics::hull::support(const cosmodon::vector &direction) const
+{
+    const float *x = m_points[0].data();
+    const float *y = m_points[1].data();
+    const float *z = m_points[2].data();
+    uint32_t best = 0;
+    float furthest = x[0] * direction.x + y[0] * direction.y + z[0] * direction.z;
+    for (uint32_t i = 1; i < m_points[0].size(); i++) {
+        float distance = x[i] * direction.x + y[i] * direction.y + z[i] * direction.z;
+        if (distance > furthest) {
+            furthest = distance;
+            best = i;
+        }
+    }
+    return get_point(best);
+}
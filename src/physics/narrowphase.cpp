@@ -0,0 +1,720 @@
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+#include <physics/narrowphase.hpp>
+
+namespace
+{
+    // Iteration limits of GJK, EPA and conservative advancement.
+    const uint32_t gjk_iterations = 64;
+    const uint32_t epa_iterations = 64;
+    const uint32_t advance_iterations = 32;
+
+    // Relative tolerance of convergence.
+    const cosmodon::number tolerance = 1e-5f;
+
+    // A point of the difference of two shapes, with the points of each shape giving it.
+    struct point
+    {
+        cosmodon::vector w;
+        cosmodon::vector a;
+        cosmodon::vector b;
+    };
+
+    // A simplex of GJK, with the weights of its closest point to the origin.
+    struct simplex
+    {
+        point points[4];
+        cosmodon::number weights[4];
+        uint32_t count;
+    };
+
+    // A face of the EPA polytope.
+    struct face
+    {
+        uint32_t corners[3];
+        cosmodon::vector normal;
+        cosmodon::number distance;
+    };
+}
+
+// Local function to scale a vector.
+static cosmodon::vector scale(const cosmodon::vector &v, cosmodon::number s)
+{
+    return cosmodon::vector(v.x * s, v.y * s, v.z * s);
+}
+
+// Local function to find a point of the difference of two shapes.
+static point get_support(const cosmodon::physics::convex &first, const cosmodon::physics::convex &second, const cosmodon::vector &direction)
+{
+    point result;
+    result.a = first.support(direction);
+    result.b = second.support(scale(direction, -1));
+    result.w = result.a - result.b;
+    return result;
+}
+
+// Local function to find the largest squared magnitude among a point and the points giving it.
+static cosmodon::number get_magnitude(const point &p)
+{
+    return std::max(std::max(p.w.dot(p.w), p.a.dot(p.a)), p.b.dot(p.b));
+}
+
+// Local function to weigh a simplex to its closest point to the origin on a segment.
+static void reduce_segment(simplex &s, uint32_t i, uint32_t j, cosmodon::number &weight_i, cosmodon::number &weight_j)
+{
+    cosmodon::vector ab = s.points[j].w - s.points[i].w;
+    cosmodon::number length = ab.dot(ab);
+    cosmodon::number t = (length > 0) ? -s.points[i].w.dot(ab) / length : 0;
+    t = std::min<cosmodon::number>(std::max<cosmodon::number>(t, 0), 1);
+    weight_i = 1 - t;
+    weight_j = t;
+}
+
+// Local function to find the weights of the closest point of a triangle to the origin. Thin
+// triangles lose too much to rounding for Voronoi regions, so the inside and each edge are tried,
+// keeping the closest.
+static void reduce_triangle(const cosmodon::vector &a, const cosmodon::vector &b, const cosmodon::vector &c, cosmodon::number *weights)
+{
+    const cosmodon::vector *corners[3] = {&a, &b, &c};
+    cosmodon::number best = -1;
+    weights[0] = 1;
+    weights[1] = weights[2] = 0;
+
+    // The origin projected inside the triangle.
+    cosmodon::vector n = (b - a) * (c - a);
+    cosmodon::number area = n.dot(n);
+    if (area > 0) {
+        cosmodon::number u = n.dot(b * c) / area;
+        cosmodon::number v = n.dot(c * a) / area;
+        cosmodon::number w = 1 - u - v;
+        if (u >= 0 && v >= 0 && w >= 0) {
+            cosmodon::number height = n.dot(a);
+            best = height * height / area;
+            weights[0] = u;
+            weights[1] = v;
+            weights[2] = w;
+        }
+    }
+
+    // Each edge, ends included.
+    for (uint8_t i = 0; i < 3; i++) {
+        const cosmodon::vector &p = *corners[i];
+        const cosmodon::vector &q = *corners[(i + 1) % 3];
+        cosmodon::vector edge = q - p;
+        cosmodon::number length = edge.dot(edge);
+        cosmodon::number t = (length > 0) ? -p.dot(edge) / length : 0;
+        t = std::min<cosmodon::number>(std::max<cosmodon::number>(t, 0), 1);
+        cosmodon::vector closest = p + scale(edge, t);
+        cosmodon::number distance = closest.dot(closest);
+        if (best < 0 || distance < best) {
+            best = distance;
+            weights[0] = weights[1] = weights[2] = 0;
+            weights[i] = 1 - t;
+            weights[(i + 1) % 3] = t;
+        }
+    }
+}
+
+// Local function to compute the weighted point of a simplex.
+static cosmodon::vector get_point(const simplex &s)
+{
+    cosmodon::vector result(0, 0, 0);
+    for (uint32_t i = 0; i < s.count; i++) {
+        result = result + scale(s.points[i].w, s.weights[i]);
+    }
+    return result;
+}
+
+// Local function to find the closest point of a simplex to the origin. Near the origin, weighing
+// far corners spoils its direction, so a triangle gives it through its plane instead.
+static cosmodon::vector get_closest(const simplex &s)
+{
+    if (s.count == 3) {
+        cosmodon::vector n = (s.points[1].w - s.points[0].w) * (s.points[2].w - s.points[0].w);
+        cosmodon::number area = n.dot(n);
+        if (area > 0) {
+            return scale(n, n.dot(s.points[0].w) / area);
+        }
+    }
+    return get_point(s);
+}
+
+// Local function to weigh a simplex to its closest point to the origin, dropping unused points.
+static void reduce(simplex &s)
+{
+    cosmodon::number weights[4] = {0, 0, 0, 0};
+    if (s.count == 1) {
+        weights[0] = 1;
+    } else if (s.count == 2) {
+        reduce_segment(s, 0, 1, weights[0], weights[1]);
+    } else if (s.count == 3) {
+        reduce_triangle(s.points[0].w, s.points[1].w, s.points[2].w, weights);
+    } else {
+        // Inside the tetrahedron when the origin lies behind every face, seen from the far corner.
+        // A flat tetrahedron holds nothing, so only its faces are searched.
+        static const uint8_t faces[4][4] = {{0, 1, 2, 3}, {0, 1, 3, 2}, {0, 2, 3, 1}, {1, 2, 3, 0}};
+        cosmodon::vector e1 = s.points[1].w - s.points[0].w;
+        cosmodon::vector e2 = s.points[2].w - s.points[0].w;
+        cosmodon::vector e3 = s.points[3].w - s.points[0].w;
+        cosmodon::number volume = std::fabs((e1 * e2).dot(e3));
+        bool flat = volume <= tolerance * std::sqrt(e1.dot(e1) * e2.dot(e2) * e3.dot(e3));
+        cosmodon::number best = -1;
+        for (uint8_t f = 0; f < 4; f++) {
+            const cosmodon::vector &a = s.points[faces[f][0]].w;
+            const cosmodon::vector &b = s.points[faces[f][1]].w;
+            const cosmodon::vector &c = s.points[faces[f][2]].w;
+            const cosmodon::vector &d = s.points[faces[f][3]].w;
+            cosmodon::vector n = (b - a) * (c - a);
+            if (!flat && n.dot(scale(a, -1)) * n.dot(d - a) >= 0) {
+                continue;
+            }
+            cosmodon::number face_weights[3];
+            reduce_triangle(a, b, c, face_weights);
+            cosmodon::vector closest = scale(a, face_weights[0]) + scale(b, face_weights[1]) + scale(c, face_weights[2]);
+            cosmodon::number distance = closest.dot(closest);
+            if (best < 0 || distance < best) {
+                best = distance;
+                weights[0] = weights[1] = weights[2] = weights[3] = 0;
+                for (uint8_t i = 0; i < 3; i++) {
+                    weights[faces[f][i]] = face_weights[i];
+                }
+            }
+        }
+        if (best < 0) {
+            for (uint8_t i = 0; i < 4; i++) {
+                s.weights[i] = 0.25f;
+            }
+            return;
+        }
+    }
+
+    // Keep points with weight.
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < s.count; i++) {
+        if (weights[i] > 0) {
+            s.points[kept] = s.points[i];
+            s.weights[kept] = weights[i];
+            kept++;
+        }
+    }
+    if (kept == 0) {
+        s.weights[0] = 1;
+        kept = 1;
+    }
+    s.count = kept;
+}
+
+// Local function to run GJK, leaving the final simplex. Returns whether the shapes overlap.
+static bool run_gjk(const cosmodon::physics::convex &first, const cosmodon::physics::convex &second, simplex &s)
+{
+    cosmodon::vector direction = second.get_origin() - first.get_origin();
+    if (direction.dot(direction) == 0) {
+        direction = cosmodon::vector(1, 0, 0);
+    }
+    s.points[0] = get_support(first, second, scale(direction, -1));
+    s.weights[0] = 1;
+    s.count = 1;
+
+    cosmodon::vector v = s.points[0].w;
+    for (uint32_t iteration = 0; iteration < gjk_iterations; iteration++) {
+        // The origin counts as reached within rounding of the points giving it, which grows
+        // with the size of the shapes and their distance from the world origin.
+        cosmodon::number length = v.dot(v);
+        cosmodon::number largest = 0;
+        for (uint32_t i = 0; i < s.count; i++) {
+            largest = std::max(largest, get_magnitude(s.points[i]));
+        }
+        if (length <= tolerance * tolerance * std::max<cosmodon::number>(largest, 1)) {
+            return true;
+        }
+
+        // Stop when the new point brings the distance no closer.
+        point next = get_support(first, second, scale(v, -1));
+        if (length - v.dot(next.w) <= tolerance * length) {
+            return false;
+        }
+        for (uint32_t i = 0; i < s.count; i++) {
+            if (s.points[i].w == next.w) {
+                return false;
+            }
+        }
+
+        s.points[s.count++] = next;
+        reduce(s);
+        if (s.count == 4) {
+            return true;
+        }
+        v = get_closest(s);
+    }
+    return false;
+}
+
+// Local function to add a polytope face, facing away from an inner point.
+static bool add_face(std::vector<face> &faces, const std::vector<point> &points, uint32_t a, uint32_t b, uint32_t c)
+{
+    face result;
+    result.corners[0] = a;
+    result.corners[1] = b;
+    result.corners[2] = c;
+    cosmodon::vector n = (points[b].w - points[a].w) * (points[c].w - points[a].w);
+    cosmodon::number length = n.magnitude();
+    if (length <= 0) {
+        return false;
+    }
+    result.normal = scale(n, 1 / length);
+    result.distance = result.normal.dot(points[a].w);
+    faces.push_back(result);
+    return true;
+}
+
+// Local function to grow a simplex holding the origin into a tetrahedron.
+static bool inflate(const cosmodon::physics::convex &first, const cosmodon::physics::convex &second, std::vector<point> &points)
+{
+    static const cosmodon::number axes[6][3] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+
+    // A point: add any distinct point.
+    for (uint8_t i = 0; points.size() == 1 && i < 6; i++) {
+        point p = get_support(first, second, cosmodon::vector(axes[i][0], axes[i][1], axes[i][2]));
+        if ((p.w - points[0].w).magnitude() > tolerance) {
+            points.push_back(p);
+        }
+    }
+
+    // A segment: add a point off its line, searching around it.
+    if (points.size() == 2) {
+        cosmodon::vector line = (points[1].w - points[0].w).normal();
+        uint8_t least = (std::fabs(line.x) < std::fabs(line.y)) ? ((std::fabs(line.x) < std::fabs(line.z)) ? 0 : 2) : ((std::fabs(line.y) < std::fabs(line.z)) ? 1 : 2);
+        cosmodon::vector across = (line * cosmodon::vector(axes[least * 2][0], axes[least * 2][1], axes[least * 2][2])).normal();
+        cosmodon::vector other = line * across;
+        cosmodon::vector directions[4] = {across, scale(across, -1), other, scale(other, -1)};
+        for (uint8_t i = 0; points.size() == 2 && i < 4; i++) {
+            point p = get_support(first, second, directions[i]);
+            if (((p.w - points[0].w) * line).magnitude() > tolerance) {
+                points.push_back(p);
+            }
+        }
+    }
+
+    // A triangle: add a point off its plane, on either side.
+    if (points.size() == 3) {
+        cosmodon::vector n = ((points[1].w - points[0].w) * (points[2].w - points[0].w)).normal();
+        for (uint8_t i = 0; points.size() == 3 && i < 2; i++) {
+            cosmodon::vector direction = (i == 0) ? n : scale(n, -1);
+            point p = get_support(first, second, direction);
+            if (std::fabs(n.dot(p.w - points[0].w)) > tolerance) {
+                points.push_back(p);
+            }
+        }
+    }
+    return points.size() == 4;
+}
+
+// Local function to find how far the second shape moves along a unit direction to separate, and the
+// deepest points there.
+static cosmodon::number get_overlap(const cosmodon::physics::convex &first, const cosmodon::physics::convex &second, const cosmodon::vector &direction, point &deepest)
+{
+    deepest = get_support(first, second, direction);
+    return direction.dot(deepest.w);
+}
+
+// Local function to fill a contact from a penetration direction, depth and deepest points.
+static void fill(cosmodon::physics::contact &result, const cosmodon::vector &normal, cosmodon::number depth, const cosmodon::vector &on_first, const cosmodon::vector &on_second)
+{
+    result.normal = normal;
+    result.depth = std::max<cosmodon::number>(depth, 0);
+    result.on_first = on_first;
+    result.on_second = on_second;
+    result.point = scale(on_first + on_second, 0.5f);
+}
+
+// Constructor.
+cosmodon::physics::convex::convex(const cosmodon::physics::hull &shape, const cosmodon::matrix &transform)
+  : m_hull(&shape)
+{
+    for (uint8_t r = 0; r < 3; r++) {
+        for (uint8_t c = 0; c < 3; c++) {
+            m_linear[r * 3 + c] = transform[r][c];
+        }
+        m_offset[r] = transform[r][3];
+    }
+}
+
+// Retrieve the furthest world point along a direction.
+cosmodon::vector cosmodon::physics::convex::support(const cosmodon::vector &direction) const
+{
+    // Directions transform by the transpose into local space.
+    const float *m = m_linear;
+    cosmodon::vector local(
+        m[0] * direction.x + m[3] * direction.y + m[6] * direction.z,
+        m[1] * direction.x + m[4] * direction.y + m[7] * direction.z,
+        m[2] * direction.x + m[5] * direction.y + m[8] * direction.z
+    );
+    cosmodon::vector p = m_hull->support(local);
+    return cosmodon::vector(
+        m[0] * p.x + m[1] * p.y + m[2] * p.z + m_offset[0],
+        m[3] * p.x + m[4] * p.y + m[5] * p.z + m_offset[1],
+        m[6] * p.x + m[7] * p.y + m[8] * p.z + m_offset[2]
+    );
+}
+
+// Retrieve the world origin.
+cosmodon::vector cosmodon::physics::convex::get_origin() const
+{
+    return cosmodon::vector(m_offset[0], m_offset[1], m_offset[2]);
+}
+
+// Move the shape.
+void cosmodon::physics::convex::translate(const cosmodon::vector &offset)
+{
+    m_offset[0] += offset.x;
+    m_offset[1] += offset.y;
+    m_offset[2] += offset.z;
+}
+
+// Constructor.
+cosmodon::physics::cuboid::cuboid()
+  : center(0, 0, 0)
+{
+    axes[0] = cosmodon::vector(1, 0, 0);
+    axes[1] = cosmodon::vector(0, 1, 0);
+    axes[2] = cosmodon::vector(0, 0, 1);
+    half[0] = half[1] = half[2] = 0;
+}
+
+// Constructor, from a local box.
+cosmodon::physics::cuboid::cuboid(const cosmodon::bounds &local, const cosmodon::matrix &transform)
+{
+    cosmodon::vector c = local.get_center();
+    cosmodon::vector size = local.get_size();
+    cosmodon::number sizes[3] = {size.x, size.y, size.z};
+    center = cosmodon::vector(
+        transform[0][0] * c.x + transform[0][1] * c.y + transform[0][2] * c.z + transform[0][3],
+        transform[1][0] * c.x + transform[1][1] * c.y + transform[1][2] * c.z + transform[1][3],
+        transform[2][0] * c.x + transform[2][1] * c.y + transform[2][2] * c.z + transform[2][3]
+    );
+
+    // Columns carry the local axes, scaled.
+    for (uint8_t i = 0; i < 3; i++) {
+        cosmodon::vector column(transform[0][i], transform[1][i], transform[2][i]);
+        cosmodon::number length = column.magnitude();
+        axes[i] = (length > 0) ? scale(column, 1 / length) : cosmodon::vector(i == 0, i == 1, i == 2);
+        half[i] = sizes[i] * length / 2;
+    }
+}
+
+// Find the distance between two shapes.
+cosmodon::number cosmodon::physics::get_distance(const cosmodon::physics::convex &first, const cosmodon::physics::convex &second, cosmodon::vector &on_first, cosmodon::vector &on_second)
+{
+    simplex s;
+    bool overlapping = run_gjk(first, second, s);
+    on_first = cosmodon::vector(0, 0, 0);
+    on_second = cosmodon::vector(0, 0, 0);
+    for (uint32_t i = 0; i < s.count; i++) {
+        on_first = on_first + scale(s.points[i].a, s.weights[i]);
+        on_second = on_second + scale(s.points[i].b, s.weights[i]);
+    }
+    return overlapping ? 0 : (on_first - on_second).magnitude();
+}
+
+// Check if two shapes overlap.
+bool cosmodon::physics::intersects(const cosmodon::physics::convex &first, const cosmodon::physics::convex &second)
+{
+    simplex s;
+    return run_gjk(first, second, s);
+}
+
+// Find how two shapes overlap.
+bool cosmodon::physics::collide(const cosmodon::physics::convex &first, const cosmodon::physics::convex &second, cosmodon::physics::contact &result)
+{
+    simplex s;
+    if (!run_gjk(first, second, s)) {
+        return false;
+    }
+
+    // The overlap along any direction separates the shapes, so the least found answers when
+    // the polytope cannot, starting from the direction between the shapes.
+    cosmodon::vector fallback = (second.get_origin() - first.get_origin()).normal();
+    if (fallback.dot(fallback) == 0) {
+        fallback = cosmodon::vector(1, 0, 0);
+    }
+    point fallback_point;
+    cosmodon::number fallback_depth = get_overlap(first, second, fallback, fallback_point);
+
+    // A difference without volume leaves the simplex flat, so try both sides of its plane.
+    std::vector<point> points(s.points, s.points + s.count);
+    if (!inflate(first, second, points)) {
+        if (points.size() == 3) {
+            cosmodon::vector n = ((points[1].w - points[0].w) * (points[2].w - points[0].w)).normal();
+            for (uint8_t side = 0; side < 2; side++) {
+                point p;
+                cosmodon::number depth = get_overlap(first, second, n, p);
+                if (depth < fallback_depth) {
+                    fallback = n;
+                    fallback_depth = depth;
+                    fallback_point = p;
+                }
+                n = scale(n, -1);
+            }
+        }
+        fill(result, fallback, fallback_depth, fallback_point.a, fallback_point.b);
+        return true;
+    }
+
+    // GJK reaches the origin within rounding of the points, so the polytope may miss it by as
+    // much.
+    cosmodon::number largest = 1;
+    for (const point &p : points) {
+        largest = std::max(largest, get_magnitude(p));
+    }
+    cosmodon::number outside = tolerance * std::sqrt(largest);
+
+    std::vector<face> faces;
+    cosmodon::vector inside = scale(points[0].w + points[1].w + points[2].w + points[3].w, 0.25f);
+    static const uint8_t corners[4][3] = {{0, 1, 2}, {0, 3, 1}, {0, 2, 3}, {1, 3, 2}};
+    for (uint8_t f = 0; f < 4; f++) {
+        uint32_t a = corners[f][0];
+        uint32_t b = corners[f][1];
+        uint32_t c = corners[f][2];
+        cosmodon::vector n = (points[b].w - points[a].w) * (points[c].w - points[a].w);
+        if (n.dot(points[a].w - inside) < 0) {
+            std::swap(b, c);
+        }
+        add_face(faces, points, a, b, c);
+    }
+
+    // Push the face closest to the origin outwards until the shape ends there. Rounding may
+    // leave a polytope no longer holding the origin, which falls back to the least overlap.
+    face best = faces[0];
+    bool converged = false;
+    std::vector<std::pair<uint32_t, uint32_t>> edges;
+    for (uint32_t iteration = 0; iteration < epa_iterations && !faces.empty(); iteration++) {
+        best = *std::min_element(faces.begin(), faces.end(), [](const face &a, const face &b) {
+            return a.distance < b.distance;
+        });
+        point next;
+        cosmodon::number reach = get_overlap(first, second, best.normal, next);
+        if (reach < fallback_depth) {
+            fallback = best.normal;
+            fallback_depth = reach;
+            fallback_point = next;
+        }
+        cosmodon::number margin = tolerance * std::max<cosmodon::number>(1, std::fabs(reach));
+        if (best.distance < -std::max(margin, outside)) {
+            break;
+        }
+        if (reach - best.distance <= margin) {
+            converged = true;
+            break;
+        }
+
+        // Remove faces the new point clearly sees, keeping the edges around them. Points on
+        // the plane of a face leave it, as flat sides of boxes give many.
+        uint32_t index = points.size();
+        points.push_back(next);
+        edges.clear();
+        std::vector<face> kept;
+        for (const face &f : faces) {
+            if (f.normal.dot(next.w) - f.distance > margin) {
+                for (uint8_t e = 0; e < 3; e++) {
+                    std::pair<uint32_t, uint32_t> edge(f.corners[e], f.corners[(e + 1) % 3]);
+                    auto reverse = std::find(edges.begin(), edges.end(), std::make_pair(edge.second, edge.first));
+                    if (reverse != edges.end()) {
+                        edges.erase(reverse);
+                    } else {
+                        edges.push_back(edge);
+                    }
+                }
+            } else {
+                kept.push_back(f);
+            }
+        }
+        for (const std::pair<uint32_t, uint32_t> &edge : edges) {
+            add_face(kept, points, edge.first, edge.second, index);
+        }
+        faces.swap(kept);
+    }
+
+    // The face directions left are near the answer, so the least overlap among them stands in.
+    if (!converged) {
+        for (const face &f : faces) {
+            point p;
+            cosmodon::number depth = get_overlap(first, second, f.normal, p);
+            if (depth < fallback_depth) {
+                fallback = f.normal;
+                fallback_depth = depth;
+                fallback_point = p;
+            }
+        }
+        fill(result, fallback, fallback_depth, fallback_point.a, fallback_point.b);
+        return true;
+    }
+
+    // Weigh the corners of the closest face at the origin projected onto it.
+    cosmodon::vector projected = scale(best.normal, best.distance);
+    cosmodon::number weights[3];
+    const point &a = points[best.corners[0]];
+    const point &b = points[best.corners[1]];
+    const point &c = points[best.corners[2]];
+    cosmodon::vector v0 = b.w - a.w;
+    cosmodon::vector v1 = c.w - a.w;
+    cosmodon::vector v2 = projected - a.w;
+    cosmodon::number d00 = v0.dot(v0);
+    cosmodon::number d01 = v0.dot(v1);
+    cosmodon::number d11 = v1.dot(v1);
+    cosmodon::number d20 = v2.dot(v0);
+    cosmodon::number d21 = v2.dot(v1);
+    cosmodon::number denominator = d00 * d11 - d01 * d01;
+    if (denominator == 0) {
+        weights[0] = 1;
+        weights[1] = weights[2] = 0;
+    } else {
+        weights[1] = (d11 * d20 - d01 * d21) / denominator;
+        weights[2] = (d00 * d21 - d01 * d20) / denominator;
+        weights[0] = 1 - weights[1] - weights[2];
+    }
+    fill(result, best.normal, best.distance,
+      scale(a.a, weights[0]) + scale(b.a, weights[1]) + scale(c.a, weights[2]),
+      scale(a.b, weights[0]) + scale(b.b, weights[1]) + scale(c.b, weights[2]));
+    return true;
+}
+
+// Local function to average the corners of a box furthest along a direction, giving the centre
+// of the face, edge or corner there.
+static cosmodon::vector get_feature(const cosmodon::physics::cuboid &box, const cosmodon::vector &direction)
+{
+    cosmodon::vector result = box.center;
+    for (uint8_t i = 0; i < 3; i++) {
+        cosmodon::number along = box.axes[i].dot(direction);
+        if (std::fabs(along) > 1e-3f) {
+            result = result + scale(box.axes[i], (along > 0) ? box.half[i] : -box.half[i]);
+        }
+    }
+    return result;
+}
+
+// Find how two boxes overlap.
+bool cosmodon::physics::collide(const cosmodon::physics::cuboid &first, const cosmodon::physics::cuboid &second, cosmodon::physics::contact &result)
+{
+    cosmodon::vector offset = second.center - first.center;
+    cosmodon::number least = -1;
+    cosmodon::vector normal;
+    int8_t kind = -1;
+
+    // Each candidate axis: 0 to 2 are faces of the first box, 3 to 5 of the second, then edges.
+    for (uint8_t k = 0; k < 15; k++) {
+        cosmodon::vector axis;
+        if (k < 3) {
+            axis = first.axes[k];
+        } else if (k < 6) {
+            axis = second.axes[k - 3];
+        } else {
+            axis = first.axes[(k - 6) / 3] * second.axes[(k - 6) % 3];
+            cosmodon::number length = axis.magnitude();
+
+            // Parallel edges give no new direction.
+            if (length < 1e-4f) {
+                continue;
+            }
+            axis = scale(axis, 1 / length);
+        }
+
+        cosmodon::number reach = 0;
+        for (uint8_t i = 0; i < 3; i++) {
+            reach += first.half[i] * std::fabs(first.axes[i].dot(axis)) + second.half[i] * std::fabs(second.axes[i].dot(axis));
+        }
+        cosmodon::number distance = offset.dot(axis);
+        cosmodon::number overlap = reach - std::fabs(distance);
+        if (overlap < 0) {
+            return false;
+        }
+
+        // Faces win ties against edges, which are less stable from frame to frame.
+        bool better = (least < 0) || ((k < 6) ? (overlap < least) : (overlap < least * 0.95f - 1e-4f));
+        if (better) {
+            least = overlap;
+            normal = (distance < 0) ? scale(axis, -1) : axis;
+            kind = k;
+        }
+    }
+
+    cosmodon::vector on_first;
+    cosmodon::vector on_second;
+    if (kind < 3) {
+        // A face of the first box against the feature of the second deepest inside it.
+        on_second = get_feature(second, scale(normal, -1));
+        on_first = on_second + scale(normal, least);
+    } else if (kind < 6) {
+        on_first = get_feature(first, normal);
+        on_second = on_first - scale(normal, least);
+    } else {
+        // Two edges: the closest points of their lines.
+        uint8_t i = (kind - 6) / 3;
+        uint8_t j = (kind - 6) % 3;
+        cosmodon::vector p = first.center;
+        cosmodon::vector q = second.center;
+        for (uint8_t k = 0; k < 3; k++) {
+            if (k != i) {
+                p = p + scale(first.axes[k], (first.axes[k].dot(normal) > 0) ? first.half[k] : -first.half[k]);
+            }
+            if (k != j) {
+                q = q + scale(second.axes[k], (second.axes[k].dot(normal) < 0) ? second.half[k] : -second.half[k]);
+            }
+        }
+        const cosmodon::vector &u = first.axes[i];
+        const cosmodon::vector &v = second.axes[j];
+        cosmodon::vector r = p - q;
+        cosmodon::number b = u.dot(v);
+        cosmodon::number denominator = 1 - b * b;
+        cosmodon::number s = 0;
+        cosmodon::number t = 0;
+        if (denominator > 1e-6f) {
+            s = (b * v.dot(r) - u.dot(r)) / denominator;
+            t = (v.dot(r) - b * u.dot(r)) / denominator;
+        }
+        s = std::min(std::max(s, -first.half[i]), first.half[i]);
+        t = std::min(std::max(t, -second.half[j]), second.half[j]);
+        on_first = p + scale(u, s);
+        on_second = q + scale(v, t);
+    }
+    fill(result, normal, least, on_first, on_second);
+    return true;
+}
+
+// Find when a moving shape touches a still shape.
+bool cosmodon::physics::get_impact(const cosmodon::physics::convex &first, const cosmodon::vector &motion, const cosmodon::physics::convex &second, cosmodon::number &time, cosmodon::physics::contact &result, cosmodon::number tolerance)
+{
+    cosmodon::physics::convex moving = first;
+    cosmodon::vector on_first;
+    cosmodon::vector on_second;
+    cosmodon::vector normal;
+    time = 0;
+    for (uint32_t iteration = 0; iteration < advance_iterations; iteration++) {
+        cosmodon::number distance = get_distance(moving, second, on_first, on_second);
+        if (distance == 0) {
+            // Rounding may close the last gap; the previous round still has a normal.
+            if (iteration == 0) {
+                return false;
+            }
+            break;
+        }
+        normal = scale(on_second - on_first, 1 / distance);
+
+        // Moving apart, sliding past, or closing too slowly to meet within the step misses.
+        cosmodon::number closing = motion.dot(normal);
+        if (closing <= 0 || time + distance / closing > 1) {
+            return false;
+        }
+        if (distance <= tolerance) {
+            break;
+        }
+
+        // Stop short of contact, so the shapes end within the tolerance without overlapping.
+        time += (distance - tolerance / 2) / closing;
+        moving = first;
+        moving.translate(scale(motion, time));
+    }
+    fill(result, normal, 0, on_first, on_second);
+    return true;
+}
@@ -1,8 +1,9 @@
+#include <physics/boundaries/box.hpp>
 #include <physics/physical.hpp>
 
 // Constructor.
 cosmodon::physical::physical()
-: m_velocity(0), m_acceleration(0), m_static(false), m_boundary(nullptr)
+: m_velocity(0), m_acceleration(0), m_mass(1), m_static(false), m_fast(false), m_sleeping(false), m_sleep_speed(0.05f), m_boundary(nullptr), m_hull_ready(false)
 {
 
 }
@@ -14,6 +15,7 @@ void cosmodon::physical::set_velocity(cosmodon::vector velocity)
         m_velocity = 0;
     } else {
         m_velocity = velocity;
+        wake();
     }
 }
 
@@ -30,6 +32,7 @@ void cosmodon::physical::set_acceleration(cosmodon::vector acceleration)
         m_acceleration = 0;
     } else {
         m_acceleration = acceleration;
+        wake();
     }
 }
 
@@ -39,9 +42,41 @@ cosmodon::vector cosmodon::physical::get_acceleration() const
     return m_acceleration;
 }
 
+// Sets mass.
+void cosmodon::physical::set_mass(cosmodon::number mass)
+{
+    m_mass = mass;
+}
+
+// Retrieves mass.
+cosmodon::number cosmodon::physical::get_mass() const
+{
+    return m_mass;
+}
+
 // Determines if an intersection exists.
 bool cosmodon::physical::intersects(const physical &other) const
 {
+    // Box boundaries stand in for their objects, placed the same way collide() places them.
+    const cosmodon::boundaries::box *box = dynamic_cast<const cosmodon::boundaries::box*>(m_boundary);
+    const cosmodon::boundaries::box *other_box = dynamic_cast<const cosmodon::boundaries::box*>(other.m_boundary);
+    if ((box != nullptr && (other_box != nullptr || other.m_boundary == nullptr)) ||
+      (other_box != nullptr && m_boundary == nullptr)) {
+        if (box != nullptr && other_box != nullptr) {
+            cosmodon::physics::contact result;
+            return cosmodon::physics::collide(box->get_cuboid(get_matrix()), other_box->get_cuboid(other.get_matrix()), result);
+        }
+        const cosmodon::physics::hull &shape = box ? box->get_hull() : get_hull();
+        const cosmodon::physics::hull &other_shape = other_box ? other_box->get_hull() : other.get_hull();
+        if (shape.is_empty() || other_shape.is_empty()) {
+            return false;
+        }
+        return cosmodon::physics::intersects(
+            cosmodon::physics::convex(shape, box ? get_matrix() * box->get_matrix() : get_matrix()),
+            cosmodon::physics::convex(other_shape, other_box ? other.get_matrix() * other_box->get_matrix() : other.get_matrix())
+        );
+    }
+
     // Boundary heuristic is available.
     if (m_boundary) {
         if (other.m_boundary) {
@@ -58,8 +93,71 @@ bool cosmodon::physical::intersects(const physical &other) const
         return other.m_boundary->intersects(*this);
     }
 
-    // No heuristic available. @@@ To do
-    return false;
+    // No heuristic available, so compare convex hulls.
+    if (get_hull().is_empty() || other.get_hull().is_empty()) {
+        return false;
+    }
+    return cosmodon::physics::intersects(
+        cosmodon::physics::convex(get_hull(), get_matrix()),
+        cosmodon::physics::convex(other.get_hull(), other.get_matrix())
+    );
+}
+
+// Sets the boundary.
+void cosmodon::physical::set_boundary(cosmodon::boundary *b)
+{
+    m_boundary = b;
+}
+
+// Retrieves the boundary.
+cosmodon::boundary* cosmodon::physical::get_boundary() const
+{
+    return m_boundary;
+}
+
+// Checks for a shape.
+bool cosmodon::physical::has_shape() const
+{
+    return dynamic_cast<const cosmodon::boundaries::box*>(m_boundary) != nullptr || !get_hull().is_empty();
+}
+
+// Finds how this object overlaps another.
+bool cosmodon::physical::collide(const cosmodon::physical &other, cosmodon::physics::contact &result) const
+{
+    const cosmodon::boundaries::box *box = dynamic_cast<const cosmodon::boundaries::box*>(m_boundary);
+    const cosmodon::boundaries::box *other_box = dynamic_cast<const cosmodon::boundaries::box*>(other.m_boundary);
+    if (box != nullptr && other_box != nullptr) {
+        return cosmodon::physics::collide(box->get_cuboid(get_matrix()), other_box->get_cuboid(other.get_matrix()), result);
+    }
+
+    // Hulls otherwise, boxes placed by their objects.
+    const cosmodon::physics::hull &shape = box ? box->get_hull() : get_hull();
+    const cosmodon::physics::hull &other_shape = other_box ? other_box->get_hull() : other.get_hull();
+    if (shape.is_empty() || other_shape.is_empty()) {
+        return false;
+    }
+    return cosmodon::physics::collide(
+        cosmodon::physics::convex(shape, box ? get_matrix() * box->get_matrix() : get_matrix()),
+        cosmodon::physics::convex(other_shape, other_box ? other.get_matrix() * other_box->get_matrix() : other.get_matrix()),
+        result
+    );
+}
+
+// Retrieves the convex hull.
+const cosmodon::physics::hull& cosmodon::physical::get_hull() const
+{
+    if (!m_hull_ready) {
+        m_hull.build(*this);
+        m_hull_ready = true;
+    }
+    return m_hull;
+}
+
+// Rebuilds the convex hull.
+void cosmodon::physical::refresh_hull()
+{
+    m_hull.build(*this);
+    m_hull_ready = true;
 }
 
 // Sets static status.
@@ -72,3 +170,52 @@ void cosmodon::physical::set_static(bool s)
         set_acceleration(0);
     }
 }
+
+// Retrieves static status.
+bool cosmodon::physical::is_static() const
+{
+    return m_static;
+}
+
+// Sets fast status.
+void cosmodon::physical::set_fast(bool f)
+{
+    m_fast = f;
+}
+
+// Retrieves fast status.
+bool cosmodon::physical::is_fast() const
+{
+    return m_fast;
+}
+
+// Sets sleep speed.
+void cosmodon::physical::set_sleep_speed(cosmodon::number speed)
+{
+    m_sleep_speed = speed;
+}
+
+// Retrieves sleep speed.
+cosmodon::number cosmodon::physical::get_sleep_speed() const
+{
+    return m_sleep_speed;
+}
+
+// Puts the object to sleep.
+void cosmodon::physical::sleep()
+{
+    m_velocity = 0;
+    m_sleeping = true;
+}
+
+// Wakes the object.
+void cosmodon::physical::wake()
+{
+    m_sleeping = false;
+}
+
+// Checks sleep status.
+bool cosmodon::physical::is_sleeping() const
+{
+    return m_sleeping;
+}
@@ -0,0 +1,535 @@
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <common/simd.hpp>
+#include <physics/solver.hpp>
+
+namespace
+{
+    // Rows from which an island is colored and spread across the pool.
+    const uint32_t large_island = 256;
+
+    // Rows of one color solved per pool job, a multiple of four.
+    const uint32_t rows_per_job = 128;
+
+    // Colors tracked per body. Rows finding none free are solved in order afterwards.
+    const uint32_t color_limit = 64;
+
+    // Fraction of overlap removed per step, overlap left alone to keep contacts steady, and the
+    // largest speed overlaps are pushed out at.
+    const cosmodon::number correction = 0.2f;
+    const cosmodon::number slop = 0.005f;
+    const cosmodon::number push_limit = 3.0f;
+
+    // Index meaning no body or island.
+    const uint32_t nothing = 0xffffffff;
+}
+
+// Local function to run jobs across a pool, or in order without one.
+static void run(cosmodon::pool *threads, uint32_t jobs, const cosmodon::pool::task &function)
+{
+    if (threads == nullptr || threads->size() < 2 || jobs < 2) {
+        for (uint32_t i = 0; i < jobs; i++) {
+            function(i, 0);
+        }
+    } else {
+        threads->run(jobs, function);
+    }
+}
+
+// Constructor.
+cosmodon::physics::solver::solver()
+  : m_iterations(8), m_friction(0.5f), m_island_count(0)
+{
+
+}
+
+// Set iterations.
+void cosmodon::physics::solver::set_iterations(uint8_t iterations)
+{
+    m_iterations = iterations;
+}
+
+// Retrieve iterations.
+uint8_t cosmodon::physics::solver::get_iterations() const
+{
+    return m_iterations;
+}
+
+// Set friction.
+void cosmodon::physics::solver::set_friction(cosmodon::number friction)
+{
+    m_friction = friction;
+}
+
+// Remove contacts.
+void cosmodon::physics::solver::clear()
+{
+    m_contacts.clear();
+}
+
+// Add a contact.
+void cosmodon::physics::solver::add(uint32_t first, uint32_t second, const cosmodon::physics::contact &touch, uint64_t key)
+{
+    entry e = {first, second, touch, key};
+    m_contacts.push_back(e);
+}
+
+// Find an island root.
+uint32_t cosmodon::physics::solver::find(uint32_t body)
+{
+    uint32_t root = body;
+    while (m_parent[root] != root) {
+        root = m_parent[root];
+    }
+    while (m_parent[body] != root) {
+        uint32_t next = m_parent[body];
+        m_parent[body] = root;
+        body = next;
+    }
+    return root;
+}
+
+// Apply previous impulses.
+void cosmodon::physics::solver::warm_start(uint32_t first, uint32_t last)
+{
+    for (uint32_t r = first; r < last; r++) {
+        uint32_t a = m_first[r];
+        uint32_t b = m_second[r];
+        for (uint8_t k = 0; k < 3; k++) {
+            float p = m_normal[k][r] * m_impulse[0][r] + m_tangent[0][k][r] * m_impulse[1][r] + m_tangent[1][k][r] * m_impulse[2][r];
+            if (m_inverse[a] > 0) {
+                m_velocity[k][a] -= p * m_inverse[a];
+            }
+            if (m_inverse[b] > 0) {
+                m_velocity[k][b] += p * m_inverse[b];
+            }
+        }
+    }
+}
+
+// Solve rows in order.
+void cosmodon::physics::solver::solve_rows(uint32_t first, uint32_t last)
+{
+    for (uint32_t r = first; r < last; r++) {
+        uint32_t a = m_first[r];
+        uint32_t b = m_second[r];
+        float ia = m_inverse[a];
+        float ib = m_inverse[b];
+        float va[3] = {m_velocity[0][a], m_velocity[1][a], m_velocity[2][a]};
+        float vb[3] = {m_velocity[0][b], m_velocity[1][b], m_velocity[2][b]};
+
+        // Sliding first, limited by the push of the last iteration.
+        float limit = m_friction * m_impulse[0][r];
+        for (uint8_t j = 0; j < 2; j++) {
+            float speed = 0;
+            for (uint8_t k = 0; k < 3; k++) {
+                speed += (vb[k] - va[k]) * m_tangent[j][k][r];
+            }
+            float old = m_impulse[j + 1][r];
+            float total = std::min(std::max(old - m_mass[r] * speed, -limit), limit);
+            float change = total - old;
+            m_impulse[j + 1][r] = total;
+            for (uint8_t k = 0; k < 3; k++) {
+                va[k] -= m_tangent[j][k][r] * change * ia;
+                vb[k] += m_tangent[j][k][r] * change * ib;
+            }
+        }
+
+        // Then the push, which never pulls.
+        float speed = 0;
+        for (uint8_t k = 0; k < 3; k++) {
+            speed += (vb[k] - va[k]) * m_normal[k][r];
+        }
+        float old = m_impulse[0][r];
+        float total = std::max(old - m_mass[r] * speed, 0.0f);
+        float change = total - old;
+        m_impulse[0][r] = total;
+        for (uint8_t k = 0; k < 3; k++) {
+            va[k] -= m_normal[k][r] * change * ia;
+            vb[k] += m_normal[k][r] * change * ib;
+        }
+
+        // Static bodies stay untouched, since islands solved at once may share them.
+        for (uint8_t k = 0; k < 3; k++) {
+            if (ia > 0) {
+                m_velocity[k][a] = va[k];
+            }
+            if (ib > 0) {
+                m_velocity[k][b] = vb[k];
+            }
+        }
+    }
+}
+
+// Solve four rows at once.
+void cosmodon::physics::solver::solve_rows4(uint32_t first)
+{
+    typedef cosmodon::simd::float4 float4;
+    const uint32_t *a = &m_first[first];
+    const uint32_t *b = &m_second[first];
+    float4 ia(m_inverse[a[0]], m_inverse[a[1]], m_inverse[a[2]], m_inverse[a[3]]);
+    float4 ib(m_inverse[b[0]], m_inverse[b[1]], m_inverse[b[2]], m_inverse[b[3]]);
+    float4 va[3];
+    float4 vb[3];
+    for (uint8_t k = 0; k < 3; k++) {
+        const float *v = m_velocity[k].data();
+        va[k] = float4(v[a[0]], v[a[1]], v[a[2]], v[a[3]]);
+        vb[k] = float4(v[b[0]], v[b[1]], v[b[2]], v[b[3]]);
+    }
+    float4 mass = float4::load(&m_mass[first]);
+    float4 zero;
+
+    // Sliding first, limited by the push of the last iteration.
+    float4 limit = float4(m_friction) * float4::load(&m_impulse[0][first]);
+    for (uint8_t j = 0; j < 2; j++) {
+        float4 t[3];
+        float4 speed;
+        for (uint8_t k = 0; k < 3; k++) {
+            t[k] = float4::load(&m_tangent[j][k][first]);
+            speed = speed + (vb[k] - va[k]) * t[k];
+        }
+        float4 old = float4::load(&m_impulse[j + 1][first]);
+        float4 total = min(max(old - mass * speed, zero - limit), limit);
+        float4 change = total - old;
+        total.store(&m_impulse[j + 1][first]);
+        for (uint8_t k = 0; k < 3; k++) {
+            va[k] = va[k] - t[k] * change * ia;
+            vb[k] = vb[k] + t[k] * change * ib;
+        }
+    }
+
+    // Then the push, which never pulls.
+    float4 n[3];
+    float4 speed;
+    for (uint8_t k = 0; k < 3; k++) {
+        n[k] = float4::load(&m_normal[k][first]);
+        speed = speed + (vb[k] - va[k]) * n[k];
+    }
+    float4 old = float4::load(&m_impulse[0][first]);
+    float4 total = max(old - mass * speed, zero);
+    float4 change = total - old;
+    total.store(&m_impulse[0][first]);
+
+    // Scatter moving bodies back, which no other row of the color touches.
+    float moving_a[4];
+    float moving_b[4];
+    ia.store(moving_a);
+    ib.store(moving_b);
+    for (uint8_t k = 0; k < 3; k++) {
+        float out_a[4];
+        float out_b[4];
+        (va[k] - n[k] * change * ia).store(out_a);
+        (vb[k] + n[k] * change * ib).store(out_b);
+        for (uint8_t lane = 0; lane < 4; lane++) {
+            if (moving_a[lane] > 0) {
+                m_velocity[k][a[lane]] = out_a[lane];
+            }
+            if (moving_b[lane] > 0) {
+                m_velocity[k][b[lane]] = out_b[lane];
+            }
+        }
+    }
+}
+
+// Solve pushes in order.
+void cosmodon::physics::solver::push_rows(uint32_t first, uint32_t last)
+{
+    for (uint32_t r = first; r < last; r++) {
+        uint32_t a = m_first[r];
+        uint32_t b = m_second[r];
+        float ia = m_inverse[a];
+        float ib = m_inverse[b];
+        float speed = 0;
+        for (uint8_t k = 0; k < 3; k++) {
+            speed += (m_push[k][b] - m_push[k][a]) * m_normal[k][r];
+        }
+        float old = m_pushed[r];
+        float total = std::max(old + m_mass[r] * (m_bias[r] - speed), 0.0f);
+        float change = total - old;
+        m_pushed[r] = total;
+        for (uint8_t k = 0; k < 3; k++) {
+            if (ia > 0) {
+                m_push[k][a] -= m_normal[k][r] * change * ia;
+            }
+            if (ib > 0) {
+                m_push[k][b] += m_normal[k][r] * change * ib;
+            }
+        }
+    }
+}
+
+// Solve contacts.
+void cosmodon::physics::solver::solve(cosmodon::physics::bodies &motion, const float *inverse_mass, cosmodon::number seconds, cosmodon::pool *threads)
+{
+    m_islands.clear();
+    m_colors.clear();
+    m_leftover = std::make_pair(0, 0);
+    m_island_count = 0;
+    if (m_contacts.empty() || m_iterations == 0 || seconds <= 0) {
+        m_parent.clear();
+        m_contacts.clear();
+        m_cache.clear();
+        return;
+    }
+
+    // Velocities after accelerating through the step, for bodies with contacts.
+    uint32_t count = motion.size();
+    for (uint8_t k = 0; k < 3; k++) {
+        m_velocity[k].resize(count);
+        m_push[k].resize(count);
+    }
+    m_inverse.resize(count);
+    m_parent.assign(count, nothing);
+    m_used.resize(count);
+    m_touched.clear();
+    float *velocity[3] = {motion.get_velocities(0), motion.get_velocities(1), motion.get_velocities(2)};
+    const float *acceleration[3] = {motion.get_accelerations(0), motion.get_accelerations(1), motion.get_accelerations(2)};
+    for (const entry &e : m_contacts) {
+        for (uint32_t body : {e.first, e.second}) {
+            if (m_parent[body] == nothing) {
+                m_parent[body] = body;
+                m_used[body] = 0;
+                m_inverse[body] = inverse_mass[body];
+                for (uint8_t k = 0; k < 3; k++) {
+                    m_velocity[k][body] = velocity[k][body] + ((inverse_mass[body] > 0) ? acceleration[k][body] * seconds : 0);
+                    m_push[k][body] = 0;
+                }
+                m_touched.push_back(body);
+            }
+        }
+    }
+
+    // Join bodies touching through moving bodies into islands. Static bodies join nothing, or
+    // everything resting on the ground would be one island.
+    for (const entry &e : m_contacts) {
+        if (inverse_mass[e.first] > 0 && inverse_mass[e.second] > 0) {
+            uint32_t a = find(e.first);
+            uint32_t b = find(e.second);
+            if (a != b) {
+                m_parent[a] = b;
+            }
+        }
+    }
+
+    // Number islands, count their rows, then order them largest first so the longest jobs
+    // start early.
+    std::vector<uint32_t> island(m_contacts.size());
+    std::vector<uint32_t> label(count, nothing);
+    std::vector<uint32_t> sizes;
+    for (uint32_t i = 0; i < m_contacts.size(); i++) {
+        const entry &e = m_contacts[i];
+        uint32_t root = find((inverse_mass[e.first] > 0) ? e.first : e.second);
+        if (label[root] == nothing) {
+            label[root] = sizes.size();
+            sizes.push_back(0);
+        }
+        island[i] = label[root];
+        sizes[island[i]]++;
+    }
+    m_island.resize(count);
+    for (uint32_t body : m_touched) {
+        m_island[body] = (inverse_mass[body] > 0) ? label[find(body)] : nothing;
+    }
+    m_island_count = sizes.size();
+    std::vector<uint32_t> order(sizes.size());
+    for (uint32_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return sizes[a] > sizes[b];
+    });
+
+    // Lay rows out island by island, islands solved as one job first, then large islands.
+    // Large islands only pay off colored with threads to use.
+    bool spread = threads != nullptr && threads->size() > 1;
+    std::vector<uint32_t> start(sizes.size());
+    uint32_t rows = 0;
+    for (uint32_t i : order) {
+        if (!spread || sizes[i] < large_island) {
+            start[i] = rows;
+            m_islands.push_back(std::make_pair(rows, rows + sizes[i]));
+            rows += sizes[i];
+        }
+    }
+    uint32_t small_rows = rows;
+    for (uint32_t i : order) {
+        if (spread && sizes[i] >= large_island) {
+            start[i] = rows;
+            rows += sizes[i];
+        }
+    }
+    std::vector<uint32_t> slot(m_contacts.size());
+    for (uint32_t i = 0; i < m_contacts.size(); i++) {
+        slot[i] = start[island[i]]++;
+    }
+
+    // Color rows of large islands, giving each the lowest color neither moving body has.
+    if (small_rows < rows) {
+        std::vector<uint32_t> large;
+        for (uint32_t i = 0; i < m_contacts.size(); i++) {
+            if (slot[i] >= small_rows) {
+                large.push_back(i);
+            }
+        }
+        std::sort(large.begin(), large.end(), [&](uint32_t a, uint32_t b) {
+            return slot[a] < slot[b];
+        });
+        std::vector<uint32_t> color(large.size());
+        std::vector<uint32_t> per_color(color_limit + 1, 0);
+        for (uint32_t i = 0; i < large.size(); i++) {
+            const entry &e = m_contacts[large[i]];
+            uint64_t taken = 0;
+            taken |= (inverse_mass[e.first] > 0) ? m_used[e.first] : 0;
+            taken |= (inverse_mass[e.second] > 0) ? m_used[e.second] : 0;
+            uint32_t c = 0;
+            while (c < color_limit && (taken & (static_cast<uint64_t>(1) << c))) {
+                c++;
+            }
+            if (c < color_limit) {
+                m_used[e.first] |= static_cast<uint64_t>(1) << c;
+                m_used[e.second] |= static_cast<uint64_t>(1) << c;
+            }
+            color[i] = c;
+            per_color[c]++;
+        }
+        uint32_t next = small_rows;
+        for (uint32_t c = 0; c <= color_limit; c++) {
+            if (c == color_limit) {
+                m_leftover = std::make_pair(next, next + per_color[c]);
+            } else if (per_color[c] > 0) {
+                m_colors.push_back(std::make_pair(next, next + per_color[c]));
+            }
+            uint32_t begin = next;
+            next += per_color[c];
+            per_color[c] = begin;
+        }
+        for (uint32_t i = 0; i < large.size(); i++) {
+            slot[large[i]] = per_color[color[i]]++;
+        }
+    }
+
+    // Fill rows, starting from the impulses of the previous step.
+    m_first.resize(rows);
+    m_second.resize(rows);
+    m_mass.resize(rows);
+    m_bias.resize(rows);
+    m_pushed.assign(rows, 0);
+    m_keys.resize(rows);
+    for (uint8_t k = 0; k < 3; k++) {
+        m_normal[k].resize(rows);
+        m_tangent[0][k].resize(rows);
+        m_tangent[1][k].resize(rows);
+        m_impulse[k].resize(rows);
+    }
+    for (uint32_t i = 0; i < m_contacts.size(); i++) {
+        const entry &e = m_contacts[i];
+        uint32_t r = slot[i];
+        const cosmodon::vector &n = e.touch.normal;
+
+        // Surface directions from the axis least along the normal, so they hold still while
+        // the normal does.
+        cosmodon::vector axis = (std::fabs(n.x) < 0.57f) ? cosmodon::vector(1, 0, 0) :
+          ((std::fabs(n.y) < 0.57f) ? cosmodon::vector(0, 1, 0) : cosmodon::vector(0, 0, 1));
+        cosmodon::vector t1 = (n * axis).normal();
+        cosmodon::vector t2 = n * t1;
+
+        m_first[r] = e.first;
+        m_second[r] = e.second;
+        m_keys[r] = e.key;
+        m_mass[r] = 1 / (inverse_mass[e.first] + inverse_mass[e.second]);
+        m_bias[r] = std::min(correction / seconds * std::max<cosmodon::number>(e.touch.depth - slop, 0), push_limit);
+        const float normal[3] = {n.x, n.y, n.z};
+        const float tangent[2][3] = {{t1.x, t1.y, t1.z}, {t2.x, t2.y, t2.z}};
+        for (uint8_t k = 0; k < 3; k++) {
+            m_normal[k][r] = normal[k];
+            m_tangent[0][k][r] = tangent[0][k];
+            m_tangent[1][k][r] = tangent[1][k];
+        }
+        auto found = m_cache.find(e.key);
+        for (uint8_t k = 0; k < 3; k++) {
+            m_impulse[k][r] = (found == m_cache.end()) ? 0 : found->second.row[k];
+        }
+    }
+
+    // Islands run whole, each as one job, velocities first, then pushes.
+    run(threads, m_islands.size(), [&](uint32_t job, uint8_t) {
+        warm_start(m_islands[job].first, m_islands[job].second);
+        for (uint8_t iteration = 0; iteration < m_iterations; iteration++) {
+            solve_rows(m_islands[job].first, m_islands[job].second);
+        }
+        for (uint8_t iteration = 0; iteration < m_iterations; iteration++) {
+            push_rows(m_islands[job].first, m_islands[job].second);
+        }
+    });
+
+    // Large islands run color by color, each color split across the pool, then rows left
+    // without a color run in order.
+    auto each_color = [&](const std::function<void(uint32_t, uint32_t)> &work) {
+        for (const std::pair<uint32_t, uint32_t> &range : m_colors) {
+            uint32_t first = range.first;
+            uint32_t last = range.second;
+            run(threads, (last - first + rows_per_job - 1) / rows_per_job, [&](uint32_t job, uint8_t) {
+                uint32_t begin = first + job * rows_per_job;
+                work(begin, std::min(begin + rows_per_job, last));
+            });
+        }
+        work(m_leftover.first, m_leftover.second);
+    };
+    if (small_rows < rows) {
+        each_color([&](uint32_t begin, uint32_t end) {
+            warm_start(begin, end);
+        });
+        for (uint8_t iteration = 0; iteration < m_iterations; iteration++) {
+            each_color([&](uint32_t begin, uint32_t end) {
+                for (; begin + 4 <= end; begin += 4) {
+                    solve_rows4(begin);
+                }
+                solve_rows(begin, end);
+            });
+        }
+        for (uint8_t iteration = 0; iteration < m_iterations; iteration++) {
+            each_color([&](uint32_t begin, uint32_t end) {
+                push_rows(begin, end);
+            });
+        }
+    }
+
+    // Hand the solved velocities back, less the acceleration integration adds, and move bodies
+    // by their pushes. Impulses are kept for the next step, and pushes are not.
+    float *position[3] = {motion.get_positions(0), motion.get_positions(1), motion.get_positions(2)};
+    for (uint32_t body : m_touched) {
+        if (m_inverse[body] > 0) {
+            for (uint8_t k = 0; k < 3; k++) {
+                velocity[k][body] = m_velocity[k][body] - acceleration[k][body] * seconds;
+                position[k][body] += m_push[k][body] * seconds;
+            }
+        }
+    }
+    m_cache.clear();
+    for (uint32_t r = 0; r < rows; r++) {
+        impulse &kept = m_cache[m_keys[r]];
+        for (uint8_t k = 0; k < 3; k++) {
+            kept.row[k] = m_impulse[k][r];
+        }
+    }
+    m_contacts.clear();
+}
+
+// Retrieve island count.
+uint32_t cosmodon::physics::solver::get_island_count() const
+{
+    return m_island_count;
+}
+
+// Retrieve the island of a body.
+uint32_t cosmodon::physics::solver::get_island(uint32_t body) const
+{
+    return (body < m_parent.size() && m_parent[body] != nothing) ? m_island[body] : nothing;
+}
+
+// Retrieve color count.
+uint32_t cosmodon::physics::solver::get_color_count() const
+{
+    return m_colors.size();
+}
@@ -0,0 +1,74 @@
+#include <algorithm>
+#include <cmath>
+#include <physics/stepper.hpp>
+
+// Constructor.
+cosmodon::physics::stepper::stepper(cosmodon::physics::system &target, cosmodon::number step, uint8_t limit)
+  : m_system(&target), m_step(step), m_limit(limit > 0 ? limit : 1), m_accumulator(0), m_dropped(0)
+{
+
+}
+
+// Set the step length.
+void cosmodon::physics::stepper::set_step(cosmodon::number seconds)
+{
+    m_step = seconds;
+}
+
+// Retrieve the step length.
+cosmodon::number cosmodon::physics::stepper::get_step() const
+{
+    return m_step;
+}
+
+// Set the step limit.
+void cosmodon::physics::stepper::set_limit(uint8_t steps)
+{
+    m_limit = (steps > 0) ? steps : 1;
+}
+
+// Run steps for frame time.
+uint8_t cosmodon::physics::stepper::advance(cosmodon::number seconds)
+{
+    m_accumulator += std::max<cosmodon::number>(seconds, 0);
+    uint8_t steps = 0;
+    while (m_accumulator >= m_step && steps < m_limit) {
+        m_system->update_index();
+        m_system->pass_time(m_step);
+        m_accumulator -= m_step;
+        steps++;
+    }
+
+    // Drop whole steps still owed, keeping the fraction so motion stays smooth.
+    if (m_accumulator >= m_step) {
+        cosmodon::number owed = std::floor(m_accumulator / m_step);
+        m_dropped += static_cast<uint64_t>(owed);
+        m_accumulator -= owed * m_step;
+        m_accumulator = std::min(std::max<cosmodon::number>(m_accumulator, 0), m_step);
+    }
+    return steps;
+}
+
+// Run steps for measured frame time.
+uint8_t cosmodon::physics::stepper::advance()
+{
+    return advance(m_clock.elapsed(cosmodon::unit::nanosecond, true) / 1e9f);
+}
+
+// Retrieve the blend factor.
+cosmodon::number cosmodon::physics::stepper::get_alpha() const
+{
+    return std::min<cosmodon::number>(m_accumulator / m_step, 1);
+}
+
+// Retrieve dropped steps.
+uint64_t cosmodon::physics::stepper::get_dropped() const
+{
+    return m_dropped;
+}
+
+// Retrieve a blended matrix.
+cosmodon::matrix cosmodon::physics::stepper::get_matrix(cosmodon::physics::system::handle body) const
+{
+    return m_system->get_interpolated(body, get_alpha());
+}
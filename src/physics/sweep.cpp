@@ -0,0 +1,276 @@
+#include <limits>
+#include <utility>
+#include <physics/sweep.hpp>
+
+// Local function to build the key of a pair, independent of order.
+static uint64_t get_key(cosmodon::physics::sweep::proxy a, cosmodon::physics::sweep::proxy b)
+{
+    if (a > b) {
+        std::swap(a, b);
+    }
+    return (static_cast<uint64_t>(a) << 32) | b;
+}
+
+// Local function to read a coordinate by axis.
+static float get_axis(const cosmodon::vector &v, uint8_t axis)
+{
+    return (axis == 0) ? v.x : ((axis == 1) ? v.y : v.z);
+}
+
+// Local function to order ends, with starts before ends at equal coordinates so touching boxes overlap.
+static bool is_before(float value, uint32_t data, float other_value, uint32_t other_data)
+{
+    return value < other_value || (value == other_value && !(data & 1) && (other_data & 1));
+}
+
+// Proxy meaning no box.
+const cosmodon::physics::sweep::proxy cosmodon::physics::sweep::none;
+
+// Mark a pair as overlapping, or not.
+void cosmodon::physics::sweep::set_pair(cosmodon::physics::sweep::proxy a, cosmodon::physics::sweep::proxy b, bool overlapping)
+{
+    uint64_t key = get_key(a, b);
+    bool before = (m_pairs.count(key) > 0);
+    if (before == overlapping) {
+        return;
+    }
+
+    // Remember the state at the last flush, only the first time a pair changes.
+    m_touched.insert(std::make_pair(key, before));
+    if (overlapping) {
+        m_pairs.insert(key);
+    } else {
+        m_pairs.erase(key);
+    }
+}
+
+// Check if two boxes overlap along all axes.
+bool cosmodon::physics::sweep::overlaps(cosmodon::physics::sweep::proxy a, cosmodon::physics::sweep::proxy b) const
+{
+    const box &first = m_boxes[a];
+    const box &second = m_boxes[b];
+    for (uint8_t i = 0; i < 3; i++) {
+        if (first.high[i] < second.low[i] || second.high[i] < first.low[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Swap an end towards lower positions until sorted.
+void cosmodon::physics::sweep::sort_down(uint8_t axis, uint32_t position)
+{
+    std::vector<endpoint> &ends = m_endpoints[axis];
+    endpoint moving = ends[position];
+    proxy self = moving.data >> 1;
+    bool is_end = moving.data & 1;
+
+    while (position > 0 && is_before(moving.value, moving.data, ends[position - 1].value, ends[position - 1].data)) {
+        endpoint &other = ends[position - 1];
+        proxy neighbour = other.data >> 1;
+        bool other_is_end = other.data & 1;
+
+        // A start passing below an end may begin an overlap, and an end passing below a start ends one.
+        if (!is_end && other_is_end) {
+            if (overlaps(self, neighbour)) {
+                set_pair(self, neighbour, true);
+            }
+        } else if (is_end && !other_is_end) {
+            set_pair(self, neighbour, false);
+        }
+
+        ends[position] = other;
+        m_boxes[neighbour].ends[axis][other_is_end] = position;
+        position--;
+    }
+    ends[position] = moving;
+    m_boxes[self].ends[axis][is_end] = position;
+}
+
+// Swap an end towards higher positions until sorted.
+void cosmodon::physics::sweep::sort_up(uint8_t axis, uint32_t position)
+{
+    std::vector<endpoint> &ends = m_endpoints[axis];
+    endpoint moving = ends[position];
+    proxy self = moving.data >> 1;
+    bool is_end = moving.data & 1;
+
+    while (position + 1 < ends.size() && is_before(ends[position + 1].value, ends[position + 1].data, moving.value, moving.data)) {
+        endpoint &other = ends[position + 1];
+        proxy neighbour = other.data >> 1;
+        bool other_is_end = other.data & 1;
+
+        // An end passing above a start may begin an overlap, and a start passing above an end ends one.
+        if (is_end && !other_is_end) {
+            if (overlaps(self, neighbour)) {
+                set_pair(self, neighbour, true);
+            }
+        } else if (!is_end && other_is_end) {
+            set_pair(self, neighbour, false);
+        }
+
+        ends[position] = other;
+        m_boxes[neighbour].ends[axis][other_is_end] = position;
+        position++;
+    }
+    ends[position] = moving;
+    m_boxes[self].ends[axis][is_end] = position;
+}
+
+// Build a pair from a key.
+cosmodon::physics::sweep::pair cosmodon::physics::sweep::get_pair(uint64_t key) const
+{
+    pair result;
+    result.first = m_boxes[key >> 32].value;
+    result.second = m_boxes[key & 0xffffffff].value;
+    return result;
+}
+
+// Add a box.
+cosmodon::physics::sweep::proxy cosmodon::physics::sweep::insert(const cosmodon::bounds &area, uint32_t value)
+{
+    proxy p;
+    if (!m_free.empty()) {
+        p = m_free.back();
+        m_free.pop_back();
+    } else {
+        p = m_boxes.size();
+        m_boxes.push_back(box());
+    }
+
+    box &b = m_boxes[p];
+    b.value = value;
+    for (uint8_t i = 0; i < 3; i++) {
+        b.low[i] = get_axis(area.get_low(), i);
+        b.high[i] = get_axis(area.get_high(), i);
+    }
+
+    // Append both ends above everything, then sort them into place, start first.
+    for (uint8_t i = 0; i < 3; i++) {
+        std::vector<endpoint> &ends = m_endpoints[i];
+        endpoint start = {b.low[i], p << 1};
+        endpoint end = {b.high[i], (p << 1) | 1};
+        ends.push_back(start);
+        ends.push_back(end);
+        m_boxes[p].ends[i][0] = ends.size() - 2;
+        m_boxes[p].ends[i][1] = ends.size() - 1;
+        sort_down(i, m_boxes[p].ends[i][0]);
+        sort_down(i, m_boxes[p].ends[i][1]);
+    }
+    return p;
+}
+
+// Change the corners of a box.
+void cosmodon::physics::sweep::move(cosmodon::physics::sweep::proxy p, const cosmodon::bounds &area)
+{
+    for (uint8_t i = 0; i < 3; i++) {
+        box &b = m_boxes[p];
+        float low = get_axis(area.get_low(), i);
+        float high = get_axis(area.get_high(), i);
+        float old_low = b.low[i];
+        float old_high = b.high[i];
+        if (low == old_low && high == old_high) {
+            continue;
+        }
+
+        b.low[i] = low;
+        b.high[i] = high;
+        m_endpoints[i][b.ends[i][0]].value = low;
+        m_endpoints[i][b.ends[i][1]].value = high;
+
+        // Growing first, so the start never passes its own end.
+        if (high > old_high) {
+            sort_up(i, m_boxes[p].ends[i][1]);
+        }
+        if (low < old_low) {
+            sort_down(i, m_boxes[p].ends[i][0]);
+        }
+        if (low > old_low) {
+            sort_up(i, m_boxes[p].ends[i][0]);
+        }
+        if (high < old_high) {
+            sort_down(i, m_boxes[p].ends[i][1]);
+        }
+    }
+}
+
+// Remove a box.
+void cosmodon::physics::sweep::remove(cosmodon::physics::sweep::proxy p)
+{
+    // Sorting both ends to the top passes the end of every overlapping box, ending each pair.
+    const float top = std::numeric_limits<float>::max();
+    for (uint8_t i = 0; i < 3; i++) {
+        box &b = m_boxes[p];
+        b.high[i] = top;
+        m_endpoints[i][b.ends[i][1]].value = top;
+        sort_up(i, b.ends[i][1]);
+        b.low[i] = top;
+        m_endpoints[i][b.ends[i][0]].value = top;
+        sort_up(i, b.ends[i][0]);
+        m_endpoints[i].resize(m_endpoints[i].size() - 2);
+    }
+
+    // The value is still needed for events until the next flush.
+    m_released.push_back(p);
+}
+
+// Remove all boxes.
+void cosmodon::physics::sweep::clear()
+{
+    for (uint8_t i = 0; i < 3; i++) {
+        m_endpoints[i].clear();
+    }
+    m_boxes.clear();
+    m_free.clear();
+    m_released.clear();
+    m_pairs.clear();
+    m_touched.clear();
+    m_added.clear();
+    m_removed.clear();
+}
+
+// Collect pair changes into events.
+void cosmodon::physics::sweep::flush()
+{
+    m_added.clear();
+    m_removed.clear();
+    for (auto &touched : m_touched) {
+        bool now = (m_pairs.count(touched.first) > 0);
+        if (now && !touched.second) {
+            m_added.push_back(get_pair(touched.first));
+        } else if (!now && touched.second) {
+            m_removed.push_back(get_pair(touched.first));
+        }
+    }
+    m_touched.clear();
+
+    m_free.insert(m_free.end(), m_released.begin(), m_released.end());
+    m_released.clear();
+}
+
+// Retrieve added pairs.
+const std::vector<cosmodon::physics::sweep::pair>& cosmodon::physics::sweep::get_added() const
+{
+    return m_added;
+}
+
+// Retrieve removed pairs.
+const std::vector<cosmodon::physics::sweep::pair>& cosmodon::physics::sweep::get_removed() const
+{
+    return m_removed;
+}
+
+// Retrieve all overlapping pairs.
+void cosmodon::physics::sweep::get_pairs(std::vector<cosmodon::physics::sweep::pair> &results) const
+{
+    results.reserve(results.size() + m_pairs.size());
+    for (uint64_t key : m_pairs) {
+        results.push_back(get_pair(key));
+    }
+}
+
+// Retrieve pair count.
+uint32_t cosmodon::physics::sweep::get_pair_count() const
+{
+    return m_pairs.size();
+}
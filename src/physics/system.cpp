@@ -1,31 +1,727 @@
+#include <algorithm>
+#include <iterator>
 #include <physics/system.hpp>
 
+namespace
+{
+    // Bodies integrated per pool job, a multiple of four.
+    const uint32_t bodies_per_job = 65536;
+
+    // Pairs tested for contact per pool job.
+    const uint32_t pairs_per_job = 256;
+
+    // Impacts handled per fast object and step, after which it stops at the last.
+    const uint8_t impacts_per_step = 4;
+}
+
+// Local function to scale a vector.
+static cosmodon::vector scale(const cosmodon::vector &v, cosmodon::number s)
+{
+    return cosmodon::vector(v.x * s, v.y * s, v.z * s);
+}
+
+// Local function to find the bounds of an object, a point at its position when it has no vertices.
+static cosmodon::bounds get_box(const cosmodon::physical &object)
+{
+    cosmodon::bounds result = object.get_world_bounds();
+    if (result.is_empty()) {
+        cosmodon::vector position(object.x, object.y, object.z);
+        result = cosmodon::bounds(position, position);
+    }
+    return result;
+}
+
+// Constructor.
+cosmodon::physics::system::system()
+  : m_broadphase(cosmodon::physics::broadphase::sweep), m_known(0), m_method(cosmodon::physics::integrator::euler),
+    m_pool(nullptr), m_sleep_time(0.5f), m_next_group(0)
+{
+    cosmodon::vector origin(0, 0, 0);
+    m_point.build(&origin, 1);
+}
+
+// Handle meaning no object.
+const cosmodon::physics::system::handle cosmodon::physics::system::none;
+
+// Adds an object to the spatial index.
+cosmodon::octree::handle cosmodon::physics::system::index(cosmodon::physical &object, cosmodon::physics::system::handle body)
+{
+    cosmodon::octree::handle result = m_index.insert(get_box(object));
+    if (result >= m_indexed.size()) {
+        m_indexed.resize(result + 1, none);
+    }
+    m_indexed[result] = body;
+    object.set_clean();
+    return result;
+}
+
+// Adds an object to the incremental broadphase.
+cosmodon::physics::sweep::proxy cosmodon::physics::system::insert_proxy(uint32_t position)
+{
+    switch (m_broadphase) {
+        case cosmodon::physics::broadphase::sweep:
+            return m_sweep.insert(m_boxes[position], m_members.get_handle(position));
+        case cosmodon::physics::broadphase::tree:
+            return m_tree.insert(m_boxes[position], m_members.get_handle(position));
+        default:
+            return cosmodon::physics::sweep::none;
+    }
+}
+
+// Adds an object.
+cosmodon::physics::system::handle cosmodon::physics::system::add(cosmodon::physical *object, std::unique_ptr<cosmodon::physical> owned)
+{
+    member m;
+    m.object = object;
+    m.owned = std::move(owned);
+    m.cell = cosmodon::octree::none;
+    m.proxy = cosmodon::physics::sweep::none;
+    m.rest = 0;
+    m.group = none;
+    handle body = m_members.insert(std::move(m));
+    m_boxes.push_back(get_box(*object));
+    const cosmodon::matrix &transform = object->get_matrix();
+    for (uint8_t k = 0; k < 3; k++) {
+        m_previous[k].push_back(transform[k][3]);
+    }
+    m_members[m_members.size() - 1].cell = index(*object, body);
+    m_members[m_members.size() - 1].proxy = insert_proxy(m_members.size() - 1);
+    m_handles[object] = body;
+    return body;
+}
+
 // Adds an object to this system.
-void cosmodon::physics::system::add(cosmodon::physical &object)
+cosmodon::physics::system::handle cosmodon::physics::system::add(cosmodon::physical &object)
 {
-    if (!is_inside(object)) {
-        m_objects.push_back(&object);
+    handle existing = get_handle(object);
+    if (existing != none) {
+        return existing;
     }
+    return add(&object, nullptr);
+}
+
+// Creates an owned object.
+cosmodon::physics::system::handle cosmodon::physics::system::spawn()
+{
+    std::unique_ptr<cosmodon::physical> object(new cosmodon::physical());
+    cosmodon::physical *raw = object.get();
+    return add(raw, std::move(object));
 }
 
 // Checks if an object is inside the system.
 bool cosmodon::physics::system::is_inside(cosmodon::physical &object) const
 {
-    for (uint16_t i = 0; i < m_objects.size(); i++) {
-        if (m_objects[i] == &object) {
-            return true;
-        }
-    }
-    return false;
+    return get_handle(object) != none;
+}
+
+// Checks if a handle is inside the system.
+bool cosmodon::physics::system::is_inside(cosmodon::physics::system::handle body) const
+{
+    return m_members.contains(body);
 }
 
 // Removes an object from this system.
 void cosmodon::physics::system::remove(cosmodon::physical &object)
 {
-    for (uint16_t i = 0; i < m_objects.size(); i++) {
-        if (m_objects[i] == &object) {
-            m_objects.erase(m_objects.begin() + i);
-            return;
+    remove(get_handle(object));
+}
+
+// Removes an object by handle.
+void cosmodon::physics::system::remove(cosmodon::physics::system::handle body)
+{
+    uint32_t position = m_members.get_position(body);
+    if (position == none) {
+        return;
+    }
+    member &m = m_members[position];
+
+    // The object's group, and sleeping objects resting on or against it, lose their support,
+    // so wake them.
+    std::vector<cosmodon::octree::handle> touching;
+    m_index.query(m_boxes[position], touching);
+    for (cosmodon::octree::handle cell : touching) {
+        const member *other = m_members.get(m_indexed[cell]);
+        if (other != nullptr && other->group != none) {
+            wake_group(other->group);
+        }
+    }
+    m_index.remove(m.cell);
+    m_indexed[m.cell] = none;
+    if (m_broadphase == cosmodon::physics::broadphase::sweep) {
+        m_sweep.remove(m.proxy);
+    } else if (m_broadphase == cosmodon::physics::broadphase::tree) {
+        m_tree.remove(m.proxy);
+    }
+    m_handles.erase(m.object);
+    if (m.group != none) {
+        std::vector<handle> &group = m_groups[m.group];
+        group.erase(std::find(group.begin(), group.end(), body));
+        if (group.empty()) {
+            m_groups.erase(m.group);
+        }
+    }
+
+    // The last object moves into the gap, so its body and bounds move along.
+    uint32_t last = m_members.size() - 1;
+    m_boxes[position] = m_boxes[last];
+    m_boxes.pop_back();
+    for (uint8_t k = 0; k < 3; k++) {
+        m_previous[k][position] = m_previous[k][last];
+        m_previous[k].pop_back();
+    }
+    if (position != last) {
+        if (last < m_bodies.size()) {
+            m_bodies.move(last, position);
+        }
+        if (last >= m_known) {
+            m_known = std::min(m_known, position);
+        }
+    }
+    m_members.erase(body);
+    m_known = std::min(m_known, m_members.size());
+}
+
+// Retrieves an object by handle.
+cosmodon::physical* cosmodon::physics::system::get(cosmodon::physics::system::handle body) const
+{
+    const member *m = m_members.get(body);
+    return m ? m->object : nullptr;
+}
+
+// Retrieves the handle of an object.
+cosmodon::physics::system::handle cosmodon::physics::system::get_handle(const cosmodon::physical &object) const
+{
+    auto found = m_handles.find(&object);
+    return (found == m_handles.end()) ? none : found->second;
+}
+
+// Retrieves the amount of objects.
+uint32_t cosmodon::physics::system::size() const
+{
+    return m_members.size();
+}
+
+// Updates the spatial index and broadphase.
+void cosmodon::physics::system::update_index()
+{
+    std::vector<cosmodon::octree::handle> handles;
+    std::vector<cosmodon::bounds> boxes;
+
+    // Gather moved objects, then update them together.
+    for (uint32_t i = 0; i < m_members.size(); i++) {
+        cosmodon::physical *object = m_members[i].object;
+        if (object->is_dirty()) {
+            cosmodon::vector before = m_boxes[i].get_center();
+            m_boxes[i] = get_box(*object);
+            handles.push_back(m_members[i].cell);
+            boxes.push_back(m_boxes[i]);
+            if (m_broadphase == cosmodon::physics::broadphase::sweep) {
+                m_sweep.move(m_members[i].proxy, m_boxes[i]);
+            } else if (m_broadphase == cosmodon::physics::broadphase::tree) {
+                m_tree.move(m_members[i].proxy, m_boxes[i], m_boxes[i].get_center() - before);
+            }
+            object->set_clean();
         }
     }
+    m_index.move(handles.data(), boxes.data(), handles.size());
+
+    switch (m_broadphase) {
+        case cosmodon::physics::broadphase::sweep:
+            m_sweep.flush();
+            break;
+        case cosmodon::physics::broadphase::grid:
+            update_grid();
+            break;
+        case cosmodon::physics::broadphase::tree:
+            m_tree.flush(m_pool);
+            break;
+    }
+}
+
+// Rebuilds the grid.
+void cosmodon::physics::system::update_grid()
+{
+    m_grid.build(m_boxes.data(), m_boxes.size(), m_pool);
+
+    // Translate positions to handles, ordered so consecutive grids compare in one pass.
+    std::vector<cosmodon::physics::sweep::pair> current;
+    current.reserve(m_grid.get_pairs().size());
+    for (const cosmodon::physics::grid::pair &p : m_grid.get_pairs()) {
+        handle a = m_members.get_handle(p.first);
+        handle b = m_members.get_handle(p.second);
+        cosmodon::physics::sweep::pair result = {std::min(a, b), std::max(a, b)};
+        current.push_back(result);
+    }
+    auto before = [](const cosmodon::physics::sweep::pair &a, const cosmodon::physics::sweep::pair &b) {
+        return a.first < b.first || (a.first == b.first && a.second < b.second);
+    };
+    std::sort(current.begin(), current.end(), before);
+
+    m_added.clear();
+    m_removed.clear();
+    std::set_difference(current.begin(), current.end(), m_pairs.begin(), m_pairs.end(), std::back_inserter(m_added), before);
+    std::set_difference(m_pairs.begin(), m_pairs.end(), current.begin(), current.end(), std::back_inserter(m_removed), before);
+    m_pairs.swap(current);
+}
+
+// Retrieves added pairs.
+const std::vector<cosmodon::physics::sweep::pair>& cosmodon::physics::system::get_added_pairs() const
+{
+    switch (m_broadphase) {
+        case cosmodon::physics::broadphase::sweep:
+            return m_sweep.get_added();
+        case cosmodon::physics::broadphase::tree:
+            return m_tree.get_added();
+        default:
+            return m_added;
+    }
+}
+
+// Retrieves removed pairs.
+const std::vector<cosmodon::physics::sweep::pair>& cosmodon::physics::system::get_removed_pairs() const
+{
+    switch (m_broadphase) {
+        case cosmodon::physics::broadphase::sweep:
+            return m_sweep.get_removed();
+        case cosmodon::physics::broadphase::tree:
+            return m_tree.get_removed();
+        default:
+            return m_removed;
+    }
+}
+
+// Retrieves all overlapping pairs.
+void cosmodon::physics::system::get_pairs(std::vector<cosmodon::physics::sweep::pair> &results) const
+{
+    switch (m_broadphase) {
+        case cosmodon::physics::broadphase::sweep:
+            m_sweep.get_pairs(results);
+            break;
+        case cosmodon::physics::broadphase::grid:
+            results.insert(results.end(), m_pairs.begin(), m_pairs.end());
+            break;
+        case cosmodon::physics::broadphase::tree:
+            m_tree.get_pairs(results);
+            break;
+    }
+}
+
+// Sets the broadphase method.
+void cosmodon::physics::system::set_broadphase(cosmodon::physics::broadphase method)
+{
+    if (method == m_broadphase) {
+        return;
+    }
+    m_broadphase = method;
+
+    // Start over, so only the chosen broadphase is kept up to date.
+    m_sweep.clear();
+    m_tree.clear();
+    m_pairs.clear();
+    m_added.clear();
+    m_removed.clear();
+    for (uint32_t i = 0; i < m_members.size(); i++) {
+        m_members[i].proxy = insert_proxy(i);
+    }
+}
+
+// Sets the grid cell size.
+void cosmodon::physics::system::set_cell_size(cosmodon::number size)
+{
+    m_grid.set_cell_size(size);
+}
+
+// Retrieves the dynamic tree.
+const cosmodon::physics::tree& cosmodon::physics::system::get_tree() const
+{
+    return m_tree;
+}
+
+// Retrieves the spatial index.
+const cosmodon::octree& cosmodon::physics::system::get_index() const
+{
+    return m_index;
+}
+
+// Changes the indexed region.
+void cosmodon::physics::system::set_region(const cosmodon::bounds &region, uint8_t depth)
+{
+    m_index.reset(region, depth);
+    m_indexed.clear();
+    for (uint32_t i = 0; i < m_members.size(); i++) {
+        m_members[i].cell = index(*m_members[i].object, m_members.get_handle(i));
+    }
+}
+
+// Retrieves the object of a handle.
+cosmodon::physical* cosmodon::physics::system::get_object(cosmodon::octree::handle object) const
+{
+    return (object < m_indexed.size()) ? get(m_indexed[object]) : nullptr;
+}
+
+// Sets the integration method.
+void cosmodon::physics::system::set_integrator(cosmodon::physics::integrator method)
+{
+    m_method = method;
+}
+
+// Sets the pool.
+void cosmodon::physics::system::set_pool(cosmodon::pool *threads)
+{
+    m_pool = threads;
+}
+
+// Perform physics.
+void cosmodon::physics::system::pass_time(cosmodon::number seconds)
+{
+    uint32_t count = m_members.size();
+
+    // Wake groups of objects woken by hand, and give objects put to sleep by hand their own.
+    m_bodies.resize(count);
+    for (uint32_t i = 0; i < count; i++) {
+        const member &m = m_members[i];
+        bool sleeping = m.object->is_sleeping();
+        if (m.group != none && !sleeping) {
+            wake_group(m.group);
+        } else if (m.group == none && sleeping) {
+            fall_asleep(std::vector<uint32_t>(1, i));
+        }
+    }
+
+    // Gather object motion and where objects were drawn. Sleeping objects were left still when
+    // falling asleep.
+    m_inverse.resize(count);
+    for (uint32_t i = 0; i < count; i++) {
+        const cosmodon::matrix &transform = m_members[i].object->get_matrix();
+        for (uint8_t k = 0; k < 3; k++) {
+            m_previous[k][i] = transform[k][3];
+        }
+        if (m_members[i].group != none) {
+            m_inverse[i] = 0;
+            continue;
+        }
+        const cosmodon::physical &object = *m_members[i].object;
+        m_bodies.set(i, cosmodon::vector(object.x, object.y, object.z), object.get_velocity(),
+          object.get_acceleration(), object.is_static(), i >= m_known);
+        m_inverse[i] = object.is_static() ? 0 : 1 / object.get_mass();
+    }
+    m_known = count;
+    m_bodies.correct(0, count);
+
+    // Push touching objects apart.
+    if (m_solver.get_iterations() > 0) {
+        find_contacts();
+        m_solver.solve(m_bodies, m_inverse.data(), seconds, m_pool);
+    }
+
+    // Integrate.
+    if (m_pool == nullptr || count <= bodies_per_job) {
+        m_bodies.integrate(seconds, m_method, 0, count);
+    } else {
+        m_pool->run((count + bodies_per_job - 1) / bodies_per_job, [&](uint32_t job, uint8_t) {
+            m_bodies.integrate(seconds, m_method, job * bodies_per_job, bodies_per_job);
+        });
+    }
+
+    // Sweep fast objects before they leave their starting positions.
+    std::vector<uint32_t> fast;
+    for (uint32_t i = 0; i < count; i++) {
+        if (m_members[i].object->is_fast() && !m_bodies.is_static(i)) {
+            fast.push_back(i);
+        }
+    }
+    m_impacts.clear();
+    if (!fast.empty()) {
+        advance_fast(fast, seconds);
+    }
+
+    // Write moving objects back.
+    const float *position[3] = {m_bodies.get_positions(0), m_bodies.get_positions(1), m_bodies.get_positions(2)};
+    const float *velocity[3] = {m_bodies.get_velocities(0), m_bodies.get_velocities(1), m_bodies.get_velocities(2)};
+    for (uint32_t i = 0; i < count; i++) {
+        if (m_bodies.is_static(i)) {
+            continue;
+        }
+        m_members[i].object->set_position(position[0][i], position[1][i], position[2][i]);
+        m_members[i].object->set_velocity(cosmodon::vector(velocity[0][i], velocity[1][i], velocity[2][i]));
+    }
+
+    update_sleep(seconds);
+}
+
+// Find contacts.
+void cosmodon::physics::system::find_contacts()
+{
+    std::vector<cosmodon::physics::sweep::pair> pairs;
+    get_pairs(pairs);
+
+    // Keep pairs able to touch, building hulls here since building is not safe across threads.
+    std::vector<std::pair<uint32_t, uint32_t>> candidates;
+    for (const cosmodon::physics::sweep::pair &p : pairs) {
+        uint32_t a = m_members.get_position(p.first);
+        uint32_t b = m_members.get_position(p.second);
+        if (a == none || b == none || (m_inverse[a] == 0 && m_inverse[b] == 0)) {
+            continue;
+        }
+        if (!m_members[a].object->has_shape() || !m_members[b].object->has_shape()) {
+            continue;
+        }
+        candidates.push_back(std::make_pair(a, b));
+    }
+
+    // Test pairs across the pool, each job collecting its own contacts.
+    struct found
+    {
+        uint32_t first;
+        uint32_t second;
+        cosmodon::physics::contact touch;
+    };
+    uint32_t jobs = (candidates.size() + pairs_per_job - 1) / pairs_per_job;
+    std::vector<std::vector<found>> results(jobs);
+    auto test = [&](uint32_t job, uint8_t) {
+        uint32_t last = std::min<uint32_t>((job + 1) * pairs_per_job, candidates.size());
+        for (uint32_t i = job * pairs_per_job; i < last; i++) {
+            found f;
+            f.first = candidates[i].first;
+            f.second = candidates[i].second;
+            if (m_members[f.first].object->collide(*m_members[f.second].object, f.touch)) {
+                results[job].push_back(f);
+            }
+        }
+    };
+    if (m_pool == nullptr || jobs < 2) {
+        for (uint32_t job = 0; job < jobs; job++) {
+            test(job, 0);
+        }
+    } else {
+        m_pool->run(jobs, test);
+    }
+
+    // Objects moving into sleeping objects wake them, which stay still until the next step.
+    m_solver.clear();
+    for (const std::vector<found> &job : results) {
+        for (const found &f : job) {
+            for (uint8_t side = 0; side < 2; side++) {
+                const member &sleeper = m_members[side ? f.second : f.first];
+                uint32_t mover = side ? f.first : f.second;
+                if (sleeper.group != none && m_inverse[mover] > 0 &&
+                  m_bodies.get_velocity(mover).magnitude() >= m_members[mover].object->get_sleep_speed()) {
+                    wake_group(sleeper.group);
+                }
+            }
+            uint64_t first = m_members.get_handle(f.first);
+            uint64_t second = m_members.get_handle(f.second);
+            m_solver.add(f.first, f.second, f.touch, (first << 32) | second);
+        }
+    }
+}
+
+// Put objects to sleep.
+void cosmodon::physics::system::fall_asleep(const std::vector<uint32_t> &positions)
+{
+    std::vector<handle> &group = m_groups[m_next_group];
+    for (uint32_t i : positions) {
+        member &m = m_members[i];
+        m.object->sleep();
+        m.group = m_next_group;
+        m.rest = 0;
+        m_bodies.set(i, cosmodon::vector(m.object->x, m.object->y, m.object->z), cosmodon::vector(0, 0, 0),
+          cosmodon::vector(0, 0, 0), true, true);
+        group.push_back(m_members.get_handle(i));
+    }
+    m_next_group = (m_next_group + 1 == none) ? 0 : m_next_group + 1;
+}
+
+// Wake a group.
+void cosmodon::physics::system::wake_group(uint32_t group)
+{
+    auto found = m_groups.find(group);
+    if (found == m_groups.end()) {
+        return;
+    }
+    for (handle body : found->second) {
+        member *m = m_members.get(body);
+        if (m != nullptr) {
+            m->object->wake();
+            m->group = none;
+            m->rest = 0;
+        }
+    }
+    m_groups.erase(found);
+}
+
+// Track sleep.
+void cosmodon::physics::system::update_sleep(cosmodon::number seconds)
+{
+    if (m_sleep_time <= 0) {
+        return;
+    }
+
+    // Time each moving object has stayed slow, and the least of each island.
+    uint32_t count = m_members.size();
+    std::vector<cosmodon::number> least(m_solver.get_island_count(), m_sleep_time);
+    for (uint32_t i = 0; i < count; i++) {
+        if (m_inverse[i] == 0) {
+            continue;
+        }
+        member &m = m_members[i];
+        bool slow = m_bodies.get_velocity(i).magnitude() < m.object->get_sleep_speed();
+        m.rest = slow ? m.rest + seconds : 0;
+        uint32_t island = m_solver.get_island(i);
+        if (island < least.size()) {
+            least[island] = std::min(least[island], m.rest);
+        }
+    }
+
+    // Islands fall asleep whole, and objects without contacts alone.
+    std::vector<std::vector<uint32_t>> islands(least.size());
+    for (uint32_t i = 0; i < count; i++) {
+        if (m_inverse[i] == 0 || m_members[i].group != none) {
+            continue;
+        }
+        uint32_t island = m_solver.get_island(i);
+        if (island < least.size()) {
+            if (least[island] >= m_sleep_time) {
+                islands[island].push_back(i);
+            }
+        } else if (m_members[i].rest >= m_sleep_time) {
+            fall_asleep(std::vector<uint32_t>(1, i));
+        }
+    }
+    for (const std::vector<uint32_t> &island : islands) {
+        if (!island.empty()) {
+            fall_asleep(island);
+        }
+    }
+}
+
+// Sweep fast objects.
+void cosmodon::physics::system::advance_fast(const std::vector<uint32_t> &fast, cosmodon::number seconds)
+{
+    float *position[3] = {m_bodies.get_positions(0), m_bodies.get_positions(1), m_bodies.get_positions(2)};
+    float *velocity[3] = {m_bodies.get_velocities(0), m_bodies.get_velocities(1), m_bodies.get_velocities(2)};
+    uint32_t count = m_members.size();
+    auto get_motion = [&](uint32_t i) {
+        const cosmodon::physical &object = *m_members[i].object;
+        return cosmodon::vector(position[0][i] - object.x, position[1][i] - object.y, position[2][i] - object.z);
+    };
+
+    // Widen queries by the furthest any other object moves, to catch objects moving into a path.
+    cosmodon::number reach = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (!m_bodies.is_static(i) && !m_members[i].object->is_fast()) {
+            reach = std::max(reach, get_motion(i).magnitude());
+        }
+    }
+    cosmodon::vector widen(reach, reach, reach);
+
+    std::vector<cosmodon::octree::handle> candidates;
+    for (uint32_t i : fast) {
+        const cosmodon::physical &object = *m_members[i].object;
+        const cosmodon::physics::hull &shape = object.get_hull().is_empty() ? m_point : object.get_hull();
+        cosmodon::bounds start = get_box(object);
+        cosmodon::vector origin(object.x, object.y, object.z);
+        cosmodon::vector moved(0, 0, 0);
+        cosmodon::vector motion = get_motion(i);
+        cosmodon::vector speed = m_bodies.get_velocity(i);
+
+        // Fraction of the step passed, and the end of the last piece of motion.
+        cosmodon::number elapsed = 0;
+        cosmodon::vector end = motion;
+        for (uint8_t piece = 0; piece < impacts_per_step; piece++) {
+            end = moved + motion;
+            if (motion.magnitude() == 0) {
+                break;
+            }
+
+            // Objects whose bounds meet the bounds swept along this piece.
+            cosmodon::bounds swept(start.get_low() + moved, start.get_high() + moved);
+            swept.expand(cosmodon::bounds(start.get_low() + end, start.get_high() + end));
+            swept = cosmodon::bounds(swept.get_low() - widen, swept.get_high() + widen);
+            candidates.clear();
+            m_index.query(swept, candidates);
+
+            // Earliest impact, against others placed where they are at this point of the step.
+            cosmodon::physics::convex mover(shape, object.get_matrix());
+            mover.translate(moved);
+            cosmodon::number earliest = 2;
+            impact hit;
+            for (cosmodon::octree::handle c : candidates) {
+                handle other = m_indexed[c];
+                uint32_t j = m_members.get_position(other);
+                if (j == none || j == i || m_members[j].object->get_hull().is_empty()) {
+                    continue;
+                }
+                const cosmodon::physical &target = *m_members[j].object;
+                cosmodon::vector target_motion = m_bodies.is_static(j) ? cosmodon::vector(0, 0, 0) : get_motion(j);
+                cosmodon::physics::convex still(target.get_hull(), target.get_matrix());
+                still.translate(scale(target_motion, elapsed));
+                cosmodon::number time;
+                cosmodon::physics::contact touch;
+                if (cosmodon::physics::get_impact(mover, motion - scale(target_motion, 1 - elapsed), still, time, touch) &&
+                  time < earliest) {
+                    earliest = time;
+                    hit.first = m_members.get_handle(i);
+                    hit.second = other;
+                    hit.touch = touch;
+                }
+            }
+            if (earliest > 1) {
+                break;
+            }
+
+            // Stop at the impact, then slide on without the velocity into the other object.
+            moved = moved + scale(motion, earliest);
+            end = moved;
+            elapsed += (1 - elapsed) * earliest;
+            hit.time = seconds * elapsed;
+            m_impacts.push_back(hit);
+            cosmodon::vector normal = hit.touch.normal;
+            cosmodon::physical *target = get(hit.second);
+            cosmodon::vector relative = speed - (m_bodies.is_static(m_members.get_position(hit.second)) ?
+              cosmodon::vector(0, 0, 0) : target->get_velocity());
+            cosmodon::number closing = relative.dot(normal);
+            if (closing > 0) {
+                speed = speed - scale(normal, closing);
+            }
+            motion = scale(speed, seconds * (1 - elapsed));
+        }
+
+        cosmodon::vector result = origin + end;
+        position[0][i] = result.x;
+        position[1][i] = result.y;
+        position[2][i] = result.z;
+        velocity[0][i] = speed.x;
+        velocity[1][i] = speed.y;
+        velocity[2][i] = speed.z;
+    }
+}
+
+// Retrieves impacts.
+const std::vector<cosmodon::physics::system::impact>& cosmodon::physics::system::get_impacts() const
+{
+    return m_impacts;
+}
+
+// Retrieves an interpolated matrix.
+cosmodon::matrix cosmodon::physics::system::get_interpolated(cosmodon::physics::system::handle body, cosmodon::number alpha) const
+{
+    uint32_t position = m_members.get_position(body);
+    cosmodon::matrix result = m_members[position].object->get_matrix();
+    for (uint8_t k = 0; k < 3; k++) {
+        result[k][3] = m_previous[k][position] + (result[k][3] - m_previous[k][position]) * alpha;
+    }
+    return result;
+}
+
+// Retrieves the solver.
+cosmodon::physics::solver& cosmodon::physics::system::get_solver()
+{
+    return m_solver;
+}
+
+// Sets the sleep time.
+void cosmodon::physics::system::set_sleep_time(cosmodon::number seconds)
+{
+    m_sleep_time = seconds;
 }
@@ -0,0 +1,560 @@
+#include <algorithm>
+#include <utility>
+#include <physics/tree.hpp>
+
+namespace
+{
+    // Moved boxes worth a job of their own.
+    const uint32_t queries_per_job = 256;
+
+    // Stretch of grown boxes along recent motion.
+    const cosmodon::number prediction = 2;
+}
+
+// Local function to build the key of a pair, independent of order.
+static uint64_t get_key(cosmodon::physics::tree::proxy a, cosmodon::physics::tree::proxy b)
+{
+    if (a > b) {
+        std::swap(a, b);
+    }
+    return (static_cast<uint64_t>(a) << 32) | b;
+}
+
+// Local function to read a coordinate by axis.
+static cosmodon::number get_axis(const cosmodon::vector &v, uint8_t axis)
+{
+    return (axis == 0) ? v.x : ((axis == 1) ? v.y : v.z);
+}
+
+// Local function to convert a box to plain corners.
+static cosmodon::physics::tree::extent get_extent(const cosmodon::bounds &area, cosmodon::number margin = 0)
+{
+    cosmodon::physics::tree::extent result;
+    for (uint8_t i = 0; i < 3; i++) {
+        result.low[i] = get_axis(area.get_low(), i) - margin;
+        result.high[i] = get_axis(area.get_high(), i) + margin;
+    }
+    return result;
+}
+
+// Local function to join two boxes.
+static cosmodon::physics::tree::extent join(const cosmodon::physics::tree::extent &a, const cosmodon::physics::tree::extent &b)
+{
+    cosmodon::physics::tree::extent result;
+    for (uint8_t i = 0; i < 3; i++) {
+        result.low[i] = std::min(a.low[i], b.low[i]);
+        result.high[i] = std::max(a.high[i], b.high[i]);
+    }
+    return result;
+}
+
+// Local function to compute the surface area of a box.
+static cosmodon::number get_area(const cosmodon::physics::tree::extent &box)
+{
+    cosmodon::number x = box.high[0] - box.low[0];
+    cosmodon::number y = box.high[1] - box.low[1];
+    cosmodon::number z = box.high[2] - box.low[2];
+    return 2 * (x * y + y * z + z * x);
+}
+
+// Local function to check if two boxes overlap, touching included.
+static bool overlaps(const cosmodon::physics::tree::extent &a, const cosmodon::physics::tree::extent &b)
+{
+    return a.low[0] <= b.high[0] && b.low[0] <= a.high[0] && a.low[1] <= b.high[1] && b.low[1] <= a.high[1] &&
+      a.low[2] <= b.high[2] && b.low[2] <= a.high[2];
+}
+
+// Local function to check if a box lies within another.
+static bool encloses(const cosmodon::physics::tree::extent &outer, const cosmodon::physics::tree::extent &inner)
+{
+    return outer.low[0] <= inner.low[0] && outer.low[1] <= inner.low[1] && outer.low[2] <= inner.low[2] &&
+      inner.high[0] <= outer.high[0] && inner.high[1] <= outer.high[1] && inner.high[2] <= outer.high[2];
+}
+
+// Local function to compute the squared distance from a point to a box.
+static cosmodon::number get_distance_squared(const cosmodon::physics::tree::extent &box, const cosmodon::vector &point)
+{
+    cosmodon::number result = 0;
+    for (uint8_t i = 0; i < 3; i++) {
+        cosmodon::number p = get_axis(point, i);
+        cosmodon::number d = (p < box.low[i]) ? (box.low[i] - p) : ((p > box.high[i]) ? (p - box.high[i]) : 0);
+        result += d * d;
+    }
+    return result;
+}
+
+// Local function to check if a ray crosses a box within a distance.
+static bool crosses(const cosmodon::physics::tree::extent &box, const cosmodon::ray &r, cosmodon::number distance)
+{
+    cosmodon::number near = 0;
+    cosmodon::number far = distance;
+    for (uint8_t i = 0; i < 3; i++) {
+        cosmodon::number origin = get_axis(r.origin, i);
+        cosmodon::number direction = get_axis(r.direction, i);
+        if (direction == 0) {
+            if (origin < box.low[i] || origin > box.high[i]) {
+                return false;
+            }
+            continue;
+        }
+        cosmodon::number a = (box.low[i] - origin) / direction;
+        cosmodon::number b = (box.high[i] - origin) / direction;
+        near = std::max(near, std::min(a, b));
+        far = std::min(far, std::max(a, b));
+        if (near > far) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Proxy meaning no box.
+const cosmodon::physics::tree::proxy cosmodon::physics::tree::none;
+
+// Constructor.
+cosmodon::physics::tree::tree(cosmodon::number margin)
+  : m_free(none), m_root(none), m_count(0), m_margin(margin)
+{
+
+}
+
+// Set the margin.
+void cosmodon::physics::tree::set_margin(cosmodon::number margin)
+{
+    m_margin = margin;
+}
+
+// Take a free node.
+uint32_t cosmodon::physics::tree::allocate()
+{
+    uint32_t index = m_free;
+    if (index != none) {
+        m_free = m_nodes[index].parent;
+    } else {
+        index = m_nodes.size();
+        m_nodes.push_back(node());
+    }
+    node &n = m_nodes[index];
+    n.parent = none;
+    n.children[0] = none;
+    n.children[1] = none;
+    n.height = 0;
+    n.value = 0;
+    n.moved = false;
+    n.removed = false;
+    return index;
+}
+
+// Return a node to the free list.
+void cosmodon::physics::tree::release(uint32_t index)
+{
+    m_nodes[index].parent = m_free;
+    m_nodes[index].height = -1;
+    m_free = index;
+}
+
+// Link a leaf into the tree.
+void cosmodon::physics::tree::insert_leaf(uint32_t leaf)
+{
+    if (m_root == none) {
+        m_root = leaf;
+        m_nodes[leaf].parent = none;
+        return;
+    }
+
+    // Search for the sibling adding the least area, counting the growth of every ancestor.
+    // Subtrees are skipped once their cheapest possible cost exceeds the best found.
+    const extent box = m_nodes[leaf].box;
+    cosmodon::number area = get_area(box);
+    uint32_t index = m_root;
+    cosmodon::number best = get_area(join(m_nodes[m_root].box, box));
+    std::vector<std::pair<uint32_t, cosmodon::number>> stack(1, std::make_pair(m_root, cosmodon::number(0)));
+    while (!stack.empty()) {
+        uint32_t current = stack.back().first;
+        cosmodon::number inherited = stack.back().second;
+        stack.pop_back();
+
+        const node &n = m_nodes[current];
+        cosmodon::number joined = get_area(join(n.box, box));
+        if (joined + inherited < best) {
+            best = joined + inherited;
+            index = current;
+        }
+
+        // Below here, this node grows by the leaf whatever sibling is chosen.
+        inherited += joined - get_area(n.box);
+        if (n.children[0] != none && area + inherited < best) {
+            stack.push_back(std::make_pair(n.children[0], inherited));
+            stack.push_back(std::make_pair(n.children[1], inherited));
+        }
+    }
+
+    // Pair the leaf with the chosen sibling under a new parent.
+    uint32_t sibling = index;
+    uint32_t old_parent = m_nodes[sibling].parent;
+    uint32_t parent = allocate();
+    m_nodes[parent].parent = old_parent;
+    m_nodes[parent].box = join(m_nodes[sibling].box, box);
+    m_nodes[parent].height = m_nodes[sibling].height + 1;
+    m_nodes[parent].children[0] = sibling;
+    m_nodes[parent].children[1] = leaf;
+    m_nodes[sibling].parent = parent;
+    m_nodes[leaf].parent = parent;
+    if (old_parent == none) {
+        m_root = parent;
+    } else {
+        node &above = m_nodes[old_parent];
+        above.children[(above.children[0] == sibling) ? 0 : 1] = parent;
+    }
+
+    refit(m_nodes[leaf].parent);
+}
+
+// Unlink a leaf from the tree.
+void cosmodon::physics::tree::remove_leaf(uint32_t leaf)
+{
+    if (leaf == m_root) {
+        m_root = none;
+        return;
+    }
+
+    // The sibling takes the place of the parent.
+    uint32_t parent = m_nodes[leaf].parent;
+    uint32_t grandparent = m_nodes[parent].parent;
+    uint32_t sibling = (m_nodes[parent].children[0] == leaf) ? m_nodes[parent].children[1] : m_nodes[parent].children[0];
+    m_nodes[sibling].parent = grandparent;
+    release(parent);
+    if (grandparent == none) {
+        m_root = sibling;
+    } else {
+        node &above = m_nodes[grandparent];
+        above.children[(above.children[0] == parent) ? 0 : 1] = sibling;
+        refit(grandparent);
+    }
+    m_nodes[leaf].parent = none;
+}
+
+// Rotate a node towards balance.
+uint32_t cosmodon::physics::tree::balance(uint32_t a)
+{
+    if (m_nodes[a].children[0] == none || m_nodes[a].height < 2) {
+        return a;
+    }
+
+    // Lift the taller child into the place of this node, which takes the lower grandchild.
+    for (uint8_t side = 0; side < 2; side++) {
+        uint32_t tall = m_nodes[a].children[side];
+        uint32_t other = m_nodes[a].children[1 - side];
+        if (m_nodes[tall].height - m_nodes[other].height <= 1) {
+            continue;
+        }
+
+        uint32_t f = m_nodes[tall].children[0];
+        uint32_t g = m_nodes[tall].children[1];
+        m_nodes[tall].children[0] = a;
+        m_nodes[tall].parent = m_nodes[a].parent;
+        m_nodes[a].parent = tall;
+        if (m_nodes[tall].parent == none) {
+            m_root = tall;
+        } else {
+            node &above = m_nodes[m_nodes[tall].parent];
+            above.children[(above.children[0] == a) ? 0 : 1] = tall;
+        }
+
+        // The taller grandchild stays with the lifted node.
+        if (m_nodes[f].height < m_nodes[g].height) {
+            std::swap(f, g);
+        }
+        m_nodes[tall].children[1] = f;
+        m_nodes[a].children[side] = g;
+        m_nodes[g].parent = a;
+        m_nodes[a].box = join(m_nodes[other].box, m_nodes[g].box);
+        m_nodes[a].height = 1 + std::max(m_nodes[other].height, m_nodes[g].height);
+        m_nodes[tall].box = join(m_nodes[a].box, m_nodes[f].box);
+        m_nodes[tall].height = 1 + std::max(m_nodes[a].height, m_nodes[f].height);
+        return tall;
+    }
+    return a;
+}
+
+// Recompute boxes and heights up to the root.
+void cosmodon::physics::tree::refit(uint32_t index)
+{
+    while (index != none) {
+        index = balance(index);
+        node &n = m_nodes[index];
+        const node &first = m_nodes[n.children[0]];
+        const node &second = m_nodes[n.children[1]];
+        n.height = 1 + std::max(first.height, second.height);
+        n.box = join(first.box, second.box);
+        index = n.parent;
+    }
+}
+
+// Mark a pair as overlapping, or not.
+void cosmodon::physics::tree::set_pair(cosmodon::physics::tree::proxy a, cosmodon::physics::tree::proxy b, bool overlapping)
+{
+    uint64_t key = get_key(a, b);
+    bool before = (m_pairs.count(key) > 0);
+    if (before == overlapping) {
+        return;
+    }
+    m_touched.insert(std::make_pair(key, before));
+    if (overlapping) {
+        m_pairs.insert(key);
+    } else {
+        m_pairs.erase(key);
+    }
+}
+
+// Add a box.
+cosmodon::physics::tree::proxy cosmodon::physics::tree::insert(const cosmodon::bounds &area, uint32_t value)
+{
+    proxy p = allocate();
+    node &leaf = m_nodes[p];
+    leaf.tight = get_extent(area);
+    leaf.box = get_extent(area, m_margin);
+    leaf.value = value;
+    leaf.moved = true;
+    m_moved.push_back(p);
+    insert_leaf(p);
+    m_count++;
+    return p;
+}
+
+// Change the box of a proxy.
+bool cosmodon::physics::tree::move(cosmodon::physics::tree::proxy p, const cosmodon::bounds &area, const cosmodon::vector &displacement)
+{
+    node &leaf = m_nodes[p];
+    leaf.tight = get_extent(area);
+    if (!leaf.moved) {
+        leaf.moved = true;
+        m_moved.push_back(p);
+    }
+    if (encloses(leaf.box, leaf.tight)) {
+        return false;
+    }
+
+    // Grow the new box, and stretch it ahead along the motion.
+    extent grown = get_extent(area, m_margin);
+    for (uint8_t i = 0; i < 3; i++) {
+        cosmodon::number ahead = get_axis(displacement, i) * prediction;
+        (ahead < 0 ? grown.low[i] : grown.high[i]) += ahead;
+    }
+
+    remove_leaf(p);
+    m_nodes[p].box = grown;
+    insert_leaf(p);
+    return true;
+}
+
+// Remove a box.
+void cosmodon::physics::tree::remove(cosmodon::physics::tree::proxy p)
+{
+    remove_leaf(p);
+    m_count--;
+
+    // The node is kept until the next flush, which ends its pairs.
+    node &leaf = m_nodes[p];
+    leaf.removed = true;
+    if (!leaf.moved) {
+        leaf.moved = true;
+        m_moved.push_back(p);
+    }
+}
+
+// Remove all boxes.
+void cosmodon::physics::tree::clear()
+{
+    m_nodes.clear();
+    m_free = none;
+    m_root = none;
+    m_count = 0;
+    m_moved.clear();
+    m_pairs.clear();
+    m_touched.clear();
+    m_added.clear();
+    m_removed.clear();
+}
+
+// Retrieve the amount of boxes.
+uint32_t cosmodon::physics::tree::size() const
+{
+    return m_count;
+}
+
+// Retrieve the height.
+uint32_t cosmodon::physics::tree::get_height() const
+{
+    return (m_root == none) ? 0 : m_nodes[m_root].height;
+}
+
+// Retrieve the value of a proxy.
+uint32_t cosmodon::physics::tree::get_value(cosmodon::physics::tree::proxy p) const
+{
+    return m_nodes[p].value;
+}
+
+// Retrieve the exact box of a proxy.
+cosmodon::bounds cosmodon::physics::tree::get_bounds(cosmodon::physics::tree::proxy p) const
+{
+    const extent &box = m_nodes[p].tight;
+    return cosmodon::bounds(
+        cosmodon::vector(box.low[0], box.low[1], box.low[2]),
+        cosmodon::vector(box.high[0], box.high[1], box.high[2])
+    );
+}
+
+// Find pairs of moved boxes.
+void cosmodon::physics::tree::flush(cosmodon::pool *threads)
+{
+    // End pairs of removed boxes, and of moved boxes which separated.
+    if (!m_moved.empty()) {
+        std::vector<uint64_t> ended;
+        for (uint64_t key : m_pairs) {
+            const node &a = m_nodes[key >> 32];
+            const node &b = m_nodes[key & 0xffffffff];
+            if (a.removed || b.removed || ((a.moved || b.moved) && !overlaps(a.tight, b.tight))) {
+                ended.push_back(key);
+            }
+        }
+        for (uint64_t key : ended) {
+            set_pair(key >> 32, key & 0xffffffff, false);
+        }
+    }
+
+    // Query the tree with each moved box. Pairs of two moved boxes are found by the lower.
+    uint32_t count = m_moved.size();
+    uint32_t jobs = (count + queries_per_job - 1) / queries_per_job;
+    m_found.resize(std::max<uint32_t>(jobs, 1));
+    auto work = [&](uint32_t job) {
+        std::vector<uint64_t> &found = m_found[job];
+        std::vector<proxy> hits;
+        found.clear();
+        for (uint32_t i = job * queries_per_job; i < std::min(count, (job + 1) * queries_per_job); i++) {
+            proxy p = m_moved[i];
+            if (m_nodes[p].removed) {
+                continue;
+            }
+            hits.clear();
+            const extent &area = m_nodes[p].tight;
+            collect([&](const extent &box) {
+                return overlaps(area, box);
+            }, hits);
+            for (proxy other : hits) {
+                if (other != p && !(m_nodes[other].moved && other < p)) {
+                    found.push_back(get_key(p, other));
+                }
+            }
+        }
+    };
+    if (threads == nullptr || jobs <= 1) {
+        for (uint32_t job = 0; job < jobs; job++) {
+            work(job);
+        }
+    } else {
+        threads->run(jobs, [&](uint32_t job, uint8_t) {
+            work(job);
+        });
+    }
+    for (uint32_t job = 0; job < jobs; job++) {
+        for (uint64_t key : m_found[job]) {
+            set_pair(key >> 32, key & 0xffffffff, true);
+        }
+    }
+
+    // Collect events while removed nodes still hold their values.
+    m_added.clear();
+    m_removed.clear();
+    for (auto &touched : m_touched) {
+        bool now = (m_pairs.count(touched.first) > 0);
+        pair result = {m_nodes[touched.first >> 32].value, m_nodes[touched.first & 0xffffffff].value};
+        if (now && !touched.second) {
+            m_added.push_back(result);
+        } else if (!now && touched.second) {
+            m_removed.push_back(result);
+        }
+    }
+    m_touched.clear();
+
+    for (proxy p : m_moved) {
+        m_nodes[p].moved = false;
+        if (m_nodes[p].removed) {
+            release(p);
+        }
+    }
+    m_moved.clear();
+}
+
+// Retrieve added pairs.
+const std::vector<cosmodon::physics::tree::pair>& cosmodon::physics::tree::get_added() const
+{
+    return m_added;
+}
+
+// Retrieve removed pairs.
+const std::vector<cosmodon::physics::tree::pair>& cosmodon::physics::tree::get_removed() const
+{
+    return m_removed;
+}
+
+// Retrieve all overlapping pairs.
+void cosmodon::physics::tree::get_pairs(std::vector<cosmodon::physics::tree::pair> &results) const
+{
+    results.reserve(results.size() + m_pairs.size());
+    for (uint64_t key : m_pairs) {
+        pair result = {m_nodes[key >> 32].value, m_nodes[key & 0xffffffff].value};
+        results.push_back(result);
+    }
+}
+
+// Collect leaves accepted by a test.
+template <typename test>
+void cosmodon::physics::tree::collect(test accept, std::vector<cosmodon::physics::tree::proxy> &results) const
+{
+    if (m_root == none) {
+        return;
+    }
+    std::vector<uint32_t> stack(1, m_root);
+    while (!stack.empty()) {
+        const node &n = m_nodes[stack.back()];
+        uint32_t index = stack.back();
+        stack.pop_back();
+        if (!accept(n.box)) {
+            continue;
+        }
+        if (n.children[0] == none) {
+            if (accept(n.tight)) {
+                results.push_back(index);
+            }
+        } else {
+            stack.push_back(n.children[0]);
+            stack.push_back(n.children[1]);
+        }
+    }
+}
+
+// Query by box.
+void cosmodon::physics::tree::query(const cosmodon::bounds &area, std::vector<cosmodon::physics::tree::proxy> &results) const
+{
+    extent corners = get_extent(area);
+    collect([&](const extent &box) {
+        return overlaps(corners, box);
+    }, results);
+}
+
+// Query by sphere.
+void cosmodon::physics::tree::query(const cosmodon::vector &center, cosmodon::number radius, std::vector<cosmodon::physics::tree::proxy> &results) const
+{
+    collect([&](const extent &box) {
+        return get_distance_squared(box, center) <= radius * radius;
+    }, results);
+}
+
+// Query by ray.
+void cosmodon::physics::tree::query(const cosmodon::ray &r, cosmodon::number distance, std::vector<cosmodon::physics::tree::proxy> &results) const
+{
+    collect([&](const extent &box) {
+        return crosses(box, r, distance);
+    }, results);
+}
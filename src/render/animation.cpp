@@ -0,0 +1,424 @@
+#include <algorithm>
+#include <cmath>
+#include <common/exception.hpp>
+#include <common/simd.hpp>
+#include <render/animation.hpp>
+
+namespace
+{
+    // Offsets of component arrays, in arrays.
+    const uint8_t translation = 0;
+    const uint8_t rotation = 3;
+    const uint8_t scale = 7;
+}
+
+// Local function to blend raw pose components, four joints at a time.
+static void blend_values(const float *from, const float *to, cosmodon::number weight, float *result, uint16_t stride)
+{
+    typedef cosmodon::simd::float4 float4;
+    float4 w(weight);
+    float4 one(1);
+
+    for (uint16_t i = 0; i < stride; i += 4) {
+        float4 a[cosmodon::animation::pose::components];
+        float4 b[cosmodon::animation::pose::components];
+        for (uint8_t c = 0; c < cosmodon::animation::pose::components; c++) {
+            a[c] = float4::load(from + c * stride + i);
+            b[c] = float4::load(to + c * stride + i);
+        }
+
+        // Translation and scale, linearly.
+        for (uint8_t c = 0; c < 3; c++) {
+            (a[translation + c] + (b[translation + c] - a[translation + c]) * w).store(result + (translation + c) * stride + i);
+            (a[scale + c] + (b[scale + c] - a[scale + c]) * w).store(result + (scale + c) * stride + i);
+        }
+
+        // Rotation, flipping the target quaternion onto the shorter arc, then normalizing.
+        float4 dot = a[rotation] * b[rotation] + a[rotation + 1] * b[rotation + 1] +
+          a[rotation + 2] * b[rotation + 2] + a[rotation + 3] * b[rotation + 3];
+        float4 target = select(dot < float4(0), float4(0) - w, w);
+        float4 q[4];
+        float4 length(0);
+        for (uint8_t c = 0; c < 4; c++) {
+            q[c] = a[rotation + c] * (one - w) + b[rotation + c] * target;
+            length = length + q[c] * q[c];
+        }
+        float4 inverse = one / sqrt(length);
+        for (uint8_t c = 0; c < 4; c++) {
+            (q[c] * inverse).store(result + (rotation + c) * stride + i);
+        }
+    }
+}
+
+// Local function to multiply affine matrices of three rows of four.
+static void multiply(const float *a, const float *b, float *result)
+{
+    for (uint8_t i = 0; i < 3; i++) {
+        for (uint8_t j = 0; j < 4; j++) {
+            result[i * 4 + j] = a[i * 4] * b[j] + a[i * 4 + 1] * b[4 + j] + a[i * 4 + 2] * b[8 + j] +
+              ((j == 3) ? a[i * 4 + 3] : 0);
+        }
+    }
+}
+
+// Pose constructor.
+cosmodon::animation::pose::pose(uint16_t joints)
+{
+    resize(joints);
+}
+
+// Resize a pose.
+void cosmodon::animation::pose::resize(uint16_t joints)
+{
+    m_joints = joints;
+    m_stride = (joints + 3) & ~3;
+    m_values.assign(components * m_stride, 0);
+
+    // Identity rotation and scale, padding included.
+    std::fill(m_values.begin() + (rotation + 3) * m_stride, m_values.begin() + (rotation + 4) * m_stride, 1.0f);
+    std::fill(m_values.begin() + scale * m_stride, m_values.end(), 1.0f);
+}
+
+// Retrieve joint count.
+uint16_t cosmodon::animation::pose::size() const
+{
+    return m_joints;
+}
+
+// Retrieve stride.
+uint16_t cosmodon::animation::pose::get_stride() const
+{
+    return m_stride;
+}
+
+// Set translation.
+void cosmodon::animation::pose::set_translation(uint16_t joint, const cosmodon::vector &value)
+{
+    m_values[translation * m_stride + joint] = value.x;
+    m_values[(translation + 1) * m_stride + joint] = value.y;
+    m_values[(translation + 2) * m_stride + joint] = value.z;
+}
+
+// Set rotation.
+void cosmodon::animation::pose::set_rotation(uint16_t joint, cosmodon::number x, cosmodon::number y, cosmodon::number z, cosmodon::number w)
+{
+    m_values[rotation * m_stride + joint] = x;
+    m_values[(rotation + 1) * m_stride + joint] = y;
+    m_values[(rotation + 2) * m_stride + joint] = z;
+    m_values[(rotation + 3) * m_stride + joint] = w;
+}
+
+// Set rotation about an axis.
+void cosmodon::animation::pose::set_rotation(uint16_t joint, const cosmodon::vector &axis, cosmodon::number radians)
+{
+    cosmodon::vector a = axis.normal();
+    cosmodon::number s = std::sin(radians / 2);
+    set_rotation(joint, a.x * s, a.y * s, a.z * s, std::cos(radians / 2));
+}
+
+// Set scale.
+void cosmodon::animation::pose::set_scale(uint16_t joint, const cosmodon::vector &value)
+{
+    m_values[scale * m_stride + joint] = value.x;
+    m_values[(scale + 1) * m_stride + joint] = value.y;
+    m_values[(scale + 2) * m_stride + joint] = value.z;
+}
+
+// Retrieve translation.
+cosmodon::vector cosmodon::animation::pose::get_translation(uint16_t joint) const
+{
+    return cosmodon::vector(
+        m_values[translation * m_stride + joint],
+        m_values[(translation + 1) * m_stride + joint],
+        m_values[(translation + 2) * m_stride + joint]
+    );
+}
+
+// Retrieve scale.
+cosmodon::vector cosmodon::animation::pose::get_scale(uint16_t joint) const
+{
+    return cosmodon::vector(
+        m_values[scale * m_stride + joint],
+        m_values[(scale + 1) * m_stride + joint],
+        m_values[(scale + 2) * m_stride + joint]
+    );
+}
+
+// Retrieve raw components.
+const float* cosmodon::animation::pose::get_values() const
+{
+    return m_values.data();
+}
+
+// Set raw components.
+void cosmodon::animation::pose::set_values(const float *values)
+{
+    std::copy(values, values + m_values.size(), m_values.begin());
+}
+
+// Blend poses.
+void cosmodon::animation::pose::blend(const cosmodon::animation::pose &from, const cosmodon::animation::pose &to, cosmodon::number weight, cosmodon::animation::pose &result)
+{
+    if (from.m_joints != to.m_joints) {
+        throw cosmodon::exception::error("Cannot blend poses of different skeletons.");
+    }
+    if (result.m_joints != from.m_joints) {
+        result.resize(from.m_joints);
+    }
+    blend_values(from.m_values.data(), to.m_values.data(), weight, result.m_values.data(), from.m_stride);
+}
+
+// Clip constructor.
+cosmodon::animation::clip::clip(uint16_t joints)
+  : m_joints(joints), m_size(pose::components * ((joints + 3) & ~3))
+{
+
+}
+
+// Add a key.
+void cosmodon::animation::clip::add_key(cosmodon::number time, const cosmodon::animation::pose &key)
+{
+    if (key.size() != m_joints) {
+        throw cosmodon::exception::error("Cannot add a key for a different skeleton to a clip.");
+    }
+    if (!m_times.empty() && time <= m_times.back()) {
+        throw cosmodon::exception::error("Cannot add a clip key earlier than the last key.");
+    }
+    m_times.push_back(time);
+    m_values.insert(m_values.end(), key.get_values(), key.get_values() + m_size);
+}
+
+// Retrieve duration.
+cosmodon::number cosmodon::animation::clip::get_duration() const
+{
+    return m_times.empty() ? 0 : m_times.back();
+}
+
+// Retrieve key count.
+uint32_t cosmodon::animation::clip::get_key_count() const
+{
+    return m_times.size();
+}
+
+// Sample the clip.
+void cosmodon::animation::clip::sample(cosmodon::number time, cosmodon::animation::pose &result, bool loop) const
+{
+    if (result.size() != m_joints) {
+        result.resize(m_joints);
+    }
+    if (m_times.empty()) {
+        return;
+    }
+
+    // Wrap or clamp time.
+    cosmodon::number duration = get_duration();
+    if (loop && duration > 0) {
+        time = std::fmod(time, duration);
+        if (time < 0) {
+            time += duration;
+        }
+    }
+    if (time <= m_times.front()) {
+        result.set_values(&m_values[0]);
+        return;
+    }
+    if (time >= duration) {
+        result.set_values(&m_values[(m_times.size() - 1) * m_size]);
+        return;
+    }
+
+    // Blend the keys around the time.
+    uint32_t key = std::upper_bound(m_times.begin(), m_times.end(), time) - m_times.begin() - 1;
+    cosmodon::number weight = (time - m_times[key]) / (m_times[key + 1] - m_times[key]);
+    thread_local std::vector<float> values;
+    values.resize(m_size);
+    blend_values(&m_values[key * m_size], &m_values[(key + 1) * m_size], weight, values.data(), m_size / pose::components);
+    result.set_values(values.data());
+}
+
+// Add a joint.
+uint16_t cosmodon::animation::skeleton::add(uint16_t parent, const cosmodon::matrix &inverse_bind)
+{
+    if (parent != none && parent >= m_parents.size()) {
+        throw cosmodon::exception::error("Cannot add a joint before its parent.");
+    }
+    m_parents.push_back(parent);
+    for (uint8_t i = 0; i < 3; i++) {
+        m_inverse_binds.insert(m_inverse_binds.end(), inverse_bind[i], inverse_bind[i] + 4);
+    }
+    return m_parents.size() - 1;
+}
+
+// Retrieve joint count.
+uint16_t cosmodon::animation::skeleton::size() const
+{
+    return m_parents.size();
+}
+
+// Retrieve a parent.
+uint16_t cosmodon::animation::skeleton::get_parent(uint16_t joint) const
+{
+    return m_parents[joint];
+}
+
+// Compute skinning matrices.
+void cosmodon::animation::skeleton::compute(const cosmodon::animation::pose &current, std::vector<float> &palette) const
+{
+    thread_local std::vector<float> world;
+    uint16_t joints = size();
+    uint16_t stride = current.get_stride();
+    const float *v = current.get_values();
+
+    if (current.size() != joints) {
+        throw cosmodon::exception::error("Cannot compute skinning matrices from a pose of another skeleton.");
+    }
+    world.resize(joints * 12);
+    palette.resize(joints * 16);
+
+    for (uint16_t j = 0; j < joints; j++) {
+        float local[12];
+        float skinning[12];
+        float tx = v[translation * stride + j], ty = v[(translation + 1) * stride + j], tz = v[(translation + 2) * stride + j];
+        float x = v[rotation * stride + j], y = v[(rotation + 1) * stride + j];
+        float z = v[(rotation + 2) * stride + j], w = v[(rotation + 3) * stride + j];
+        float sx = v[scale * stride + j], sy = v[(scale + 1) * stride + j], sz = v[(scale + 2) * stride + j];
+
+        // Translation, rotation, then scale, relative to the parent.
+        local[0] = (1 - 2 * (y * y + z * z)) * sx;
+        local[1] = 2 * (x * y - z * w) * sy;
+        local[2] = 2 * (x * z + y * w) * sz;
+        local[3] = tx;
+        local[4] = 2 * (x * y + z * w) * sx;
+        local[5] = (1 - 2 * (x * x + z * z)) * sy;
+        local[6] = 2 * (y * z - x * w) * sz;
+        local[7] = ty;
+        local[8] = 2 * (x * z - y * w) * sx;
+        local[9] = 2 * (y * z + x * w) * sy;
+        local[10] = (1 - 2 * (x * x + y * y)) * sz;
+        local[11] = tz;
+
+        float *global = &world[j * 12];
+        if (m_parents[j] == none) {
+            std::copy(local, local + 12, global);
+        } else {
+            multiply(&world[m_parents[j] * 12], local, global);
+        }
+        multiply(global, &m_inverse_binds[j * 12], skinning);
+
+        // Store columns, so vertices transform as a sum of scaled columns.
+        float *target = &palette[j * 16];
+        for (uint8_t c = 0; c < 4; c++) {
+            target[c * 4] = skinning[c];
+            target[c * 4 + 1] = skinning[4 + c];
+            target[c * 4 + 2] = skinning[8 + c];
+            target[c * 4 + 3] = 0;
+        }
+    }
+}
+
+// Resize a skin.
+void cosmodon::animation::skin::resize(uint32_t vertices)
+{
+    uint32_t previous = size();
+    m_joints.resize(vertices * 4, 0);
+    m_weights.resize(vertices * 4, 0);
+
+    // New vertices follow the first joint.
+    for (uint32_t i = previous; i < vertices; i++) {
+        m_weights[i * 4] = 1;
+    }
+}
+
+// Retrieve vertex count.
+uint32_t cosmodon::animation::skin::size() const
+{
+    return m_weights.size() / 4;
+}
+
+// Set vertex influences.
+void cosmodon::animation::skin::set(uint32_t vertex, const uint16_t *joints, const cosmodon::number *weights)
+{
+    std::pair<cosmodon::number, uint16_t> influences[4];
+    cosmodon::number total = 0;
+
+    for (uint8_t i = 0; i < 4; i++) {
+        influences[i] = std::make_pair(std::max<cosmodon::number>(weights[i], 0), joints[i]);
+        total += influences[i].first;
+    }
+    std::sort(influences, influences + 4, [](const std::pair<cosmodon::number, uint16_t> &a, const std::pair<cosmodon::number, uint16_t> &b) {
+        return a.first > b.first;
+    });
+    if (total <= 0) {
+        influences[0].first = total = 1;
+    }
+    for (uint8_t i = 0; i < 4; i++) {
+        m_weights[vertex * 4 + i] = influences[i].first / total;
+        m_joints[vertex * 4 + i] = (influences[i].first > 0) ? influences[i].second : influences[0].second;
+    }
+}
+
+// Skin vertices.
+void cosmodon::animation::skin::apply(const cosmodon::vertices &source, const std::vector<float> &palette, cosmodon::vertices &target) const
+{
+    typedef cosmodon::simd::float4 float4;
+    uint32_t count = std::min(source.size(), size());
+
+    // Take colors and indices from the source once.
+    if (target.size() != source.size()) {
+        target.resize(source.size());
+        for (uint32_t i = 0; i < source.size(); i++) {
+            target[i] = source[i];
+        }
+        target.resize_indices(source.get_index_count());
+        std::copy(source.get_indices(), source.get_indices() + source.get_index_count(), target.get_indices());
+        target.set_primitive(source.get_primitive());
+    }
+
+    const float *p = palette.data();
+    for (uint32_t i = 0; i < count; i++) {
+        const uint16_t *joints = &m_joints[i * 4];
+        const float *weights = &m_weights[i * 4];
+
+        // Blend matrices by weight, stopping at the first unused influence.
+        float4 w(weights[0]);
+        const float *m = p + joints[0] * 16;
+        float4 c0 = float4::load(m) * w;
+        float4 c1 = float4::load(m + 4) * w;
+        float4 c2 = float4::load(m + 8) * w;
+        float4 c3 = float4::load(m + 12) * w;
+        for (uint8_t k = 1; k < 4 && weights[k] > 0; k++) {
+            w = float4(weights[k]);
+            m = p + joints[k] * 16;
+            c0 = c0 + float4::load(m) * w;
+            c1 = c1 + float4::load(m + 4) * w;
+            c2 = c2 + float4::load(m + 8) * w;
+            c3 = c3 + float4::load(m + 12) * w;
+        }
+
+        const cosmodon::vertex &v = source[i];
+        float result[4];
+        (c0 * float4(v.x) + c1 * float4(v.y) + c2 * float4(v.z) + c3).store(result);
+        cosmodon::vertex &out = target[i];
+        out.x = result[0];
+        out.y = result[1];
+        out.z = result[2];
+    }
+}
+
+// Skin characters.
+void cosmodon::animation::update(cosmodon::animation::character *characters, uint32_t count, cosmodon::pool *threads)
+{
+    auto skin = [&](uint32_t i, uint8_t) {
+        cosmodon::animation::character &c = characters[i];
+        c.rig->compute(c.current, c.palette);
+        c.weights->apply(*c.source, c.palette, *c.target);
+    };
+
+    if (threads == nullptr) {
+        for (uint32_t i = 0; i < count; i++) {
+            skin(i, 0);
+        }
+        return;
+    }
+    threads->run(count, skin);
+}
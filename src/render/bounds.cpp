@@ -0,0 +1,93 @@
+#include <limits>
+#include <render/bounds.hpp>
+
+// Constructor.
+cosmodon::bounds::bounds()
+  : m_low(std::numeric_limits<number>::max(), std::numeric_limits<number>::max(), std::numeric_limits<number>::max()),
+    m_high(-std::numeric_limits<number>::max(), -std::numeric_limits<number>::max(), -std::numeric_limits<number>::max())
+{
+
+}
+
+// Constructor.
+cosmodon::bounds::bounds(const cosmodon::vector &low, const cosmodon::vector &high)
+  : m_low(low), m_high(high)
+{
+
+}
+
+// Check emptiness.
+bool cosmodon::bounds::is_empty() const
+{
+    return m_low.x > m_high.x || m_low.y > m_high.y || m_low.z > m_high.z;
+}
+
+// Retrieve low corner.
+const cosmodon::vector& cosmodon::bounds::get_low() const
+{
+    return m_low;
+}
+
+// Retrieve high corner.
+const cosmodon::vector& cosmodon::bounds::get_high() const
+{
+    return m_high;
+}
+
+// Retrieve center.
+cosmodon::vector cosmodon::bounds::get_center() const
+{
+    return cosmodon::vector((m_low.x + m_high.x) / 2, (m_low.y + m_high.y) / 2, (m_low.z + m_high.z) / 2);
+}
+
+// Retrieve size.
+cosmodon::vector cosmodon::bounds::get_size() const
+{
+    return m_high - m_low;
+}
+
+// Retrieve surface area.
+cosmodon::number cosmodon::bounds::get_area() const
+{
+    if (is_empty()) {
+        return 0;
+    }
+    cosmodon::vector size = get_size();
+    return 2 * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+// Grow to contain a point.
+void cosmodon::bounds::expand(const cosmodon::vector &point)
+{
+    m_low.x = (point.x < m_low.x) ? point.x : m_low.x;
+    m_low.y = (point.y < m_low.y) ? point.y : m_low.y;
+    m_low.z = (point.z < m_low.z) ? point.z : m_low.z;
+    m_high.x = (point.x > m_high.x) ? point.x : m_high.x;
+    m_high.y = (point.y > m_high.y) ? point.y : m_high.y;
+    m_high.z = (point.z > m_high.z) ? point.z : m_high.z;
+}
+
+// Grow to contain a box.
+void cosmodon::bounds::expand(const cosmodon::bounds &other)
+{
+    if (!other.is_empty()) {
+        expand(other.m_low);
+        expand(other.m_high);
+    }
+}
+
+// Check if a point is inside.
+bool cosmodon::bounds::contains(const cosmodon::vector &point) const
+{
+    return point.x >= m_low.x && point.x <= m_high.x &&
+      point.y >= m_low.y && point.y <= m_high.y &&
+      point.z >= m_low.z && point.z <= m_high.z;
+}
+
+// Check overlap.
+bool cosmodon::bounds::overlaps(const cosmodon::bounds &other) const
+{
+    return m_low.x <= other.m_high.x && m_high.x >= other.m_low.x &&
+      m_low.y <= other.m_high.y && m_high.y >= other.m_low.y &&
+      m_low.z <= other.m_high.z && m_high.z >= other.m_low.z;
+}
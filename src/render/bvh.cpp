@@ -0,0 +1,392 @@
+#include <algorithm>
+#include <limits>
+#include <common/exception.hpp>
+#include <render/bvh.hpp>
+
+namespace
+{
+    // Bins per axis when searching for splits.
+    const uint8_t bins = 16;
+
+    // Depth after which nodes are split at the median, to bound tree depth.
+    const uint32_t median_depth = 48;
+
+    // Largest item count a leaf may hold when a split does not pay off.
+    const uint32_t leaf_limit = 16;
+
+    // State shared by the nodes of one build.
+    struct builder
+    {
+        const std::vector<cosmodon::bounds> *boxes;
+        std::vector<cosmodon::vector> centers;
+        std::vector<uint32_t> *items;
+        std::vector<cosmodon::bvh::node> *nodes;
+        uint8_t leaf;
+    };
+}
+
+// Local function to read a coordinate by axis.
+static cosmodon::number get_axis(const cosmodon::vector &v, uint8_t axis)
+{
+    return (axis == 0) ? v.x : ((axis == 1) ? v.y : v.z);
+}
+
+// Local function to split a node's items, recursively.
+static void split(builder &state, uint32_t index, uint32_t first, uint32_t count, uint32_t depth)
+{
+    std::vector<uint32_t> &items = *state.items;
+    cosmodon::bounds box, centers;
+
+    for (uint32_t i = first; i < first + count; i++) {
+        box.expand((*state.boxes)[items[i]]);
+        centers.expand(state.centers[items[i]]);
+    }
+    cosmodon::bvh::node &n = (*state.nodes)[index];
+    n.low[0] = box.get_low().x;
+    n.low[1] = box.get_low().y;
+    n.low[2] = box.get_low().z;
+    n.high[0] = box.get_high().x;
+    n.high[1] = box.get_high().y;
+    n.high[2] = box.get_high().z;
+    n.first = first;
+    n.count = count;
+    n.axis = 0;
+    n.padding = 0;
+    if (count <= state.leaf) {
+        return;
+    }
+
+    // Find the cheapest binned split along any axis by surface area.
+    cosmodon::number best = std::numeric_limits<cosmodon::number>::max();
+    uint8_t best_axis = 0;
+    uint8_t best_bin = 0;
+    cosmodon::vector extent = centers.get_size();
+    for (uint8_t axis = 0; axis < 3 && depth < median_depth; axis++) {
+        cosmodon::number low = get_axis(centers.get_low(), axis);
+        cosmodon::number size = get_axis(extent, axis);
+        if (size <= 0) {
+            continue;
+        }
+        cosmodon::number scale = bins / size;
+        cosmodon::bounds bin_boxes[bins];
+        uint32_t bin_counts[bins] = {0};
+        for (uint32_t i = first; i < first + count; i++) {
+            uint32_t bin = std::min<uint32_t>(bins - 1, (get_axis(state.centers[items[i]], axis) - low) * scale);
+            bin_counts[bin]++;
+            bin_boxes[bin].expand((*state.boxes)[items[i]]);
+        }
+
+        // Sweep from the right to collect costs of right sides, then from the left.
+        cosmodon::number right_costs[bins];
+        cosmodon::bounds right;
+        uint32_t right_count = 0;
+        for (uint8_t i = bins - 1; i > 0; i--) {
+            right.expand(bin_boxes[i]);
+            right_count += bin_counts[i];
+            right_costs[i] = right.get_area() * right_count;
+        }
+        cosmodon::bounds left;
+        uint32_t left_count = 0;
+        for (uint8_t i = 1; i < bins; i++) {
+            left.expand(bin_boxes[i - 1]);
+            left_count += bin_counts[i - 1];
+            if (left_count == 0 || left_count == count) {
+                continue;
+            }
+            cosmodon::number cost = left.get_area() * left_count + right_costs[i];
+            if (cost < best) {
+                best = cost;
+                best_axis = axis;
+                best_bin = i;
+            }
+        }
+    }
+
+    // Keep a leaf when splitting costs more than testing every item.
+    cosmodon::number area = box.get_area();
+    if (count <= leaf_limit && best >= area * (count - 1)) {
+        return;
+    }
+
+    // Partition by the chosen bin, or at the median when no useful split was found.
+    uint32_t middle = 0;
+    if (best < std::numeric_limits<cosmodon::number>::max()) {
+        cosmodon::number low = get_axis(centers.get_low(), best_axis);
+        cosmodon::number scale = bins / get_axis(extent, best_axis);
+        middle = std::partition(items.begin() + first, items.begin() + first + count, [&](uint32_t item) {
+            return std::min<uint32_t>(bins - 1, (get_axis(state.centers[item], best_axis) - low) * scale) < best_bin;
+        }) - items.begin();
+    }
+    if (middle <= first || middle >= first + count) {
+        best_axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : ((extent.y >= extent.z) ? 1 : 2);
+        middle = first + count / 2;
+        std::nth_element(items.begin() + first, items.begin() + middle, items.begin() + first + count, [&](uint32_t a, uint32_t b) {
+            return get_axis(state.centers[a], best_axis) < get_axis(state.centers[b], best_axis);
+        });
+    }
+
+    // Children are appended as a pair, which may move the parent.
+    uint32_t child = state.nodes->size();
+    state.nodes->resize(child + 2);
+    cosmodon::bvh::node &parent = (*state.nodes)[index];
+    parent.first = child;
+    parent.count = 0;
+    parent.axis = best_axis;
+    split(state, child, first, middle - first, depth + 1);
+    split(state, child + 1, middle, first + count - middle, depth + 1);
+}
+
+// Index meaning no triangle or object.
+const uint32_t cosmodon::bvh::none;
+
+// Hit constructor.
+cosmodon::bvh::hit::hit()
+  : distance(std::numeric_limits<cosmodon::number>::infinity()),
+    triangle(cosmodon::bvh::none),
+    object(cosmodon::bvh::none),
+    u(0),
+    v(0)
+{
+
+}
+
+// Check for a hit.
+bool cosmodon::bvh::hit::is_hit() const
+{
+    return triangle != cosmodon::bvh::none;
+}
+
+// Load rays into a packet.
+void cosmodon::bvh::packet::load(const cosmodon::ray *rays, uint8_t count, const cosmodon::bvh::hit *hits)
+{
+    float values[6][4];
+    float distances[4];
+
+    // Unused lanes repeat the first ray, and stay inactive.
+    for (uint8_t i = 0; i < 4; i++) {
+        const cosmodon::ray &r = rays[(i < count) ? i : 0];
+        values[0][i] = r.origin.x;
+        values[1][i] = r.origin.y;
+        values[2][i] = r.origin.z;
+        values[3][i] = r.direction.x;
+        values[4][i] = r.direction.y;
+        values[5][i] = r.direction.z;
+        distances[i] = (i < count) ? hits[i].distance : 0;
+    }
+    for (uint8_t i = 0; i < 3; i++) {
+        origin[i] = cosmodon::simd::float4::load(values[i]);
+        direction[i] = cosmodon::simd::float4::load(values[i + 3]);
+    }
+    distance = cosmodon::simd::float4::load(distances);
+    active = cosmodon::simd::float4(0, 1, 2, 3) < cosmodon::simd::float4(count);
+    prepare();
+}
+
+// Compute inverse directions.
+void cosmodon::bvh::packet::prepare()
+{
+    for (uint8_t i = 0; i < 3; i++) {
+        inverse[i] = cosmodon::simd::float4(1) / direction[i];
+    }
+}
+
+// Test rays against a box.
+cosmodon::simd::float4 cosmodon::bvh::packet::intersects(const cosmodon::bvh::node &box) const
+{
+    cosmodon::simd::float4 near(0);
+    cosmodon::simd::float4 far = distance;
+
+    // Narrow the range between entering and leaving each slab.
+    for (uint8_t i = 0; i < 3; i++) {
+        cosmodon::simd::float4 a = (cosmodon::simd::float4(box.low[i]) - origin[i]) * inverse[i];
+        cosmodon::simd::float4 b = (cosmodon::simd::float4(box.high[i]) - origin[i]) * inverse[i];
+        near = max(near, min(a, b));
+        far = min(far, max(a, b));
+    }
+    return (near <= far) & active;
+}
+
+// Build over boxes.
+void cosmodon::bvh::build(const std::vector<cosmodon::bounds> &boxes, uint8_t leaf)
+{
+    builder state;
+
+    clear();
+    if (boxes.empty()) {
+        return;
+    }
+    state.boxes = &boxes;
+    state.items = &m_items;
+    state.nodes = &m_nodes;
+    state.leaf = std::max<uint8_t>(leaf, 1);
+    state.centers.resize(boxes.size());
+    m_items.resize(boxes.size());
+    for (uint32_t i = 0; i < boxes.size(); i++) {
+        state.centers[i] = boxes[i].get_center();
+        m_items[i] = i;
+    }
+    m_nodes.reserve(2 * boxes.size());
+    m_nodes.resize(1);
+    split(state, 0, 0, boxes.size(), 0);
+}
+
+// Build over triangles.
+void cosmodon::bvh::build(const cosmodon::vertices &mesh, uint8_t leaf)
+{
+    std::vector<cosmodon::bounds> boxes;
+
+    if (mesh.get_primitive() != cosmodon::primitive::triangle) {
+        throw cosmodon::exception::error("Cannot build a triangle hierarchy over vertices of another primitive.");
+    }
+
+    // Box every triangle.
+    uint32_t triangles = mesh.get_drawn_count() / 3;
+    boxes.resize(triangles);
+    for (uint32_t i = 0; i < triangles; i++) {
+        for (uint8_t j = 0; j < 3; j++) {
+            boxes[i].expand(mesh.get_drawn(i * 3 + j));
+        }
+    }
+    build(boxes, leaf);
+
+    // Store triangles in leaf order, ready for intersection.
+    m_triangles.resize(m_items.size() * 9);
+    for (uint32_t i = 0; i < m_items.size(); i++) {
+        const cosmodon::vertex &a = mesh.get_drawn(m_items[i] * 3);
+        const cosmodon::vertex &b = mesh.get_drawn(m_items[i] * 3 + 1);
+        const cosmodon::vertex &c = mesh.get_drawn(m_items[i] * 3 + 2);
+        float *t = &m_triangles[i * 9];
+        t[0] = a.x;
+        t[1] = a.y;
+        t[2] = a.z;
+        t[3] = b.x - a.x;
+        t[4] = b.y - a.y;
+        t[5] = b.z - a.z;
+        t[6] = c.x - a.x;
+        t[7] = c.y - a.y;
+        t[8] = c.z - a.z;
+    }
+}
+
+// Build over boxes.
+void cosmodon::bvh::build(const std::vector<cosmodon::bounds> &boxes)
+{
+    build(boxes, 1);
+}
+
+// Remove all nodes.
+void cosmodon::bvh::clear()
+{
+    m_nodes.clear();
+    m_items.clear();
+    m_triangles.clear();
+}
+
+// Retrieve total bounds.
+cosmodon::bounds cosmodon::bvh::get_bounds() const
+{
+    if (m_nodes.empty()) {
+        return cosmodon::bounds();
+    }
+    const node &root = m_nodes[0];
+    return cosmodon::bounds(
+        cosmodon::vector(root.low[0], root.low[1], root.low[2]),
+        cosmodon::vector(root.high[0], root.high[1], root.high[2])
+    );
+}
+
+// Retrieve node count.
+uint32_t cosmodon::bvh::get_node_count() const
+{
+    return m_nodes.size();
+}
+
+// Retrieve a node.
+const cosmodon::bvh::node& cosmodon::bvh::get_node(uint32_t index) const
+{
+    return m_nodes[index];
+}
+
+// Retrieve an item.
+uint32_t cosmodon::bvh::get_item(uint32_t position) const
+{
+    return m_items[position];
+}
+
+// Test rays against triangles of a leaf.
+void cosmodon::bvh::intersect(cosmodon::bvh::packet &rays, const cosmodon::bvh::node &leaf, cosmodon::bvh::hit *hits, uint32_t object) const
+{
+    typedef cosmodon::simd::float4 float4;
+    const float4 *o = rays.origin;
+    const float4 *d = rays.direction;
+
+    for (uint32_t i = leaf.first; i < leaf.first + leaf.count; i++) {
+        const float *t = &m_triangles[i * 9];
+        float4 e1x(t[3]), e1y(t[4]), e1z(t[5]);
+        float4 e2x(t[6]), e2y(t[7]), e2z(t[8]);
+
+        // Moller-Trumbore, for four rays against one triangle.
+        float4 px = d[1] * e2z - d[2] * e2y;
+        float4 py = d[2] * e2x - d[0] * e2z;
+        float4 pz = d[0] * e2y - d[1] * e2x;
+        float4 inverse = float4(1) / (e1x * px + e1y * py + e1z * pz);
+        float4 sx = o[0] - float4(t[0]);
+        float4 sy = o[1] - float4(t[1]);
+        float4 sz = o[2] - float4(t[2]);
+        float4 u = (sx * px + sy * py + sz * pz) * inverse;
+        float4 qx = sy * e1z - sz * e1y;
+        float4 qy = sz * e1x - sx * e1z;
+        float4 qz = sx * e1y - sy * e1x;
+        float4 v = (d[0] * qx + d[1] * qy + d[2] * qz) * inverse;
+        float4 distance = (e2x * qx + e2y * qy + e2z * qz) * inverse;
+
+        float4 mask = rays.active & (u >= float4(0)) & (v >= float4(0)) & ((u + v) <= float4(1)) &
+          (distance > float4(0)) & (distance < rays.distance);
+        uint8_t bits = mask.bits();
+        if (bits == 0) {
+            continue;
+        }
+
+        // Record nearer hits.
+        float distances[4], us[4], vs[4];
+        distance.store(distances);
+        u.store(us);
+        v.store(vs);
+        for (uint8_t j = 0; j < 4; j++) {
+            if (bits & (1 << j)) {
+                hits[j].distance = distances[j];
+                hits[j].triangle = m_items[i];
+                hits[j].object = object;
+                hits[j].u = us[j];
+                hits[j].v = vs[j];
+            }
+        }
+        rays.distance = select(mask, distance, rays.distance);
+    }
+}
+
+// Intersect a ray.
+bool cosmodon::bvh::intersect(const cosmodon::ray &r, cosmodon::bvh::hit &result) const
+{
+    cosmodon::number distance = result.distance;
+    intersect(&r, &result, 1);
+    return result.distance < distance;
+}
+
+// Intersect many rays.
+void cosmodon::bvh::intersect(const cosmodon::ray *rays, cosmodon::bvh::hit *results, uint32_t count) const
+{
+    cosmodon::bvh::packet p;
+    for (uint32_t i = 0; i < count; i += 4) {
+        p.load(rays + i, std::min<uint32_t>(count - i, 4), results + i);
+        intersect(p, results + i);
+    }
+}
+
+// Intersect a packet.
+void cosmodon::bvh::intersect(cosmodon::bvh::packet &rays, cosmodon::bvh::hit *hits, uint32_t object) const
+{
+    traverse(rays, [&](const node &leaf) {
+        intersect(rays, leaf, hits, object);
+    });
+}
@@ -0,0 +1,523 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <queue>
+#include <common/exception.hpp>
+#include <common/math.hpp>
+#include <common/random.hpp>
+#include <render/catalog.hpp>
+
+// Catalog file identification.
+static const uint32_t catalog_magic = 0x434F5343;
+static const uint32_t catalog_version = 1;
+
+// Alignment of node data within catalog files, so nodes can be fetched and dropped by page.
+static const uint64_t catalog_alignment = 4096;
+
+// Header at the start of catalog files.
+struct catalog_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t nodes;
+    uint32_t reserved;
+    uint64_t table;
+};
+
+// Local function to pad a file to the next aligned offset.
+static void pad(std::ofstream &file)
+{
+    static const char zeros[catalog_alignment] = {};
+    uint64_t position = file.tellp();
+    uint64_t padding = (catalog_alignment - position % catalog_alignment) % catalog_alignment;
+    file.write(zeros, padding);
+}
+
+// Local function to build a node and its subtree, returning its index.
+static uint32_t build_node(std::vector<cosmodon::catalog::builder::entry> &entries, size_t first, size_t last,
+  cosmodon::vector origin, cosmodon::number extent, uint8_t depth, uint32_t capacity,
+  cosmodon::random::stream &s, std::vector<cosmodon::catalog::node> &nodes, std::ofstream &file)
+{
+    uint32_t index = nodes.size();
+    size_t count = last - first;
+    size_t sample = (count <= capacity || depth == 0) ? count : capacity;
+    cosmodon::points chunk(origin, extent);
+    cosmodon::number half = extent / 2;
+    size_t bounds[9];
+
+    // Move a random subsample to the front of the range.
+    for (size_t i = 0; i < sample && sample < count; i++) {
+        uint64_t pick = ((static_cast<uint64_t>(s.integer()) << 32) | s.integer()) % (count - i);
+        std::swap(entries[first + i], entries[first + i + pick]);
+    }
+
+    // Write the subsample, quantized within this node's cell.
+    chunk.reserve(sample);
+    for (size_t i = first; i < first + sample; i++) {
+        chunk.add(cosmodon::vector(entries[i].x, entries[i].y, entries[i].z), entries[i].c);
+    }
+    nodes.push_back(cosmodon::catalog::node());
+    nodes[index].origin[0] = origin.x;
+    nodes[index].origin[1] = origin.y;
+    nodes[index].origin[2] = origin.z;
+    nodes[index].extent = extent;
+    nodes[index].offset = file.tellp();
+    nodes[index].count = sample;
+    file.write(reinterpret_cast<const char*>(chunk.data()), sample * sizeof(cosmodon::points::point));
+    pad(file);
+
+    if (sample == count) {
+        return index;
+    }
+
+    // Sort the remaining points into octants.
+    bounds[0] = first + sample;
+    bounds[8] = last;
+    bounds[4] = std::partition(entries.begin() + bounds[0], entries.begin() + bounds[8],
+      [&](const cosmodon::catalog::builder::entry &e) { return e.x < origin.x + half; }) - entries.begin();
+    for (uint8_t i = 0; i < 8; i += 4) {
+        bounds[i + 2] = std::partition(entries.begin() + bounds[i], entries.begin() + bounds[i + 4],
+          [&](const cosmodon::catalog::builder::entry &e) { return e.y < origin.y + half; }) - entries.begin();
+    }
+    for (uint8_t i = 0; i < 8; i += 2) {
+        bounds[i + 1] = std::partition(entries.begin() + bounds[i], entries.begin() + bounds[i + 2],
+          [&](const cosmodon::catalog::builder::entry &e) { return e.z < origin.z + half; }) - entries.begin();
+    }
+
+    // Build children.
+    for (uint8_t i = 0; i < 8; i++) {
+        if (bounds[i] == bounds[i + 1]) {
+            continue;
+        }
+        cosmodon::vector corner(
+            origin.x + ((i & 4) ? half : 0),
+            origin.y + ((i & 2) ? half : 0),
+            origin.z + ((i & 1) ? half : 0)
+        );
+        uint32_t child = build_node(entries, bounds[i], bounds[i + 1], corner, half, depth - 1,
+          capacity, s, nodes, file);
+        nodes[index].children[i] = child;
+    }
+    return index;
+}
+
+// Builder constructor.
+cosmodon::catalog::builder::builder(uint32_t capacity, uint8_t depth)
+  : m_capacity((capacity > 0) ? capacity : 1), m_depth(depth)
+{
+
+}
+
+// Make room for points.
+void cosmodon::catalog::builder::reserve(uint64_t count)
+{
+    m_entries.reserve(count);
+}
+
+// Add a point.
+void cosmodon::catalog::builder::add(const cosmodon::vector &position, const cosmodon::color &c)
+{
+    if (m_entries.empty()) {
+        m_low = m_high = position;
+    }
+    m_low = cosmodon::vector(std::min(m_low.x, position.x), std::min(m_low.y, position.y), std::min(m_low.z, position.z));
+    m_high = cosmodon::vector(std::max(m_high.x, position.x), std::max(m_high.y, position.y), std::max(m_high.z, position.z));
+    m_entries.push_back({position.x, position.y, position.z, c});
+}
+
+// Add the points of a chunk.
+void cosmodon::catalog::builder::add(const cosmodon::points &source)
+{
+    for (uint32_t i = 0; i < source.size(); i++) {
+        add(source.get_position(i), source.get_color(i));
+    }
+}
+
+// Retrieve the amount of points.
+uint64_t cosmodon::catalog::builder::size() const
+{
+    return m_entries.size();
+}
+
+// Write a catalog file.
+void cosmodon::catalog::builder::write(const std::string &path)
+{
+    std::vector<node> nodes;
+    cosmodon::random::stream s;
+    catalog_header header = {catalog_magic, catalog_version, 0, 0, 0};
+    cosmodon::number extent = std::max(std::max(m_high.x - m_low.x, m_high.y - m_low.y), m_high.z - m_low.z);
+    extent = (extent > 0) ? extent * 1.0001f : 1;
+
+    // Write nodes after a header page, then the node table, then the finished header.
+    std::ofstream file(path + ".tmp", std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    pad(file);
+    build_node(m_entries, 0, m_entries.size(), m_low, extent, m_depth, m_capacity, s, nodes, file);
+    std::vector<entry>().swap(m_entries);
+
+    header.nodes = nodes.size();
+    header.table = file.tellp();
+    file.write(reinterpret_cast<const char*>(nodes.data()), nodes.size() * sizeof(node));
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.close();
+    if (!file || std::rename((path + ".tmp").c_str(), path.c_str()) != 0) {
+        std::remove((path + ".tmp").c_str());
+        throw cosmodon::exception::error("Could not write catalog: " + path);
+    }
+}
+
+// Build a catalog file.
+void cosmodon::catalog::build(const std::string &path, const std::vector<cosmodon::points> &source,
+  uint32_t capacity, uint8_t depth)
+{
+    cosmodon::catalog::builder result(capacity, depth);
+    size_t total = 0;
+
+    for (uint32_t i = 0; i < source.size(); i++) {
+        total += source[i].size();
+    }
+    result.reserve(total);
+    for (uint32_t i = 0; i < source.size(); i++) {
+        result.add(source[i]);
+    }
+    result.write(path);
+}
+
+// Constructor.
+cosmodon::catalog::catalog()
+  : m_update(0),
+    m_resident(0),
+    m_expanded(0),
+    m_memory_budget(256 << 20),
+    m_point_budget(2000000),
+    m_error(2),
+    m_stop(false)
+{
+
+}
+
+// Destructor.
+cosmodon::catalog::~catalog()
+{
+    close();
+}
+
+// Open a catalog file.
+void cosmodon::catalog::open(const std::string &path)
+{
+    catalog_header header;
+    uint32_t count;
+
+    close();
+    m_file.open(path);
+
+    // Validate header and node table.
+    if (m_file.size() < sizeof(header)) {
+        m_file.close();
+        throw cosmodon::exception::error("Invalid catalog: " + path);
+    }
+    std::memcpy(&header, m_file.data(), sizeof(header));
+    count = header.nodes;
+    if (header.magic != catalog_magic || header.version != catalog_version || count == 0 ||
+      header.table > m_file.size() || (m_file.size() - header.table) / sizeof(node) < count) {
+        m_file.close();
+        throw cosmodon::exception::error("Invalid catalog: " + path);
+    }
+    m_nodes.resize(count);
+    std::memcpy(m_nodes.data(), m_file.data() + header.table, count * sizeof(node));
+
+    // Validate nodes. Children always follow their parent, so the tree cannot loop.
+    for (uint32_t i = 0; i < count; i++) {
+        bool valid = m_nodes[i].offset <= m_file.size() &&
+          (m_file.size() - m_nodes[i].offset) / sizeof(points::point) >= m_nodes[i].count;
+        for (uint8_t j = 0; j < 8; j++) {
+            uint32_t child = m_nodes[i].children[j];
+            valid = valid && (child == 0 || (child > i && child < count));
+        }
+        if (!valid) {
+            m_nodes.clear();
+            m_file.close();
+            throw cosmodon::exception::error("Invalid catalog: " + path);
+        }
+    }
+
+    // Prepare residency, and start the loader. Nodes are fetched explicitly, so readahead
+    // around faults would only waste memory.
+    m_states.reset(new std::atomic<uint8_t>[count]);
+    for (uint32_t i = 0; i < count; i++) {
+        m_states[i].store(static_cast<uint8_t>(state::absent));
+    }
+    m_used.assign(count, 0);
+    m_update = 0;
+    m_resident = 0;
+    m_expanded = 0;
+    m_file.advise(0, m_file.size(), mapped_file::advice::random);
+    m_stop = false;
+    m_loader = std::thread(&catalog::load, this);
+}
+
+// Close the catalog.
+void cosmodon::catalog::close()
+{
+    if (m_loader.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+            m_queue.clear();
+        }
+        m_wake.notify_all();
+        m_loader.join();
+    }
+    m_vertices.clear();
+    m_selected.clear();
+    m_nodes.clear();
+    m_states.reset();
+    m_used.clear();
+    m_resident = 0;
+    m_expanded = 0;
+    m_file.close();
+}
+
+// Set memory budget.
+void cosmodon::catalog::set_memory_budget(uint64_t bytes)
+{
+    m_memory_budget = bytes;
+}
+
+// Set point budget.
+void cosmodon::catalog::set_point_budget(uint32_t count)
+{
+    m_point_budget = count;
+}
+
+// Set tolerated error.
+void cosmodon::catalog::set_error(cosmodon::number pixels)
+{
+    m_error = pixels;
+}
+
+// Retrieve node data size.
+uint64_t cosmodon::catalog::get_bytes(uint32_t index) const
+{
+    return static_cast<uint64_t>(m_nodes[index].count) * sizeof(points::point);
+}
+
+// Retrieve expanded vertex size.
+uint64_t cosmodon::catalog::get_expanded_bytes(uint32_t index) const
+{
+    return static_cast<uint64_t>(m_nodes[index].count) * sizeof(vertex);
+}
+
+// Loader thread loop.
+void cosmodon::catalog::load()
+{
+    while (true) {
+        uint32_t index;
+        uint8_t expected = static_cast<uint8_t>(state::queued);
+
+        // Wait for a request.
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+            if (m_stop) {
+                return;
+            }
+            index = m_queue.front();
+            m_queue.pop_front();
+        }
+
+        // Claim the node, unless its request was withdrawn meanwhile.
+        if (!m_states[index].compare_exchange_strong(expected, static_cast<uint8_t>(state::loading))) {
+            continue;
+        }
+
+        // Fault in node data, so drawing never waits on the disk.
+        m_file.advise(m_nodes[index].offset, get_bytes(index), mapped_file::advice::need);
+        m_file.touch(m_nodes[index].offset, get_bytes(index));
+        m_resident += get_bytes(index);
+        m_states[index].store(static_cast<uint8_t>(state::resident));
+    }
+}
+
+// Release unused nodes.
+void cosmodon::catalog::evict()
+{
+    std::vector<uint32_t> unused;
+
+    if (m_resident + m_expanded <= m_memory_budget) {
+        return;
+    }
+
+    // Find resident nodes not selected now, least recently used first.
+    for (uint32_t i = 0; i < m_nodes.size(); i++) {
+        if (m_states[i].load() == static_cast<uint8_t>(state::resident) && m_used[i] != m_update) {
+            unused.push_back(i);
+        }
+    }
+    std::sort(unused.begin(), unused.end(), [this](uint32_t a, uint32_t b) {
+        return m_used[a] < m_used[b];
+    });
+
+    // Give pages back. The mapping stays valid, and refaults from disk if needed again.
+    for (uint32_t i = 0; i < unused.size() && m_resident + m_expanded > m_memory_budget; i++) {
+        m_states[unused[i]].store(static_cast<uint8_t>(state::absent));
+        m_file.advise(m_nodes[unused[i]].offset, get_bytes(unused[i]), mapped_file::advice::discard);
+        m_resident -= get_bytes(unused[i]);
+    }
+}
+
+// Select, request, and release nodes.
+void cosmodon::catalog::update(const cosmodon::camera &view, cosmodon::number height)
+{
+    typedef std::pair<cosmodon::number, uint32_t> candidate;
+    std::priority_queue<candidate> candidates;
+    std::vector<uint32_t> requests;
+    uint64_t selected_points = 0;
+    uint64_t selected_bytes = 0;
+
+    if (m_nodes.empty()) {
+        return;
+    }
+    m_update++;
+    m_selected.clear();
+
+    // Withdraw earlier requests not yet started. This selection requests again what it needs.
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (uint32_t index : m_queue) {
+            uint8_t expected = static_cast<uint8_t>(state::queued);
+            m_states[index].compare_exchange_strong(expected, static_cast<uint8_t>(state::absent));
+        }
+        m_queue.clear();
+    }
+
+    // Project the spacing between a node's points onto the screen, or return a negative value
+    // when the node is outside the camera's view.
+    const cosmodon::frustum &frustum = view.get_frustum();
+    cosmodon::vector eye = view.get_position();
+    cosmodon::number scale = height / (2 * cosmodon::math::tangent(cosmodon::math::radians(view.get_fov()) / 2));
+    auto project = [&](uint32_t index) -> cosmodon::number {
+        const node &n = m_nodes[index];
+        cosmodon::number half = n.extent / 2;
+        cosmodon::number radius = half * 1.7320508f;
+        cosmodon::vector center(n.origin[0] + half, n.origin[1] + half, n.origin[2] + half);
+        if (!frustum.intersects(center, radius)) {
+            return -1;
+        }
+        cosmodon::number distance = std::max((center - eye).magnitude() - radius, n.extent * 1e-3f);
+        cosmodon::number spacing = n.extent / std::cbrt(static_cast<cosmodon::number>(std::max(n.count, 1u)));
+        return spacing * scale / distance;
+    };
+
+    // Select nodes with the most visible error first, until a budget runs out. Selected nodes
+    // cost their point data, and the vertices they expand into.
+    cosmodon::number root = project(0);
+    if (root >= 0) {
+        candidates.push(candidate(root, 0));
+    }
+    while (!candidates.empty()) {
+        candidate top = candidates.top();
+        uint32_t index = top.second;
+        uint8_t expected = static_cast<uint8_t>(state::absent);
+        candidates.pop();
+
+        uint64_t bytes = get_bytes(index) + get_expanded_bytes(index);
+        if (selected_points + m_nodes[index].count > m_point_budget || selected_bytes + bytes > m_memory_budget) {
+            continue;
+        }
+        selected_points += m_nodes[index].count;
+        selected_bytes += bytes;
+        m_used[index] = m_update;
+
+        // Draw resident nodes, and request absent ones.
+        if (m_states[index].load() == static_cast<uint8_t>(state::resident)) {
+            m_selected.push_back(index);
+        } else if (m_states[index].compare_exchange_strong(expected, static_cast<uint8_t>(state::queued))) {
+            requests.push_back(index);
+        }
+
+        // Refine nodes that are still too coarse.
+        if (top.first <= m_error) {
+            continue;
+        }
+        for (uint8_t i = 0; i < 8; i++) {
+            uint32_t child = m_nodes[index].children[i];
+            if (child == 0) {
+                continue;
+            }
+            cosmodon::number error = project(child);
+            if (error >= 0) {
+                candidates.push(candidate(error, child));
+            }
+        }
+    }
+
+    // Hand requests to the loader.
+    if (!requests.empty()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queue.insert(m_queue.end(), requests.begin(), requests.end());
+        }
+        m_wake.notify_one();
+    }
+
+    // Selected, resident nodes are drawn from expanded vertices, which share the budget.
+    m_expanded = 0;
+    for (uint32_t index : m_selected) {
+        m_expanded += get_expanded_bytes(index);
+    }
+    evict();
+
+    // Keep vertices for selected nodes only.
+    for (auto i = m_vertices.begin(); i != m_vertices.end();) {
+        if (m_used[i->first] != m_update) {
+            i = m_vertices.erase(i);
+        } else {
+            i++;
+        }
+    }
+    for (uint32_t index : m_selected) {
+        if (m_vertices.find(index) == m_vertices.end()) {
+            const node &n = m_nodes[index];
+            points::expand(m_vertices[index],
+              reinterpret_cast<const points::point*>(m_file.data() + n.offset), n.count,
+              cosmodon::vector(n.origin[0], n.origin[1], n.origin[2]), n.extent);
+        }
+    }
+}
+
+// Retrieve node count.
+uint32_t cosmodon::catalog::get_node_count() const
+{
+    return m_nodes.size();
+}
+
+// Retrieve a node.
+const cosmodon::catalog::node& cosmodon::catalog::get_node(uint32_t index) const
+{
+    return m_nodes[index];
+}
+
+// Retrieve selected nodes.
+const std::vector<uint32_t>& cosmodon::catalog::get_selected() const
+{
+    return m_selected;
+}
+
+// Retrieve fetched data size.
+uint64_t cosmodon::catalog::get_resident() const
+{
+    return m_resident + m_expanded;
+}
+
+// Draw selected nodes.
+void cosmodon::catalog::draw(cosmodon::canvas *target) const
+{
+    for (uint32_t index : m_selected) {
+        const vertices &v = m_vertices.find(index)->second;
+        target->draw(&v, v.get_matrix());
+    }
+}
@@ -17,7 +17,7 @@ cosmodon::color::color(const cosmodon::color &copy)
 cosmodon::color cosmodon::black(0, 0, 0);
 
 // White color.
-cosmodon::color cosmodon::white(0, 0, 0);
+cosmodon::color cosmodon::white(255, 255, 255);
 
 // Red color.
 cosmodon::color cosmodon::red(255, 0, 0);
@@ -0,0 +1,89 @@
+#include <cmath>
+#include <render/frustum.hpp>
+
+// Constructor.
+cosmodon::frustum::frustum()
+{
+    for (uint8_t i = 0; i < 6; i++) {
+        m_planes[i][0] = m_planes[i][1] = m_planes[i][2] = 0;
+        m_planes[i][3] = 1;
+    }
+}
+
+// Constructor.
+cosmodon::frustum::frustum(const cosmodon::matrix &view_projection)
+{
+    set(view_projection);
+}
+
+// Extract planes.
+void cosmodon::frustum::set(const cosmodon::matrix &view_projection)
+{
+    const cosmodon::matrix &m = view_projection;
+
+    // Each plane is the last row plus or minus another row, since points inside satisfy
+    // -w <= x, y, z <= w in clip space.
+    for (uint8_t i = 0; i < 6; i++) {
+        uint8_t row = i / 2;
+        cosmodon::number sign = (i % 2 == 0) ? 1 : -1;
+        for (uint8_t j = 0; j < 4; j++) {
+            m_planes[i][j] = m[3][j] + sign * m[row][j];
+        }
+
+        // Normalize, so plane equations give distances.
+        cosmodon::number length = std::sqrt(m_planes[i][0] * m_planes[i][0] +
+          m_planes[i][1] * m_planes[i][1] + m_planes[i][2] * m_planes[i][2]);
+        if (length > 0) {
+            for (uint8_t j = 0; j < 4; j++) {
+                m_planes[i][j] /= length;
+            }
+        }
+    }
+}
+
+// Retrieve a plane.
+const cosmodon::number* cosmodon::frustum::get_plane(cosmodon::frustum::side plane) const
+{
+    return m_planes[static_cast<uint8_t>(plane)];
+}
+
+// Retrieve the distance to a plane.
+cosmodon::number cosmodon::frustum::get_distance(cosmodon::frustum::side plane, const cosmodon::vector &point) const
+{
+    const cosmodon::number *p = m_planes[static_cast<uint8_t>(plane)];
+    return p[0] * point.x + p[1] * point.y + p[2] * point.z + p[3];
+}
+
+// Check if a point is inside.
+bool cosmodon::frustum::contains(const cosmodon::vector &point) const
+{
+    return intersects(point, 0);
+}
+
+// Check if a sphere is inside.
+bool cosmodon::frustum::intersects(const cosmodon::vector &center, cosmodon::number radius) const
+{
+    for (uint8_t i = 0; i < 6; i++) {
+        if (get_distance(static_cast<side>(i), center) < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Check if a box is inside.
+bool cosmodon::frustum::intersects(const cosmodon::bounds &box) const
+{
+    const cosmodon::vector &low = box.get_low();
+    const cosmodon::vector &high = box.get_high();
+
+    // Test the corner furthest along each plane's normal.
+    for (uint8_t i = 0; i < 6; i++) {
+        const cosmodon::number *p = m_planes[i];
+        cosmodon::vector corner(p[0] >= 0 ? high.x : low.x, p[1] >= 0 ? high.y : low.y, p[2] >= 0 ? high.z : low.z);
+        if (p[0] * corner.x + p[1] * corner.y + p[2] * corner.z + p[3] < 0) {
+            return false;
+        }
+    }
+    return true;
+}
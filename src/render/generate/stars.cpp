@@ -0,0 +1,228 @@
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <common/math.hpp>
+#include <common/random.hpp>
+#include <render/generate.hpp>
+
+// Approximate colors and relative abundance of stellar classes O, B, A, F, G, K, and M.
+static const cosmodon::color star_colors[] = {
+    cosmodon::color(155, 176, 255), cosmodon::color(170, 191, 255), cosmodon::color(202, 215, 255),
+    cosmodon::color(248, 247, 255), cosmodon::color(255, 244, 234), cosmodon::color(255, 210, 161),
+    cosmodon::color(255, 204, 111),
+};
+static const cosmodon::number star_abundance[] = {0.001f, 0.01f, 0.04f, 0.08f, 0.12f, 0.20f, 0.549f};
+
+// Local function to pick a star color. Bias shifts abundance towards hot, young stars.
+static cosmodon::color star_color(cosmodon::random::stream &s, cosmodon::number bias)
+{
+    cosmodon::number pick = s.real() * (1.0f + 6.0f * bias);
+    cosmodon::color result = star_colors[6];
+
+    for (uint8_t i = 0; i < 7; i++) {
+        pick -= star_abundance[i] + ((i < 3) ? 2.0f * bias : 0);
+        if (pick < 0) {
+            result = star_colors[i];
+            break;
+        }
+    }
+
+    // Few stars are bright.
+    cosmodon::number brightness = s.real();
+    result.a = 48 + static_cast<uint8_t>(207 * brightness * brightness * brightness * brightness);
+    return result;
+}
+
+// Local function to pick a direction uniformly on the unit sphere.
+static cosmodon::vector direction(cosmodon::random::stream &s)
+{
+    cosmodon::number z = s.real(-1, 1);
+    cosmodon::number angle = s.real(0, 2 * cosmodon::math::pi);
+    cosmodon::number planar = std::sqrt(1 - z * z);
+    return cosmodon::vector(planar * std::cos(angle), planar * std::sin(angle), z);
+}
+
+// Local function to scatter sampled points into chunks, in parallel and deterministically.
+template <typename sampler>
+static void scatter(std::vector<cosmodon::points> &chunks, uint64_t count, cosmodon::number radius,
+  uint8_t cells, uint32_t seed, cosmodon::pool *workers, const sampler &sample)
+{
+    uint32_t cell_count = static_cast<uint32_t>(cells) * cells * cells;
+    cosmodon::number extent = 2 * radius / cells;
+
+    // Block layout depends only on the count, never on the thread count. Each worker takes a
+    // run of blocks in order, so points land in block order, and counts are kept per worker.
+    uint32_t blocks = (count / 65536 < 1) ? 1 : ((count / 65536 > 1024) ? 1024 : count / 65536);
+    uint32_t jobs = std::min<uint32_t>(blocks, (workers != nullptr) ? workers->size() : 1);
+    std::vector<uint32_t> offsets(static_cast<size_t>(jobs) * cell_count, 0);
+
+    if (cell_count == 0) {
+        chunks.clear();
+        return;
+    }
+
+    // Prepare chunks.
+    chunks.assign(cell_count, cosmodon::points());
+    for (uint32_t i = 0; i < cell_count; i++) {
+        cosmodon::vector origin(
+            -radius + extent * (i % cells),
+            -radius + extent * ((i / cells) % cells),
+            -radius + extent * (i / cells / cells)
+        );
+        chunks[i].set_cell(origin, extent);
+    }
+
+    // Locate the chunk of a position, clamping strays into the grid.
+    auto locate = [&](const cosmodon::vector &p) {
+        cosmodon::number axes[3] = {p.x, p.y, p.z};
+        uint32_t index = 0;
+        for (int8_t i = 2; i >= 0; i--) {
+            cosmodon::number cell = std::floor((axes[i] + radius) / extent);
+            cell = (cell < 0) ? 0 : ((cell > cells - 1) ? cells - 1 : cell);
+            index = index * cells + static_cast<uint32_t>(cell);
+        }
+        return index;
+    };
+
+    // Run a function over all blocks, each worker's in order, with each block's own stream and
+    // range.
+    auto each_block = [&](const std::function<void(uint32_t, cosmodon::random::stream&, uint64_t)> &function) {
+        auto job = [&](uint32_t worker, uint8_t thread) {
+            uint32_t end = static_cast<uint64_t>(blocks) * (worker + 1) / jobs;
+            for (uint32_t block = static_cast<uint64_t>(blocks) * worker / jobs; block < end; block++) {
+                cosmodon::random::stream s(seed, block);
+                uint64_t first = count * block / blocks;
+                uint64_t last = count * (block + 1) / blocks;
+                function(worker, s, last - first);
+            }
+        };
+        if (workers != nullptr) {
+            workers->run(jobs, job);
+        } else {
+            for (uint32_t i = 0; i < jobs; i++) {
+                job(i, 0);
+            }
+        }
+    };
+
+    // Count points per worker and chunk.
+    each_block([&](uint32_t worker, cosmodon::random::stream &s, uint64_t amount) {
+        uint32_t *counts = &offsets[static_cast<size_t>(worker) * cell_count];
+        cosmodon::vector position;
+        cosmodon::color c;
+        for (uint64_t i = 0; i < amount; i++) {
+            sample(s, position, c);
+            counts[locate(position)]++;
+        }
+    });
+
+    // Turn counts into each worker's starting offset within each chunk, and size chunks.
+    for (uint32_t cell = 0; cell < cell_count; cell++) {
+        uint32_t total = 0;
+        for (uint32_t worker = 0; worker < jobs; worker++) {
+            uint32_t &offset = offsets[static_cast<size_t>(worker) * cell_count + cell];
+            uint32_t amount = offset;
+            offset = total;
+            total += amount;
+        }
+        chunks[cell].resize(total);
+    }
+
+    // Regenerate the same points, and place them without locking.
+    each_block([&](uint32_t worker, cosmodon::random::stream &s, uint64_t amount) {
+        uint32_t *next = &offsets[static_cast<size_t>(worker) * cell_count];
+        cosmodon::vector position;
+        cosmodon::color c;
+        for (uint64_t i = 0; i < amount; i++) {
+            sample(s, position, c);
+            uint32_t cell = locate(position);
+            chunks[cell][next[cell]++] = chunks[cell].quantize(position, c);
+        }
+    });
+}
+
+// Generates a field of stars.
+void cosmodon::generate::starfield(std::vector<cosmodon::points> &chunks, uint64_t count,
+  cosmodon::number radius, uint8_t cells, uint32_t seed, cosmodon::pool *workers)
+{
+    scatter(chunks, count, radius, cells, seed, workers,
+      [&](cosmodon::random::stream &s, cosmodon::vector &position, cosmodon::color &c) {
+        cosmodon::number distance = radius * std::cbrt(s.real());
+        cosmodon::vector d = direction(s);
+        position = cosmodon::vector(d.x * distance, d.y * distance, d.z * distance);
+        c = star_color(s, 0);
+    });
+}
+
+// Generates a spiral galaxy.
+void cosmodon::generate::galaxy(std::vector<cosmodon::points> &chunks, uint64_t count,
+  cosmodon::number radius, uint8_t arms, uint8_t cells, uint32_t seed, cosmodon::pool *workers)
+{
+    const cosmodon::number twist = 2.5f;
+    arms = (arms == 0) ? 1 : arms;
+
+    scatter(chunks, count, radius, cells, seed, workers,
+      [&](cosmodon::random::stream &s, cosmodon::vector &position, cosmodon::color &c) {
+        // Central bulge of old, warm stars.
+        if (s.real() < 0.15f) {
+            cosmodon::number distance = std::fabs(s.normal()) * radius * 0.12f;
+            cosmodon::vector d = direction(s);
+            position = cosmodon::vector(d.x * distance, d.y * distance, d.z * distance * 0.6f);
+            c = star_color(s, 0);
+            return;
+        }
+
+        // Disk stars, exponentially thinning outwards, wound onto logarithmic arms.
+        cosmodon::number distance = radius * 0.3f * -std::log(1.0f - s.real());
+        distance = (distance > radius) ? radius * s.real() : distance;
+        cosmodon::number share = distance / radius;
+        cosmodon::number angle = 2 * cosmodon::math::pi * s.integer(0, arms - 1) / arms
+          + twist * std::log(1 + share * 20) + s.normal() * 0.3f * (1 - share * 0.5f);
+        distance += s.normal() * radius * 0.02f;
+
+        position.x = distance * std::cos(angle);
+        position.y = distance * std::sin(angle);
+        position.z = s.normal() * radius * (0.01f + 0.04f * std::exp(-share * 8));
+
+        // Young, blue stars light up the arms.
+        c = star_color(s, share);
+    });
+}
+
+// Generates a nebula.
+void cosmodon::generate::nebula(std::vector<cosmodon::points> &chunks, uint64_t count,
+  cosmodon::number radius, uint8_t cells, uint32_t seed, cosmodon::pool *workers)
+{
+    const uint8_t clouds = 8;
+    const cosmodon::color gases[] = {
+        cosmodon::color(255, 80, 90), cosmodon::color(80, 220, 200), cosmodon::color(100, 140, 255),
+    };
+    cosmodon::vector centers[clouds];
+    cosmodon::number sizes[clouds];
+    cosmodon::color tints[clouds];
+
+    // Lay out clouds with a stream of their own, separate from all point blocks.
+    cosmodon::random::stream layout(seed, 0xFFFFFFFFFFFFULL);
+    for (uint8_t i = 0; i < clouds; i++) {
+        cosmodon::vector d = direction(layout);
+        cosmodon::number distance = radius * 0.6f * layout.real();
+        centers[i] = cosmodon::vector(d.x * distance, d.y * distance, d.z * distance);
+        sizes[i] = radius * layout.real(0.1f, 0.35f);
+        tints[i] = gases[layout.integer(0, 2)];
+    }
+
+    scatter(chunks, count, radius, cells, seed, workers,
+      [&](cosmodon::random::stream &s, cosmodon::vector &position, cosmodon::color &c) {
+        uint8_t i = s.integer(0, clouds - 1);
+        position.x = centers[i].x + s.normal() * sizes[i];
+        position.y = centers[i].y + s.normal() * sizes[i];
+        position.z = centers[i].z + s.normal() * sizes[i];
+
+        // Faint, slightly varied gas.
+        c = tints[i];
+        c.r = (c.r * (200 + s.integer(0, 55))) / 255;
+        c.g = (c.g * (200 + s.integer(0, 55))) / 255;
+        c.b = (c.b * (200 + s.integer(0, 55))) / 255;
+        c.a = 16 + s.integer(0, 48);
+    });
+}
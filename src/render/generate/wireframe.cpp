@@ -0,0 +1,58 @@
+#include <algorithm>
+#include <utility>
+#include <render/generate.hpp>
+
+// Local function to order vertices by position.
+static bool position_less(const cosmodon::vertex &a, const cosmodon::vertex &b)
+{
+    if (a.x != b.x) {
+        return a.x < b.x;
+    }
+    if (a.y != b.y) {
+        return a.y < b.y;
+    }
+    return a.z < b.z;
+}
+
+// Generates the edges of a triangle list.
+void cosmodon::generate::wireframe(cosmodon::vertices &v, const cosmodon::vertices &triangles)
+{
+    typedef std::pair<uint32_t, uint32_t> edge;
+    std::vector<edge> edges;
+    uint32_t count = triangles.get_drawn_count() - (triangles.get_drawn_count() % 3);
+
+    // Collect every triangle edge, with its endpoints in position order.
+    edges.reserve(count);
+    for (uint32_t i = 0; i < count; i += 3) {
+        for (uint32_t j = 0; j < 3; j++) {
+            uint32_t a = i + j;
+            uint32_t b = i + ((j + 1) % 3);
+            if (position_less(triangles.get_drawn(b), triangles.get_drawn(a))) {
+                std::swap(a, b);
+            }
+            edges.push_back(edge(a, b));
+        }
+    }
+
+    // Sort edges by position, so shared edges become neighbours.
+    auto less = [&](const edge &lhs, const edge &rhs) {
+        if (position_less(triangles.get_drawn(lhs.first), triangles.get_drawn(rhs.first))) {
+            return true;
+        }
+        if (position_less(triangles.get_drawn(rhs.first), triangles.get_drawn(lhs.first))) {
+            return false;
+        }
+        return position_less(triangles.get_drawn(lhs.second), triangles.get_drawn(rhs.second));
+    };
+    std::sort(edges.begin(), edges.end(), less);
+
+    // Append each distinct edge once.
+    v.set_primitive(cosmodon::primitive::line);
+    for (uint32_t i = 0; i < edges.size(); i++) {
+        if (i > 0 && !less(edges[i - 1], edges[i])) {
+            continue;
+        }
+        v.add(triangles.get_drawn(edges[i].first));
+        v.add(triangles.get_drawn(edges[i].second));
+    }
+}
@@ -0,0 +1,625 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <common/clock.hpp>
+#include <common/exception.hpp>
+#include <common/mapped_file.hpp>
+#include <common/parse.hpp>
+#include <render/import.hpp>
+
+// Counts and statistics of one block of OBJ input.
+struct obj_block
+{
+    const char *begin;
+    const char *end;
+    uint32_t vertices;
+    uint32_t triangles;
+    uint64_t lines;
+    uint64_t rejected;
+};
+
+// A parsed JSON value, as found in glTF files.
+struct json
+{
+    enum class kind : uint8_t
+    {
+        null,
+        boolean,
+        number,
+        string,
+        array,
+        object
+    };
+
+    kind type;
+    double number;
+    std::string text;
+    std::vector<json> items;
+    std::vector<std::string> keys;
+
+    // Retrieves a member of an object, or a null pointer if absent.
+    const json* get(const std::string &key) const
+    {
+        for (uint32_t i = 0; i < keys.size(); i++) {
+            if (keys[i] == key) {
+                return &items[i];
+            }
+        }
+        return nullptr;
+    }
+
+    // Retrieves a numeric member of an object, or a fallback if absent.
+    double get(const std::string &key, double fallback) const
+    {
+        const json *member = get(key);
+        return (member != nullptr && member->type == kind::number) ? member->number : fallback;
+    }
+};
+
+// A glTF accessor, resolved to raw bytes within the binary chunk.
+struct gltf_accessor
+{
+    const uint8_t *data;
+    uint32_t count;
+    uint32_t stride;
+    uint32_t component;
+    uint8_t components;
+    bool normalized;
+};
+
+// A glTF triangle list, with its place in the imported vertices.
+struct gltf_primitive
+{
+    gltf_accessor positions;
+    gltf_accessor colors;
+    gltf_accessor indices;
+    bool colored;
+    bool indexed;
+    uint32_t vertex_base;
+    uint32_t index_base;
+};
+
+// Local function to run jobs on a pool, or on the calling thread without one.
+static void run(cosmodon::pool *workers, uint32_t jobs, const cosmodon::pool::task &job)
+{
+    if (workers != nullptr) {
+        workers->run(jobs, job);
+    } else {
+        for (uint32_t i = 0; i < jobs; i++) {
+            job(i, 0);
+        }
+    }
+}
+
+// Local function to find the end of a whitespace-separated token.
+static const char* token_end(const char *p, const char *end)
+{
+    while (p < end && *p != ' ' && *p != '\t') {
+        p++;
+    }
+    return p;
+}
+
+// Local function to find the type of an OBJ line: 'v' for vertices, 'f' for faces, or 0.
+static char obj_type(const char *p, const char *end)
+{
+    if (end - p >= 2 && (p[1] == ' ' || p[1] == '\t') && (p[0] == 'v' || p[0] == 'f')) {
+        return p[0];
+    }
+    return 0;
+}
+
+// Local function to count the vertex references of an OBJ face line.
+static uint32_t face_size(const char *p, const char *end)
+{
+    uint32_t count = 0;
+
+    p = cosmodon::parse::skip_space(p + 2, end);
+    while (p < end) {
+        count++;
+        p = cosmodon::parse::skip_space(token_end(p, end), end);
+    }
+    return count;
+}
+
+// Local function to convert a color channel from zero to one into a byte, clamping values out of
+// range, and not a number, first.
+static uint8_t channel(cosmodon::number value)
+{
+    return static_cast<uint8_t>((value > 0) ? ((value < 1) ? value * 255 : 255) : 0);
+}
+
+// Local function to step through the lines of a block, ignoring blank lines and comments.
+template <typename visitor>
+static void each_line(const char *p, const char *end, const visitor &visit)
+{
+    while (p < end) {
+        const char *line_end = cosmodon::parse::find(p, end, '\n');
+        const char *next = (line_end < end) ? line_end + 1 : end;
+        if (line_end > p && *(line_end - 1) == '\r') {
+            line_end--;
+        }
+        p = cosmodon::parse::skip_space(p, line_end);
+        if (p < line_end && *p != '#') {
+            visit(p, line_end);
+        }
+        p = next;
+    }
+}
+
+// Import an OBJ mesh.
+cosmodon::import::report cosmodon::import::obj(cosmodon::vertices &v, const std::string &path, cosmodon::pool *workers)
+{
+    cosmodon::import::report result;
+    cosmodon::clock timer;
+    cosmodon::mapped_file file;
+    uint32_t total_vertices = 0;
+    uint32_t total_triangles = 0;
+
+    // Map input, and split it into blocks of about 4 MB at line boundaries.
+    file.open(path);
+    file.advise(0, file.size(), cosmodon::mapped_file::advice::sequential);
+    const char *begin = reinterpret_cast<const char*>(file.data());
+    const char *end = begin + file.size();
+    uint32_t count = std::max<uint64_t>(1, std::min<uint64_t>(file.size() >> 22, 65536));
+    std::vector<obj_block> blocks(count);
+    for (uint32_t i = 0; i < count; i++) {
+        const char *p = begin + file.size() * i / count;
+        blocks[i].begin = (i == 0) ? begin : cosmodon::parse::next_line(p - 1, end);
+        blocks[i].vertices = blocks[i].triangles = 0;
+        blocks[i].lines = blocks[i].rejected = 0;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        blocks[i].end = (i + 1 < count) ? blocks[i + 1].begin : end;
+    }
+
+    // Count vertices and fan triangles per block.
+    run(workers, count, [&](uint32_t index, uint8_t thread) {
+        obj_block &block = blocks[index];
+        each_line(block.begin, block.end, [&](const char *p, const char *line_end) {
+            block.lines++;
+            char type = obj_type(p, line_end);
+            if (type == 'v') {
+                block.vertices++;
+            } else if (type == 'f') {
+                uint32_t size = face_size(p, line_end);
+                if (size < 3) {
+                    block.rejected++;
+                } else {
+                    block.triangles += size - 2;
+                }
+            }
+        });
+    });
+
+    // Size storage, and turn counts into each block's starting offsets.
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t vertices = blocks[i].vertices;
+        uint32_t triangles = blocks[i].triangles;
+        blocks[i].vertices = total_vertices;
+        blocks[i].triangles = total_triangles;
+        total_vertices += vertices;
+        total_triangles += triangles;
+    }
+    v.clear();
+    v.set_primitive(cosmodon::primitive::triangle);
+    v.resize(total_vertices);
+    v.resize_indices(total_triangles * 3);
+
+    // Parse vertices and faces into place. Relative indices count back from the vertices read
+    // so far, in file order.
+    std::atomic<uint64_t> rejected(0);
+    uint32_t *indices = v.get_indices();
+    run(workers, count, [&](uint32_t index, uint8_t thread) {
+        obj_block &block = blocks[index];
+        uint32_t next_vertex = block.vertices;
+        uint32_t next_index = block.triangles * 3;
+        uint64_t bad = 0;
+
+        each_line(block.begin, block.end, [&](const char *p, const char *line_end) {
+            char type = obj_type(p, line_end);
+
+            // Vertex, with optional color.
+            if (type == 'v') {
+                cosmodon::number values[6] = {0, 0, 0, 1, 1, 1};
+                uint8_t read = 0;
+                p = cosmodon::parse::skip_space(p + 2, line_end);
+                while (read < 6 && p < line_end) {
+                    const char *q = cosmodon::parse::real(p, line_end, values[read]);
+                    if (q == nullptr) {
+                        break;
+                    }
+                    read++;
+                    p = cosmodon::parse::skip_space(q, line_end);
+                }
+                if (read < 3) {
+                    bad++;
+                }
+                v[next_vertex++] = cosmodon::vertex(values[0], values[1], values[2],
+                  cosmodon::color(channel(values[3]), channel(values[4]), channel(values[5])));
+            }
+
+            // Face, split into a fan.
+            else if (type == 'f' && face_size(p, line_end) >= 3) {
+                uint32_t first = 0, previous = 0, position = 0;
+                bool valid = true;
+                p = cosmodon::parse::skip_space(p + 2, line_end);
+                while (p < line_end) {
+                    int64_t reference = 0;
+                    const char *q = cosmodon::parse::integer(p, line_end, reference);
+                    int64_t resolved = (reference > 0) ? reference - 1 : static_cast<int64_t>(next_vertex) + reference;
+                    if (q == nullptr || reference == 0 || resolved < 0 || resolved >= total_vertices) {
+                        valid = false;
+                        resolved = 0;
+                    }
+                    if (position >= 2) {
+                        indices[next_index++] = first;
+                        indices[next_index++] = previous;
+                        indices[next_index++] = resolved;
+                    }
+                    first = (position == 0) ? resolved : first;
+                    previous = resolved;
+                    position++;
+                    p = cosmodon::parse::skip_space(token_end(p, line_end), line_end);
+                }
+                bad += valid ? 0 : 1;
+            }
+        });
+        rejected += bad;
+    });
+
+    for (uint32_t i = 0; i < count; i++) {
+        result.lines += blocks[i].lines;
+        result.rejected += blocks[i].rejected;
+    }
+    result.rejected += rejected;
+    result.records = total_triangles;
+    result.bytes = file.size();
+    result.seconds = timer.elapsed(cosmodon::unit::microsecond) / 1e6f;
+    return result;
+}
+
+// Local function to parse a JSON value, returning false if malformed.
+static bool parse_json(const char *&p, const char *end, json &out, uint8_t depth)
+{
+    auto skip = [&]() {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
+            p++;
+        }
+    };
+    auto parse_string = [&](std::string &text) {
+        p++;
+        while (p < end && *p != '"') {
+            if (*p == '\\' && p + 1 < end) {
+                p++;
+                const char *escapes = "\"\\/bfnrt";
+                const char *values = "\"\\/\b\f\n\r\t";
+                const char *found = std::strchr(escapes, *p);
+                if (*p == 'u') {
+                    text += '?';
+                    p += std::min<ptrdiff_t>(4, end - p - 1);
+                } else if (found != nullptr && *found != '\0') {
+                    text += values[found - escapes];
+                } else {
+                    return false;
+                }
+            } else {
+                text += *p;
+            }
+            p++;
+        }
+        if (p >= end) {
+            return false;
+        }
+        p++;
+        return true;
+    };
+
+    skip();
+    if (p >= end || depth == 0) {
+        return false;
+    }
+    out.type = json::kind::null;
+
+    // Objects and arrays.
+    if (*p == '{' || *p == '[') {
+        bool object = (*p == '{');
+        char close = object ? '}' : ']';
+        out.type = object ? json::kind::object : json::kind::array;
+        p++;
+        skip();
+        if (p < end && *p == close) {
+            p++;
+            return true;
+        }
+        while (true) {
+            if (object) {
+                out.keys.push_back(std::string());
+                skip();
+                if (p >= end || *p != '"' || !parse_string(out.keys.back())) {
+                    return false;
+                }
+                skip();
+                if (p >= end || *p != ':') {
+                    return false;
+                }
+                p++;
+            }
+            out.items.push_back(json());
+            if (!parse_json(p, end, out.items.back(), depth - 1)) {
+                return false;
+            }
+            skip();
+            if (p < end && *p == ',') {
+                p++;
+            } else if (p < end && *p == close) {
+                p++;
+                return true;
+            } else {
+                return false;
+            }
+        }
+    }
+
+    // Strings.
+    if (*p == '"') {
+        out.type = json::kind::string;
+        return parse_string(out.text);
+    }
+
+    // Literals.
+    const char *literals[] = {"true", "false", "null"};
+    for (uint8_t i = 0; i < 3; i++) {
+        size_t length = std::strlen(literals[i]);
+        if (static_cast<size_t>(end - p) >= length && std::strncmp(p, literals[i], length) == 0) {
+            out.type = (i < 2) ? json::kind::boolean : json::kind::null;
+            out.number = (i == 0) ? 1 : 0;
+            p += length;
+            return true;
+        }
+    }
+
+    // Numbers, read exactly, since offsets may not fit in a float.
+    const char *q = p;
+    while (q < end && std::strchr("+-0123456789.eE", *q) != nullptr && *q != '\0') {
+        q++;
+    }
+    if (q == p) {
+        return false;
+    }
+    std::string copy(p, q);
+    out.type = json::kind::number;
+    out.number = std::strtod(copy.c_str(), nullptr);
+    p = q;
+    return true;
+}
+
+// Local function to resolve a glTF accessor within the binary chunk.
+static bool resolve_accessor(const json &root, double index, const uint8_t *binary, uint64_t binary_size,
+  gltf_accessor &out)
+{
+    const uint8_t type_sizes[] = {1, 2, 3, 4, 4, 9, 16};
+    const char *type_names[] = {"SCALAR", "VEC2", "VEC3", "VEC4", "MAT2", "MAT3", "MAT4"};
+    const json *accessors = root.get("accessors");
+    const json *views = root.get("bufferViews");
+
+    if (accessors == nullptr || index < 0 || index >= accessors->items.size() || views == nullptr) {
+        return false;
+    }
+    const json &accessor = accessors->items[static_cast<uint32_t>(index)];
+    const json *type = accessor.get("type");
+    double view_index = accessor.get("bufferView", -1);
+    if (type == nullptr || accessor.get("sparse") != nullptr || view_index < 0 || view_index >= views->items.size()) {
+        return false;
+    }
+    const json &view = views->items[static_cast<uint32_t>(view_index)];
+    if (view.get("buffer", 0) != 0) {
+        return false;
+    }
+
+    // Describe elements.
+    out.components = 0;
+    for (uint8_t i = 0; i < 7; i++) {
+        if (type->text == type_names[i]) {
+            out.components = type_sizes[i];
+        }
+    }
+    out.component = accessor.get("componentType", 0);
+    out.count = accessor.get("count", 0);
+    const json *normalized = accessor.get("normalized");
+    out.normalized = (normalized != nullptr && normalized->number != 0);
+    uint32_t component_size = (out.component == 5120 || out.component == 5121) ? 1 :
+      ((out.component == 5122 || out.component == 5123) ? 2 : ((out.component == 5125 || out.component == 5126) ? 4 : 0));
+    uint64_t element = static_cast<uint64_t>(component_size) * out.components;
+    out.stride = view.get("byteStride", 0);
+    out.stride = (out.stride == 0) ? element : out.stride;
+
+    // Check that every element lies within the view, and the view within the binary chunk.
+    uint64_t view_offset = view.get("byteOffset", 0);
+    uint64_t view_length = view.get("byteLength", 0);
+    uint64_t offset = accessor.get("byteOffset", 0);
+    if (element == 0 || view_offset + view_length > binary_size ||
+      (out.count > 0 && offset + static_cast<uint64_t>(out.stride) * (out.count - 1) + element > view_length)) {
+        return false;
+    }
+    out.data = binary + view_offset + offset;
+    return true;
+}
+
+// Local function to read a component of a glTF accessor element as a real number.
+static cosmodon::number read_component(const gltf_accessor &a, uint32_t element, uint8_t component)
+{
+    const uint8_t *p = a.data + static_cast<uint64_t>(a.stride) * element;
+    switch (a.component) {
+        case 5126: {
+            float value;
+            std::memcpy(&value, p + component * 4, 4);
+            return value;
+        }
+        case 5121:
+            return a.normalized ? p[component] / 255.0f : p[component];
+        case 5123: {
+            uint16_t value;
+            std::memcpy(&value, p + component * 2, 2);
+            return a.normalized ? value / 65535.0f : value;
+        }
+        case 5125: {
+            uint32_t value;
+            std::memcpy(&value, p + component * 4, 4);
+            return value;
+        }
+    }
+    return 0;
+}
+
+// Local function to read a glTF index.
+static uint32_t read_index(const gltf_accessor &a, uint32_t element)
+{
+    const uint8_t *p = a.data + static_cast<uint64_t>(a.stride) * element;
+    uint16_t small;
+    uint32_t large;
+
+    switch (a.component) {
+        case 5121:
+            return *p;
+        case 5123:
+            std::memcpy(&small, p, 2);
+            return small;
+        default:
+            std::memcpy(&large, p, 4);
+            return large;
+    }
+}
+
+// Import a binary glTF file.
+cosmodon::import::report cosmodon::import::gltf(cosmodon::vertices &v, const std::string &path, cosmodon::pool *workers)
+{
+    const uint32_t magic = 0x46546C67;
+    const uint32_t chunk_json = 0x4E4F534A;
+    const uint32_t chunk_binary = 0x004E4942;
+    const uint32_t range = 65536;
+    cosmodon::import::report result;
+    cosmodon::clock timer;
+    cosmodon::mapped_file file;
+    std::vector<gltf_primitive> primitives;
+    uint32_t header[5];
+    uint32_t total_vertices = 0;
+    uint32_t total_indices = 0;
+    json root;
+
+    // Read header and JSON chunk.
+    file.open(path);
+    if (file.size() < sizeof(header)) {
+        throw cosmodon::exception::error("Invalid glTF file: " + path);
+    }
+    std::memcpy(header, file.data(), sizeof(header));
+    if (header[0] != magic || header[1] != 2 || header[2] > file.size() || header[2] < sizeof(header) ||
+      header[4] != chunk_json || header[3] > header[2] - sizeof(header)) {
+        throw cosmodon::exception::error("Invalid glTF file: " + path);
+    }
+    const char *text = reinterpret_cast<const char*>(file.data()) + sizeof(header);
+    if (!parse_json(text, text + header[3], root, 64) || root.type != json::kind::object) {
+        throw cosmodon::exception::error("Invalid glTF JSON: " + path);
+    }
+
+    // Find binary chunk, which follows the 4-byte aligned JSON chunk.
+    const uint8_t *binary = nullptr;
+    uint64_t binary_size = 0;
+    uint64_t next = sizeof(header) + ((header[3] + 3) & ~3u);
+    if (next + 8 <= header[2]) {
+        uint32_t chunk[2];
+        std::memcpy(chunk, file.data() + next, 8);
+        if (chunk[1] == chunk_binary && chunk[0] <= header[2] - next - 8) {
+            binary = file.data() + next + 8;
+            binary_size = chunk[0];
+        }
+    }
+
+    // Collect triangle lists, and where they go.
+    const json *meshes = root.get("meshes");
+    for (uint32_t i = 0; meshes != nullptr && i < meshes->items.size(); i++) {
+        const json *list = meshes->items[i].get("primitives");
+        for (uint32_t j = 0; list != nullptr && j < list->items.size(); j++) {
+            const json &source = list->items[j];
+            const json *attributes = source.get("attributes");
+            gltf_primitive p;
+
+            bool valid = attributes != nullptr && source.get("mode", 4) == 4 &&
+              resolve_accessor(root, attributes->get("POSITION", -1), binary, binary_size, p.positions) &&
+              p.positions.component == 5126 && p.positions.components == 3;
+            p.colored = valid && attributes->get("COLOR_0") != nullptr;
+            if (p.colored) {
+                valid = resolve_accessor(root, attributes->get("COLOR_0", -1), binary, binary_size, p.colors) &&
+                  p.colors.count == p.positions.count && (p.colors.components == 3 || p.colors.components == 4);
+            }
+            p.indexed = valid && source.get("indices") != nullptr;
+            if (p.indexed) {
+                valid = resolve_accessor(root, source.get("indices", -1), binary, binary_size, p.indices) &&
+                  p.indices.components == 1 && p.indices.component != 5126;
+            }
+            if (!valid) {
+                result.rejected++;
+                continue;
+            }
+
+            uint32_t indices = p.indexed ? p.indices.count : p.positions.count;
+            p.vertex_base = total_vertices;
+            p.index_base = total_indices;
+            total_vertices += p.positions.count;
+            total_indices += indices - indices % 3;
+            primitives.push_back(p);
+        }
+    }
+
+    // Size storage, and split conversion into jobs over ranges of elements.
+    v.clear();
+    v.set_primitive(cosmodon::primitive::triangle);
+    v.resize(total_vertices);
+    v.resize_indices(total_indices);
+    std::vector<std::pair<uint32_t, uint32_t>> jobs;
+    for (uint32_t i = 0; i < primitives.size(); i++) {
+        uint32_t elements = std::max(primitives[i].positions.count,
+          primitives[i].indexed ? primitives[i].indices.count : 0);
+        for (uint32_t first = 0; first < elements; first += range) {
+            jobs.push_back(std::make_pair(i, first));
+        }
+    }
+
+    // Convert vertices and indices into place.
+    std::atomic<uint64_t> rejected(0);
+    uint32_t *indices = v.get_indices();
+    run(workers, jobs.size(), [&](uint32_t job, uint8_t thread) {
+        const gltf_primitive &p = primitives[jobs[job].first];
+        uint32_t first = jobs[job].second;
+        uint32_t index_count = (p.indexed ? p.indices.count : p.positions.count) / 3 * 3;
+        uint64_t bad = 0;
+
+        for (uint32_t i = first; i < std::min(first + range, p.positions.count); i++) {
+            cosmodon::color c = cosmodon::white;
+            if (p.colored) {
+                c.r = channel(read_component(p.colors, i, 0));
+                c.g = channel(read_component(p.colors, i, 1));
+                c.b = channel(read_component(p.colors, i, 2));
+                c.a = (p.colors.components == 4) ? channel(read_component(p.colors, i, 3)) : 255;
+            }
+            v[p.vertex_base + i] = cosmodon::vertex(read_component(p.positions, i, 0),
+              read_component(p.positions, i, 1), read_component(p.positions, i, 2), c);
+        }
+        for (uint32_t i = first; i < std::min(first + range, index_count); i++) {
+            uint32_t index = p.indexed ? read_index(p.indices, i) : i;
+            if (index >= p.positions.count) {
+                index = 0;
+                bad++;
+            }
+            indices[p.index_base + i] = p.vertex_base + index;
+        }
+        rejected += bad;
+    });
+
+    result.rejected += rejected;
+    result.records = total_indices / 3;
+    result.bytes = file.size();
+    result.seconds = timer.elapsed(cosmodon::unit::microsecond) / 1e6f;
+    return result;
+}
@@ -0,0 +1,339 @@
+#include <algorithm>
+#include <functional>
+#include <common/clock.hpp>
+#include <common/mapped_file.hpp>
+#include <common/parse.hpp>
+#include <render/catalog.hpp>
+#include <render/import.hpp>
+
+// Roles of imported fields.
+enum class field : uint8_t
+{
+    x,
+    y,
+    z,
+    magnitude,
+    color_index,
+    none
+};
+
+// A parsed star.
+struct star_entry
+{
+    cosmodon::number x;
+    cosmodon::number y;
+    cosmodon::number z;
+    cosmodon::color c;
+};
+
+// Parsed stars and statistics of one block of input.
+struct star_block
+{
+    std::vector<star_entry> stars;
+    uint64_t lines;
+    uint64_t rejected;
+};
+
+// Star colors by B-V color index, from hot blue to cool red.
+static const cosmodon::number color_indices[] = {-0.33f, -0.17f, 0.0f, 0.42f, 0.65f, 1.0f, 1.6f};
+static const cosmodon::color index_colors[] = {
+    cosmodon::color(155, 176, 255), cosmodon::color(170, 191, 255), cosmodon::color(202, 215, 255),
+    cosmodon::color(248, 247, 255), cosmodon::color(255, 244, 234), cosmodon::color(255, 210, 161),
+    cosmodon::color(255, 204, 111),
+};
+
+// Local function to color a star by color index and magnitude.
+static cosmodon::color star_color(const cosmodon::import::table &columns, const cosmodon::number *values)
+{
+    cosmodon::color result = cosmodon::white;
+    cosmodon::number index = values[static_cast<uint8_t>(field::color_index)];
+    cosmodon::number magnitude = values[static_cast<uint8_t>(field::magnitude)];
+
+    // Interpolate color between neighbouring indices.
+    if (columns.color_index != cosmodon::import::table::none) {
+        uint8_t i = 0;
+        while (i < 5 && index > color_indices[i + 1]) {
+            i++;
+        }
+        cosmodon::number t = (index - color_indices[i]) / (color_indices[i + 1] - color_indices[i]);
+        t = (t < 0) ? 0 : ((t > 1) ? 1 : t);
+        result.r = index_colors[i].r + (index_colors[i + 1].r - index_colors[i].r) * t;
+        result.g = index_colors[i].g + (index_colors[i + 1].g - index_colors[i].g) * t;
+        result.b = index_colors[i].b + (index_colors[i + 1].b - index_colors[i].b) * t;
+    }
+
+    // Fade fainter stars.
+    if (columns.magnitude != cosmodon::import::table::none && columns.faint != columns.bright) {
+        cosmodon::number t = (magnitude - columns.bright) / (columns.faint - columns.bright);
+        t = (t < 0) ? 0 : ((t > 1) ? 1 : t);
+        result.a = 255 - static_cast<uint8_t>(223 * t);
+    }
+    return result;
+}
+
+// Local function to parse the fields of one line, returning false if the line is malformed.
+static bool parse_line(const char *p, const char *end, const cosmodon::import::table &columns,
+  const field *roles, uint8_t fields, cosmodon::number *values)
+{
+    for (uint8_t i = 0; i < fields; i++) {
+        p = cosmodon::parse::skip_space(p, end);
+
+        // Parse wanted fields, and pass over others.
+        if (roles[i] != field::none) {
+            if ((p = cosmodon::parse::real(p, end, values[static_cast<uint8_t>(roles[i])])) == nullptr) {
+                return false;
+            }
+        } else if (columns.separator != 0) {
+            p = cosmodon::parse::find(p, end, columns.separator);
+        } else {
+            while (p < end && *p != ' ' && *p != '\t') {
+                p++;
+            }
+        }
+
+        // Step over the separator.
+        if (columns.separator != 0 && i + 1 < fields) {
+            p = cosmodon::parse::skip_space(p, end);
+            if (p >= end || *p != columns.separator) {
+                return false;
+            }
+            p++;
+        } else if (columns.separator == 0 && i + 1 < fields && (p >= end || (*p != ' ' && *p != '\t'))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Local function to parse all lines starting within a block.
+static void parse_block(const char *begin, const char *end, const cosmodon::import::table &columns,
+  const field *roles, uint8_t fields, star_block &block)
+{
+    cosmodon::number values[5] = {0, 0, 0, 0, 0};
+    const char *p = begin;
+
+    block.lines = 0;
+    block.rejected = 0;
+    while (p < end) {
+        const char *line_end = cosmodon::parse::find(p, end, '\n');
+        const char *q = cosmodon::parse::skip_space(p, line_end);
+        const char *next = (line_end < end) ? line_end + 1 : end;
+
+        // Ignore blank lines and comments.
+        if (q == line_end || *q == '#' || *q == '\r') {
+            p = next;
+            continue;
+        }
+        block.lines++;
+        if (line_end > p && *(line_end - 1) == '\r') {
+            line_end--;
+        }
+        if (!parse_line(p, line_end, columns, roles, fields, values)) {
+            block.rejected++;
+        } else {
+            block.stars.push_back({values[0], values[1], values[2], star_color(columns, values)});
+        }
+        p = next;
+    }
+}
+
+// Constructor.
+cosmodon::import::report::report()
+  : bytes(0), lines(0), records(0), rejected(0), seconds(0)
+{
+
+}
+
+// Retrieve bandwidth.
+cosmodon::number cosmodon::import::report::get_bandwidth() const
+{
+    return (seconds > 0) ? bytes / seconds / 1e6f : 0;
+}
+
+// Constructor.
+cosmodon::import::table::table()
+  : x(0), y(1), z(2), magnitude(3), color_index(4), separator(','), header(0), bright(0), faint(12)
+{
+
+}
+
+// Local function to run jobs on a pool, or on the calling thread without one.
+static void run(cosmodon::pool *workers, uint32_t jobs, const cosmodon::pool::task &job)
+{
+    if (workers != nullptr) {
+        workers->run(jobs, job);
+    } else {
+        for (uint32_t i = 0; i < jobs; i++) {
+            job(i, 0);
+        }
+    }
+}
+
+// Local function to parse a table in batches of blocks, handing each batch over before the next
+// is parsed, so only one batch of parsed stars is held at a time. A batch of zero parses all
+// blocks at once.
+static void parse_table(const std::string &path, const cosmodon::import::table &columns, uint32_t batch,
+  cosmodon::pool *workers, cosmodon::import::report &result,
+  const std::function<void(std::vector<star_block> &blocks, uint32_t count)> &take)
+{
+    cosmodon::mapped_file file;
+    field roles[255];
+    uint8_t fields = 0;
+    const uint8_t wanted[] = {columns.x, columns.y, columns.z, columns.magnitude, columns.color_index};
+
+    // Map each column to its role.
+    std::fill(roles, roles + 255, field::none);
+    for (uint8_t i = 0; i < 5; i++) {
+        if (wanted[i] != cosmodon::import::table::none) {
+            roles[wanted[i]] = static_cast<field>(i);
+            fields = std::max<uint8_t>(fields, wanted[i] + 1);
+        }
+    }
+
+    // Map input, which is read front to back.
+    file.open(path);
+    file.advise(0, file.size(), cosmodon::mapped_file::advice::sequential);
+    const char *begin = reinterpret_cast<const char*>(file.data());
+    const char *end = begin + file.size();
+    for (uint32_t i = 0; i < columns.header; i++) {
+        begin = cosmodon::parse::next_line(begin, end);
+    }
+
+    // Split into blocks of about 4 MB. Each line belongs to the block its first character is in.
+    uint64_t size = end - begin;
+    uint32_t count = std::max<uint64_t>(1, std::min<uint64_t>(size >> 22, 65536));
+    auto align = [&](uint32_t index) {
+        const char *p = begin + size * index / count;
+        return (index == 0 || index == count) ? p : cosmodon::parse::next_line(p - 1, end);
+    };
+    batch = (batch == 0) ? count : std::min(batch, count);
+
+    // Parse a batch of blocks, and hand it over.
+    std::vector<star_block> blocks(batch);
+    for (uint32_t first = 0; first < count; first += batch) {
+        uint32_t amount = std::min(batch, count - first);
+        run(workers, amount, [&](uint32_t index, uint8_t thread) {
+            parse_block(align(first + index), align(first + index + 1), columns, roles, fields, blocks[index]);
+        });
+        for (uint32_t i = 0; i < amount; i++) {
+            result.lines += blocks[i].lines;
+            result.rejected += blocks[i].rejected;
+            result.records += blocks[i].stars.size();
+        }
+        take(blocks, amount);
+    }
+    result.bytes = file.size();
+}
+
+// Import a table of stars into chunks.
+cosmodon::import::report cosmodon::import::stars(std::vector<cosmodon::points> &chunks, const std::string &path,
+  const cosmodon::import::table &columns, uint8_t cells, cosmodon::pool *workers)
+{
+    cosmodon::import::report result;
+    cosmodon::clock timer;
+
+    // The cube around all stars is needed before any is placed, so all blocks are parsed at once.
+    parse_table(path, columns, 0, workers, result, [&](std::vector<star_block> &blocks, uint32_t count) {
+
+        // Find the cube around all stars.
+        cosmodon::vector low, high;
+        bool first = true;
+        for (uint32_t i = 0; i < count; i++) {
+            for (const star_entry &s : blocks[i].stars) {
+                if (first) {
+                    low = high = cosmodon::vector(s.x, s.y, s.z);
+                    first = false;
+                }
+                low = cosmodon::vector(std::min(low.x, s.x), std::min(low.y, s.y), std::min(low.z, s.z));
+                high = cosmodon::vector(std::max(high.x, s.x), std::max(high.y, s.y), std::max(high.z, s.z));
+            }
+        }
+        cosmodon::number extent = std::max(std::max(high.x - low.x, high.y - low.y), high.z - low.z);
+        extent = ((extent > 0) ? extent * 1.0001f : 1) / std::max<uint8_t>(cells, 1);
+        cells = std::max<uint8_t>(cells, 1);
+
+        // Prepare chunks.
+        uint32_t cell_count = static_cast<uint32_t>(cells) * cells * cells;
+        chunks.assign(cell_count, cosmodon::points());
+        for (uint32_t i = 0; i < cell_count; i++) {
+            chunks[i].set_cell(cosmodon::vector(
+                low.x + extent * (i % cells),
+                low.y + extent * ((i / cells) % cells),
+                low.z + extent * (i / cells / cells)
+            ), extent);
+        }
+        auto locate = [&](const star_entry &s) {
+            cosmodon::number axes[3] = {s.x - low.x, s.y - low.y, s.z - low.z};
+            uint32_t index = 0;
+            for (int8_t i = 2; i >= 0; i--) {
+                uint32_t cell = std::min<uint32_t>(axes[i] / extent, cells - 1);
+                index = index * cells + cell;
+            }
+            return index;
+        };
+
+        // Each worker takes a run of blocks, so counts are kept per worker rather than per block.
+        uint32_t jobs = std::min<uint32_t>(count, (workers != nullptr) ? workers->size() : 1);
+        auto first_block = [&](uint32_t job) {
+            return static_cast<uint32_t>(static_cast<uint64_t>(count) * job / jobs);
+        };
+
+        // Count stars per worker and chunk, then turn counts into offsets, and place stars.
+        std::vector<uint32_t> offsets(static_cast<size_t>(jobs) * cell_count, 0);
+        run(workers, jobs, [&](uint32_t job, uint8_t thread) {
+            uint32_t *counts = &offsets[static_cast<size_t>(job) * cell_count];
+            for (uint32_t block = first_block(job); block < first_block(job + 1); block++) {
+                for (const star_entry &s : blocks[block].stars) {
+                    counts[locate(s)]++;
+                }
+            }
+        });
+        for (uint32_t cell = 0; cell < cell_count; cell++) {
+            uint32_t total = 0;
+            for (uint32_t job = 0; job < jobs; job++) {
+                uint32_t &offset = offsets[static_cast<size_t>(job) * cell_count + cell];
+                uint32_t amount = offset;
+                offset = total;
+                total += amount;
+            }
+            chunks[cell].resize(total);
+        }
+        run(workers, jobs, [&](uint32_t job, uint8_t thread) {
+            uint32_t *next = &offsets[static_cast<size_t>(job) * cell_count];
+            for (uint32_t block = first_block(job); block < first_block(job + 1); block++) {
+                for (const star_entry &s : blocks[block].stars) {
+                    uint32_t cell = locate(s);
+                    chunks[cell][next[cell]++] = chunks[cell].quantize(cosmodon::vector(s.x, s.y, s.z), s.c);
+                }
+                std::vector<star_entry>().swap(blocks[block].stars);
+            }
+        });
+    });
+
+    result.seconds = timer.elapsed(cosmodon::unit::microsecond) / 1e6f;
+    return result;
+}
+
+// Import a table of stars into a catalog file.
+cosmodon::import::report cosmodon::import::stars(const std::string &source, const std::string &destination,
+  const cosmodon::import::table &columns, cosmodon::pool *workers)
+{
+    cosmodon::import::report result;
+    cosmodon::clock timer;
+    cosmodon::catalog::builder output;
+
+    // Stars go straight into the catalog a few blocks at a time, so each is held once.
+    uint32_t batch = 4 * ((workers != nullptr) ? workers->size() : 1);
+    parse_table(source, columns, batch, workers, result, [&](std::vector<star_block> &blocks, uint32_t count) {
+        for (uint32_t i = 0; i < count; i++) {
+            for (const star_entry &s : blocks[i].stars) {
+                output.add(cosmodon::vector(s.x, s.y, s.z), s.c);
+            }
+            std::vector<star_entry>().swap(blocks[i].stars);
+        }
+    });
+    output.write(destination);
+
+    result.seconds = timer.elapsed(cosmodon::unit::microsecond) / 1e6f;
+    return result;
+}
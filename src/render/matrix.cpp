@@ -58,6 +58,14 @@ void cosmodon::matrix::set(
     m_values[12] = w0; m_values[13] = w1; m_values[14] = w2; m_values[15] = w3;
 }
 
+// Sets matrix values from an array.
+void cosmodon::matrix::set(const cosmodon::number *values)
+{
+    for (uint8_t i = 0; i < 16; i++) {
+        m_values[i] = values[i];
+    }
+}
+
 // Retrieve raw matrix values as an array.
 const cosmodon::number* cosmodon::matrix::raw() const
 {
@@ -139,6 +147,54 @@ void cosmodon::matrix::set_rotation_z(number radians)
     (*this)[1][1] = cos;
 }
 
+// Compute the inverse.
+cosmodon::matrix cosmodon::matrix::inverse() const
+{
+    const cosmodon::number *m = m_values;
+    cosmodon::matrix result;
+    cosmodon::number *r = result.m_values;
+
+    // Determinants of 2x2 blocks, from the top two and bottom two rows.
+    cosmodon::number s0 = m[0] * m[5] - m[4] * m[1];
+    cosmodon::number s1 = m[0] * m[6] - m[4] * m[2];
+    cosmodon::number s2 = m[0] * m[7] - m[4] * m[3];
+    cosmodon::number s3 = m[1] * m[6] - m[5] * m[2];
+    cosmodon::number s4 = m[1] * m[7] - m[5] * m[3];
+    cosmodon::number s5 = m[2] * m[7] - m[6] * m[3];
+    cosmodon::number c5 = m[10] * m[15] - m[14] * m[11];
+    cosmodon::number c4 = m[9] * m[15] - m[13] * m[11];
+    cosmodon::number c3 = m[9] * m[14] - m[13] * m[10];
+    cosmodon::number c2 = m[8] * m[15] - m[12] * m[11];
+    cosmodon::number c1 = m[8] * m[14] - m[12] * m[10];
+    cosmodon::number c0 = m[8] * m[13] - m[12] * m[9];
+
+    cosmodon::number determinant = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    if (determinant == 0) {
+        result.set_zero();
+        return result;
+    }
+    cosmodon::number inverse = 1 / determinant;
+
+    // Adjugate, scaled by the inverse determinant.
+    r[0] = (m[5] * c5 - m[6] * c4 + m[7] * c3) * inverse;
+    r[1] = (-m[1] * c5 + m[2] * c4 - m[3] * c3) * inverse;
+    r[2] = (m[13] * s5 - m[14] * s4 + m[15] * s3) * inverse;
+    r[3] = (-m[9] * s5 + m[10] * s4 - m[11] * s3) * inverse;
+    r[4] = (-m[4] * c5 + m[6] * c2 - m[7] * c1) * inverse;
+    r[5] = (m[0] * c5 - m[2] * c2 + m[3] * c1) * inverse;
+    r[6] = (-m[12] * s5 + m[14] * s2 - m[15] * s1) * inverse;
+    r[7] = (m[8] * s5 - m[10] * s2 + m[11] * s1) * inverse;
+    r[8] = (m[4] * c4 - m[5] * c2 + m[7] * c0) * inverse;
+    r[9] = (-m[0] * c4 + m[1] * c2 - m[3] * c0) * inverse;
+    r[10] = (m[12] * s4 - m[13] * s2 + m[15] * s0) * inverse;
+    r[11] = (-m[8] * s4 + m[9] * s2 - m[11] * s0) * inverse;
+    r[12] = (-m[4] * c3 + m[5] * c1 - m[6] * c0) * inverse;
+    r[13] = (m[0] * c3 - m[1] * c1 + m[2] * c0) * inverse;
+    r[14] = (-m[12] * s3 + m[13] * s1 - m[14] * s0) * inverse;
+    r[15] = (m[8] * s3 - m[9] * s1 + m[10] * s0) * inverse;
+    return result;
+}
+
 // Swap matrix.
 void cosmodon::matrix::swap(matrix &other)
 {
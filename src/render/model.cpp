@@ -12,6 +12,29 @@ cosmodon::vector cosmodon::model::get_center() const
     return cosmodon::vertices::get_center() * get_matrix();
 }
 
+// Get world bounds.
+cosmodon::bounds cosmodon::model::get_world_bounds() const
+{
+    cosmodon::bounds local = get_bounds();
+    cosmodon::bounds result;
+
+    if (local.is_empty()) {
+        return result;
+    }
+
+    // Transform the corners of the local box.
+    for (uint8_t i = 0; i < 8; i++) {
+        cosmodon::vertex corner(
+            (i & 1) ? local.get_high().x : local.get_low().x,
+            (i & 2) ? local.get_high().y : local.get_low().y,
+            (i & 4) ? local.get_high().z : local.get_low().z,
+            1
+        );
+        result.expand(get_matrix() * corner);
+    }
+    return result;
+}
+
 // Set fill mode.
 void cosmodon::model::set_fill(bool fill)
 {
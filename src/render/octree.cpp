@@ -0,0 +1,293 @@
+#include <algorithm>
+#include <cmath>
+#include <render/octree.hpp>
+
+// Local function to read a coordinate by axis.
+static cosmodon::number get_axis(const cosmodon::vector &v, uint8_t axis)
+{
+    return (axis == 0) ? v.x : ((axis == 1) ? v.y : v.z);
+}
+
+// Local function to compute the squared distance from a point to a box.
+static cosmodon::number get_distance_squared(const cosmodon::bounds &box, const cosmodon::vector &point)
+{
+    cosmodon::number result = 0;
+    for (uint8_t i = 0; i < 3; i++) {
+        cosmodon::number p = get_axis(point, i);
+        cosmodon::number low = get_axis(box.get_low(), i);
+        cosmodon::number high = get_axis(box.get_high(), i);
+        cosmodon::number d = (p < low) ? (low - p) : ((p > high) ? (p - high) : 0);
+        result += d * d;
+    }
+    return result;
+}
+
+// Local function to check if a ray crosses a box within a distance.
+static bool crosses(const cosmodon::bounds &box, const cosmodon::ray &r, cosmodon::number distance)
+{
+    cosmodon::number near = 0;
+    cosmodon::number far = distance;
+    for (uint8_t i = 0; i < 3; i++) {
+        cosmodon::number origin = get_axis(r.origin, i);
+        cosmodon::number direction = get_axis(r.direction, i);
+        cosmodon::number low = get_axis(box.get_low(), i);
+        cosmodon::number high = get_axis(box.get_high(), i);
+
+        // Parallel to this slab, so the origin must lie within it.
+        if (direction == 0) {
+            if (origin < low || origin > high) {
+                return false;
+            }
+            continue;
+        }
+        cosmodon::number a = (low - origin) / direction;
+        cosmodon::number b = (high - origin) / direction;
+        near = std::max(near, std::min(a, b));
+        far = std::min(far, std::max(a, b));
+        if (near > far) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Handle meaning no object.
+const cosmodon::octree::handle cosmodon::octree::none;
+
+// Constructor.
+cosmodon::octree::octree(const cosmodon::bounds &region, uint8_t depth)
+{
+    reset(region, depth);
+}
+
+// Reset the region.
+void cosmodon::octree::reset(const cosmodon::bounds &region, uint8_t depth)
+{
+    cosmodon::vector size = region.get_size();
+    m_low = region.get_low();
+    m_size = std::max(std::max(size.x, size.y), size.z);
+    m_depth = std::min<uint8_t>(depth, 20);
+    clear();
+}
+
+// Remove all objects.
+void cosmodon::octree::clear()
+{
+    node root;
+    cosmodon::number half = m_size / 2;
+    root.box = cosmodon::bounds(
+        cosmodon::vector(m_low.x - half, m_low.y - half, m_low.z - half),
+        cosmodon::vector(m_low.x + m_size + half, m_low.y + m_size + half, m_low.z + m_size + half)
+    );
+    std::fill(root.children, root.children + 8, none);
+    root.parent = none;
+    root.first = none;
+    root.count = 0;
+
+    m_nodes.assign(1, root);
+    m_entries.clear();
+    m_free = none;
+    m_count = 0;
+}
+
+// Retrieve object count.
+uint32_t cosmodon::octree::size() const
+{
+    return m_count;
+}
+
+// Find the cell of an object.
+uint32_t cosmodon::octree::place(const cosmodon::bounds &box)
+{
+    cosmodon::vector center = box.get_center();
+    cosmodon::vector size = box.get_size();
+    cosmodon::number largest = std::max(std::max(size.x, size.y), size.z);
+
+    // Pick the deepest level whose cells are at least as large as the object.
+    uint8_t depth = 0;
+    cosmodon::number cell = m_size;
+    while (depth < m_depth && largest <= cell / 2) {
+        cell /= 2;
+        depth++;
+    }
+
+    // Objects centered outside the region stay in the root.
+    uint32_t coordinates[3];
+    for (uint8_t i = 0; i < 3; i++) {
+        cosmodon::number offset = (get_axis(center, i) - get_axis(m_low, i)) / cell;
+        if (!(offset >= 0 && offset < (1u << depth))) {
+            return 0;
+        }
+        coordinates[i] = static_cast<uint32_t>(offset);
+    }
+
+    // Walk down, creating missing cells.
+    uint32_t index = 0;
+    for (uint8_t level = 1; level <= depth; level++) {
+        uint8_t shift = depth - level;
+        uint8_t octant = ((coordinates[0] >> shift) & 1) | (((coordinates[1] >> shift) & 1) << 1) |
+          (((coordinates[2] >> shift) & 1) << 2);
+        if (m_nodes[index].children[octant] == none) {
+            node child;
+            cosmodon::number width = m_size / (1u << level);
+            cosmodon::vector low(
+                m_low.x + (coordinates[0] >> shift) * width,
+                m_low.y + (coordinates[1] >> shift) * width,
+                m_low.z + (coordinates[2] >> shift) * width
+            );
+            child.box = cosmodon::bounds(
+                cosmodon::vector(low.x - width / 2, low.y - width / 2, low.z - width / 2),
+                cosmodon::vector(low.x + width * 1.5f, low.y + width * 1.5f, low.z + width * 1.5f)
+            );
+            std::fill(child.children, child.children + 8, none);
+            child.parent = index;
+            child.first = none;
+            child.count = 0;
+            m_nodes[index].children[octant] = m_nodes.size();
+            m_nodes.push_back(child);
+        }
+        index = m_nodes[index].children[octant];
+    }
+    return index;
+}
+
+// Link an object into a cell.
+void cosmodon::octree::link(cosmodon::octree::handle object, uint32_t cell)
+{
+    entry &e = m_entries[object];
+    e.cell = cell;
+    e.previous = none;
+    e.next = m_nodes[cell].first;
+    if (e.next != none) {
+        m_entries[e.next].previous = object;
+    }
+    m_nodes[cell].first = object;
+    for (uint32_t i = cell; i != none; i = m_nodes[i].parent) {
+        m_nodes[i].count++;
+    }
+}
+
+// Unlink an object from its cell.
+void cosmodon::octree::unlink(cosmodon::octree::handle object)
+{
+    entry &e = m_entries[object];
+    if (e.previous != none) {
+        m_entries[e.previous].next = e.next;
+    } else {
+        m_nodes[e.cell].first = e.next;
+    }
+    if (e.next != none) {
+        m_entries[e.next].previous = e.previous;
+    }
+    for (uint32_t i = e.cell; i != none; i = m_nodes[i].parent) {
+        m_nodes[i].count--;
+    }
+}
+
+// Add an object.
+cosmodon::octree::handle cosmodon::octree::insert(const cosmodon::bounds &box)
+{
+    handle object = m_free;
+    if (object != none) {
+        m_free = m_entries[object].next;
+    } else {
+        object = m_entries.size();
+        m_entries.push_back(entry());
+    }
+    m_entries[object].box = box;
+    link(object, place(box));
+    m_count++;
+    return object;
+}
+
+// Move an object.
+void cosmodon::octree::move(cosmodon::octree::handle object, const cosmodon::bounds &box)
+{
+    uint32_t cell = place(box);
+    m_entries[object].box = box;
+    if (cell != m_entries[object].cell) {
+        unlink(object);
+        link(object, cell);
+    }
+}
+
+// Move many objects.
+void cosmodon::octree::move(const cosmodon::octree::handle *objects, const cosmodon::bounds *boxes, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        move(objects[i], boxes[i]);
+    }
+}
+
+// Remove an object.
+void cosmodon::octree::remove(cosmodon::octree::handle object)
+{
+    unlink(object);
+    m_entries[object].cell = none;
+    m_entries[object].next = m_free;
+    m_free = object;
+    m_count--;
+}
+
+// Retrieve object bounds.
+const cosmodon::bounds& cosmodon::octree::get_bounds(cosmodon::octree::handle object) const
+{
+    return m_entries[object].box;
+}
+
+// Collect objects accepted by a test.
+template <typename test>
+void cosmodon::octree::collect(test accept, std::vector<cosmodon::octree::handle> &results) const
+{
+    std::vector<uint32_t> stack;
+
+    // The root also holds objects outside the region, so it is always searched.
+    stack.push_back(0);
+    while (!stack.empty()) {
+        const node &n = m_nodes[stack.back()];
+        stack.pop_back();
+        for (handle i = n.first; i != none; i = m_entries[i].next) {
+            if (accept(m_entries[i].box)) {
+                results.push_back(i);
+            }
+        }
+        for (uint8_t i = 0; i < 8; i++) {
+            uint32_t child = n.children[i];
+            if (child != none && m_nodes[child].count > 0 && accept(m_nodes[child].box)) {
+                stack.push_back(child);
+            }
+        }
+    }
+}
+
+// Query by frustum.
+void cosmodon::octree::query(const cosmodon::frustum &volume, std::vector<cosmodon::octree::handle> &results) const
+{
+    collect([&](const cosmodon::bounds &box) {
+        return volume.intersects(box);
+    }, results);
+}
+
+// Query by box.
+void cosmodon::octree::query(const cosmodon::bounds &box, std::vector<cosmodon::octree::handle> &results) const
+{
+    collect([&](const cosmodon::bounds &other) {
+        return box.overlaps(other);
+    }, results);
+}
+
+// Query by sphere.
+void cosmodon::octree::query(const cosmodon::vector &center, cosmodon::number radius, std::vector<cosmodon::octree::handle> &results) const
+{
+    collect([&](const cosmodon::bounds &box) {
+        return get_distance_squared(box, center) <= radius * radius;
+    }, results);
+}
+
+// Query by ray.
+void cosmodon::octree::query(const cosmodon::ray &r, cosmodon::number distance, std::vector<cosmodon::octree::handle> &results) const
+{
+    collect([&](const cosmodon::bounds &box) {
+        return crosses(box, r, distance);
+    }, results);
+}
@@ -0,0 +1,147 @@
+#include <render/points.hpp>
+#include <render/vertices.hpp>
+
+// Local function to quantize a coordinate within a cell.
+static uint16_t quantize_axis(cosmodon::number value, cosmodon::number origin, cosmodon::number extent)
+{
+    cosmodon::number scaled = (value - origin) / extent * 65535.0f + 0.5f;
+    if (scaled <= 0) {
+        return 0;
+    }
+    if (scaled >= 65535.0f) {
+        return 65535;
+    }
+    return static_cast<uint16_t>(scaled);
+}
+
+// Constructor.
+cosmodon::points::points(cosmodon::vector origin, cosmodon::number extent)
+  : m_origin(origin), m_extent(extent)
+{
+
+}
+
+// Set cell.
+void cosmodon::points::set_cell(cosmodon::vector origin, cosmodon::number extent)
+{
+    m_origin = origin;
+    m_extent = extent;
+}
+
+// Retrieve cell origin.
+cosmodon::vector cosmodon::points::get_origin() const
+{
+    return m_origin;
+}
+
+// Retrieve cell extent.
+cosmodon::number cosmodon::points::get_extent() const
+{
+    return m_extent;
+}
+
+// Retrieve point count.
+uint32_t cosmodon::points::size() const
+{
+    return m_points.size();
+}
+
+// Change point count.
+void cosmodon::points::resize(uint32_t amount)
+{
+    m_points.resize(amount);
+}
+
+// Reserve storage.
+void cosmodon::points::reserve(uint32_t amount)
+{
+    m_points.reserve(amount);
+}
+
+// Remove all points.
+void cosmodon::points::clear()
+{
+    m_points.clear();
+}
+
+// Quantize a point.
+cosmodon::points::point cosmodon::points::quantize(const cosmodon::vector &position, const cosmodon::color &c) const
+{
+    point result;
+    result.x = quantize_axis(position.x, m_origin.x, m_extent);
+    result.y = quantize_axis(position.y, m_origin.y, m_extent);
+    result.z = quantize_axis(position.z, m_origin.z, m_extent);
+    result.r = c.r;
+    result.g = c.g;
+    result.b = c.b;
+    result.a = c.a;
+    return result;
+}
+
+// Add a point.
+void cosmodon::points::add(const cosmodon::vector &position, const cosmodon::color &c)
+{
+    m_points.push_back(quantize(position, c));
+}
+
+// Retrieve point position.
+cosmodon::vector cosmodon::points::get_position(uint32_t index) const
+{
+    const point &p = m_points[index];
+    cosmodon::number scale = m_extent / 65535.0f;
+    return cosmodon::vector(m_origin.x + p.x * scale, m_origin.y + p.y * scale, m_origin.z + p.z * scale);
+}
+
+// Retrieve point color.
+cosmodon::color cosmodon::points::get_color(uint32_t index) const
+{
+    const point &p = m_points[index];
+    return cosmodon::color(p.r, p.g, p.b, p.a);
+}
+
+// Append points to vertices.
+void cosmodon::points::expand(cosmodon::vertices &v) const
+{
+    expand(v, m_points.data(), m_points.size(), m_origin, m_extent);
+}
+
+// Append external points to vertices.
+void cosmodon::points::expand(cosmodon::vertices &v, const point *source, uint32_t count,
+  cosmodon::vector origin, cosmodon::number extent)
+{
+    cosmodon::number scale = extent / 65535.0f;
+
+    v.set_primitive(cosmodon::primitive::point);
+    v.reserve(v.size() + count);
+    for (uint32_t i = 0; i < count; i++) {
+        const point &p = source[i];
+        v.add(cosmodon::vertex(
+            cosmodon::vector(origin.x + p.x * scale, origin.y + p.y * scale, origin.z + p.z * scale),
+            cosmodon::color(p.r, p.g, p.b, p.a)
+        ));
+    }
+}
+
+// Retrieve raw storage.
+cosmodon::points::point* cosmodon::points::data()
+{
+    return m_points.data();
+}
+
+// Retrieve const raw storage.
+const cosmodon::points::point* cosmodon::points::data() const
+{
+    return m_points.data();
+}
+
+// Data access operator.
+cosmodon::points::point& cosmodon::points::operator [](const uint32_t index)
+{
+    return m_points[index];
+}
+
+// Const data access operator.
+const cosmodon::points::point& cosmodon::points::operator [](const uint32_t index) const
+{
+    return m_points[index];
+}
@@ -0,0 +1,18 @@
+#include <render/ray.hpp>
+
+// Constructor.
+cosmodon::ray::ray(const cosmodon::vector &init_origin, const cosmodon::vector &init_direction)
+  : origin(init_origin), direction(init_direction.normal())
+{
+
+}
+
+// Retrieve a point along the ray.
+cosmodon::vector cosmodon::ray::at(cosmodon::number distance) const
+{
+    return cosmodon::vector(
+        origin.x + direction.x * distance,
+        origin.y + direction.y * distance,
+        origin.z + direction.z * distance
+    );
+}
@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <render/scene.hpp>
+
+namespace
+{
+    // Rays traced per pool job.
+    const uint32_t rays_per_job = 256;
+}
+
+// Add a model.
+uint32_t cosmodon::scene::add(const cosmodon::model &object, const cosmodon::bvh &mesh)
+{
+    entry e;
+    e.object = &object;
+    e.mesh = &mesh;
+    m_entries.push_back(e);
+    return m_entries.size() - 1;
+}
+
+// Remove all models.
+void cosmodon::scene::clear()
+{
+    m_entries.clear();
+    m_tree.clear();
+}
+
+// Retrieve model count.
+uint32_t cosmodon::scene::size() const
+{
+    return m_entries.size();
+}
+
+// Retrieve a model.
+const cosmodon::model& cosmodon::scene::get_model(uint32_t index) const
+{
+    return *m_entries[index].object;
+}
+
+// Rebuild the hierarchy.
+void cosmodon::scene::update()
+{
+    std::vector<cosmodon::bounds> boxes(m_entries.size());
+
+    // Transform the corners of each model's local bounds into world space.
+    for (uint32_t i = 0; i < m_entries.size(); i++) {
+        entry &e = m_entries[i];
+        const cosmodon::matrix &m = e.object->get_matrix();
+        cosmodon::bounds local = e.mesh->get_bounds();
+        e.inverse = m.inverse();
+        if (local.is_empty()) {
+            continue;
+        }
+        for (uint8_t j = 0; j < 8; j++) {
+            cosmodon::vertex corner(
+                (j & 1) ? local.get_high().x : local.get_low().x,
+                (j & 2) ? local.get_high().y : local.get_low().y,
+                (j & 4) ? local.get_high().z : local.get_low().z,
+                1
+            );
+            boxes[i].expand(m * corner);
+        }
+    }
+    m_tree.build(boxes);
+}
+
+// Intersect a ray.
+bool cosmodon::scene::intersect(const cosmodon::ray &r, cosmodon::bvh::hit &result) const
+{
+    cosmodon::number distance = result.distance;
+    intersect(&r, &result, 1);
+    return result.distance < distance;
+}
+
+// Intersect many rays.
+void cosmodon::scene::intersect(const cosmodon::ray *rays, cosmodon::bvh::hit *results, uint32_t count, cosmodon::pool *threads) const
+{
+    typedef cosmodon::simd::float4 float4;
+
+    // Trace packets of four rays through model bounds, then through each model entered.
+    auto trace = [&](uint32_t first, uint32_t last) {
+        cosmodon::bvh::packet world, local;
+        for (uint32_t i = first; i < last; i += 4) {
+            world.load(rays + i, std::min<uint32_t>(last - i, 4), results + i);
+            m_tree.traverse(world, [&](const cosmodon::bvh::node &leaf) {
+                for (uint32_t j = leaf.first; j < leaf.first + leaf.count; j++) {
+                    uint32_t index = m_tree.get_item(j);
+                    const cosmodon::matrix &m = m_entries[index].inverse;
+
+                    // Move rays into model space, keeping distances along the ray unchanged.
+                    for (uint8_t k = 0; k < 3; k++) {
+                        local.origin[k] = float4(m[k][0]) * world.origin[0] + float4(m[k][1]) * world.origin[1] +
+                          float4(m[k][2]) * world.origin[2] + float4(m[k][3]);
+                        local.direction[k] = float4(m[k][0]) * world.direction[0] + float4(m[k][1]) * world.direction[1] +
+                          float4(m[k][2]) * world.direction[2];
+                    }
+                    local.distance = world.distance;
+                    local.active = world.active;
+                    local.prepare();
+                    m_entries[index].mesh->intersect(local, results + i, index);
+                    world.distance = local.distance;
+                }
+            });
+        }
+    };
+
+    if (m_entries.empty()) {
+        return;
+    }
+    if (threads == nullptr || count <= rays_per_job) {
+        trace(0, count);
+        return;
+    }
+    uint32_t jobs = (count + rays_per_job - 1) / rays_per_job;
+    threads->run(jobs, [&](uint32_t job, uint8_t) {
+        trace(job * rays_per_job, std::min(count, (job + 1) * rays_per_job));
+    });
+}
@@ -1,11 +1,19 @@
 #include <render/transformation.hpp>
 #include <render/vector.hpp>
 
-// Update result matrix.
+// Constructor.
+cosmodon::transformation::transformation()
+  : m_stale(false),
+    m_dirty(true)
+{
+
+}
+
+// Mark result matrix outdated.
 void cosmodon::transformation::update()
 {
-    //m_result = m_rotation_z * m_rotation_y * m_rotation_x * m_translation * m_scale;
-    m_result = m_scale * m_translation * m_rotation_x * m_rotation_y * m_rotation_z;
+    m_stale = true;
+    m_dirty = true;
 }
 
 // Perform a scaling.
@@ -47,9 +55,26 @@ void cosmodon::transformation::rotate(number x, number y, number z)
 // Returns result matrix.
 const cosmodon::matrix& cosmodon::transformation::get_matrix() const
 {
+    if (m_stale) {
+        //m_result = m_rotation_z * m_rotation_y * m_rotation_x * m_translation * m_scale;
+        m_result = m_scale * m_translation * m_rotation_x * m_rotation_y * m_rotation_z;
+        m_stale = false;
+    }
     return m_result;
 }
 
+// Check for changes.
+bool cosmodon::transformation::is_dirty() const
+{
+    return m_dirty;
+}
+
+// Mark unchanged.
+void cosmodon::transformation::set_clean()
+{
+    m_dirty = false;
+}
+
 // Convert to matrix, outputting the result matrix.
 cosmodon::transformation::operator matrix()
 {
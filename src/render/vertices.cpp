@@ -2,6 +2,7 @@
 
 // Vertices constructor.
 cosmodon::vertices::vertices(cosmodon::primitive primitive)
+  : m_transparent(false)
 {
     set_primitive(primitive);
 }
@@ -16,6 +17,7 @@ cosmodon::vertices::~vertices()
 void cosmodon::vertices::clear()
 {
     resize(0);
+    m_indices.clear();
 }
 
 // Adds a vertex to the collection.
@@ -34,11 +36,31 @@ void cosmodon::vertices::add(const cosmodon::vertex& vert)
 // Adds a set of vertices to the collection.
 void cosmodon::vertices::add(const cosmodon::vertices& verts)
 {
-    for (uint32_t i = 0; i < verts.size(); i++) {
-        add(verts[i] * verts.m_result);
+    uint32_t base = size();
+
+    // Keep indices, offset past existing vertices.
+    if (is_indexed() || (size() == 0 && verts.is_indexed())) {
+        for (uint32_t i = 0; i < verts.size(); i++) {
+            add(verts[i] * verts.get_matrix());
+        }
+        for (uint32_t i = 0; i < verts.get_drawn_count(); i++) {
+            add_index(base + (verts.is_indexed() ? verts.m_indices[i] : i));
+        }
+        return;
+    }
+
+    // Unindexed collections take vertices in drawing order.
+    for (uint32_t i = 0; i < verts.get_drawn_count(); i++) {
+        add(verts.get_drawn(i) * verts.get_matrix());
     }
 }
 
+// Adds an index to the collection.
+void cosmodon::vertices::add_index(uint32_t index)
+{
+    m_indices.push_back(index);
+}
+
 // Retrieves center vertex.
 cosmodon::vector cosmodon::vertices::get_center() const
 {
@@ -58,7 +80,7 @@ cosmodon::vector cosmodon::vertices::get_center() const
     }
 
     // Multiple vertices.
-    for (uint8_t i = 0; i < m_vertices.size(); i++) {
+    for (uint32_t i = 0; i < m_vertices.size(); i++) {
         if (min_x > m_vertices[i].x) {
             min_x = m_vertices[i].x;
         }
@@ -86,6 +108,16 @@ cosmodon::vector cosmodon::vertices::get_center() const
     return result;
 }
 
+// Retrieves local bounds.
+cosmodon::bounds cosmodon::vertices::get_bounds() const
+{
+    cosmodon::bounds result;
+    for (uint32_t i = 0; i < m_vertices.size(); i++) {
+        result.expand(m_vertices[i]);
+    }
+    return result;
+}
+
 // Retrieve the amount of vertices inside this collection.
 uint32_t cosmodon::vertices::size() const
 {
@@ -98,8 +130,80 @@ void cosmodon::vertices::resize(uint32_t amount)
     m_vertices.resize(amount);
 }
 
+// Reserve storage for vertices.
+void cosmodon::vertices::reserve(uint32_t amount)
+{
+    m_vertices.reserve(amount);
+}
+
+// Checks if indexed.
+bool cosmodon::vertices::is_indexed() const
+{
+    return !m_indices.empty();
+}
+
+// Retrieve the amount of indices.
+uint32_t cosmodon::vertices::get_index_count() const
+{
+    return m_indices.size();
+}
+
+// Resize the index count.
+void cosmodon::vertices::resize_indices(uint32_t amount)
+{
+    m_indices.resize(amount);
+}
+
+// Reserve storage for indices.
+void cosmodon::vertices::reserve_indices(uint32_t amount)
+{
+    m_indices.reserve(amount);
+}
+
+// Retrieve raw indices.
+uint32_t* cosmodon::vertices::get_indices()
+{
+    return m_indices.data();
+}
+
+// Retrieve const raw indices.
+const uint32_t* cosmodon::vertices::get_indices() const
+{
+    return m_indices.data();
+}
+
+// Retrieve the amount of vertices drawn.
+uint32_t cosmodon::vertices::get_drawn_count() const
+{
+    return is_indexed() ? m_indices.size() : m_vertices.size();
+}
+
+// Retrieve a vertex in drawing order.
+const cosmodon::vertex& cosmodon::vertices::get_drawn(uint32_t index) const
+{
+    return is_indexed() ? m_vertices[m_indices[index]] : m_vertices[index];
+}
+
 // Sets the primitive of vertices.
 void cosmodon::vertices::set_primitive(cosmodon::primitive primitive)
 {
     m_primitive = primitive;
 }
+
+// Retrieves the primitive of vertices.
+cosmodon::primitive cosmodon::vertices::get_primitive() const
+{
+    return m_primitive;
+}
+
+// Sets transparency.
+void cosmodon::vertices::set_transparent(bool transparent)
+{
+    m_transparent = transparent;
+}
+
+// Checks transparency.
+bool cosmodon::vertices::is_transparent() const
+{
+    return m_transparent;
+}